@@ -13,12 +13,31 @@
 #include "component/playgroupscomponent.h"
 
 #include "../utils/logger.h"
+#include "../utils/metrics.h"
+#include "../utils/shardedmap.h"
 
 #include <boost/bind.hpp>
 #include <iostream>
 
 // Blaze
 namespace Blaze {
+	namespace {
+		metrics::histogram& GetRequestMetric(const Header& header) {
+			static utils::sharded_map<uint32_t, metrics::histogram*> requestMetrics;
+
+			const uint32_t key = (static_cast<uint32_t>(header.component) << 16) | header.command;
+			auto metric = requestMetrics.find(key);
+			if (!metric) {
+				metric = &metrics::registry::get_histogram("blaze_request_duration_seconds", "Time spent handling Blaze requests.", {
+					{ "component", std::to_string(static_cast<uint32_t>(header.component)) },
+					{ "command", std::to_string(header.command) }
+				});
+				requestMetrics.insert_or_assign(key, metric);
+			}
+			return *metric;
+		}
+	}
+
 	// Client
 	Client::Client(boost::asio::io_context& io_service, boost::asio::ssl::context& context) :
 		Network::Client(io_service), mSocket(io_service, context)
@@ -198,11 +217,22 @@ namespace Blaze {
 		TDF::Parse(mReadBuffer, mRequest);
 
 		if (!(header.component == Blaze::Component::UserSessions && header.command == 0x19)) {
-			logger::warn("Component: " + std::to_string(static_cast<int>(header.component)) +
-						 ", Command: " + std::to_string(header.command) +
-						 ", Type: " + std::to_string(message >> 28));
+			LOG_DEBUG("Blaze packet", {
+				{ "component", static_cast<int>(header.component) },
+				{ "command", header.command },
+				{ "type", message >> 28 }
+			});
 		}
 		
+		// Requests of one user never run concurrently, see Game::User::Lock.
+		const auto user = mUser;
+		std::unique_lock<std::recursive_mutex> userLock;
+		if (user) {
+			userLock = user->Lock();
+		}
+
+		metrics::scoped_timer timer(GetRequestMetric(header));
+
 		mCurrentMessageId = header.message_id;
 		switch (header.component) {
 			case Blaze::Component::AssociationLists: Blaze::AssociationComponent::Parse(this, header); break; // 0x19
@@ -215,7 +245,7 @@ namespace Blaze {
 			case Blaze::Component::Rooms:            Blaze::RoomsComponent::Parse(this, header);       break; // 0x15
 			case Blaze::Component::UserSessions:     Blaze::UserSessionComponent::Parse(this, header); break; // 0x7802
 			default:
-				logger::error("Unknown component: " + static_cast<int>(header.component));
+				LOG_ERROR("Unknown component", { { "component", static_cast<int>(header.component) } });
 				break;
 		}
 	}
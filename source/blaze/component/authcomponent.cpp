@@ -4,8 +4,10 @@
 #include "usersessioncomponent.h"
 #include "../client.h"
 #include "../../utils/functions.h"
+#include "../../utils/trace.h"
 #include "../../repository/user.h"
 #include "utils/logger.h"
+#include <openssl/rand.h>
 #include <iostream>
 
 enum class PacketIDAuthCommand : uint16_t
@@ -835,8 +837,25 @@ namespace Blaze {
 	}
 
 	void AuthComponent::GetAuthToken(Client* client, Header header) {
+		const auto& user = client->get_user();
+		if (!user) {
+			header.error_code = 0x000B;
+			client->reply(std::move(header));
+			return;
+		}
+
+		// HTTP requests find their user by this token, so every session needs its own that cannot be guessed.
+		uint64_t random[2];
+		if (RAND_bytes(reinterpret_cast<unsigned char*>(random), sizeof(random)) != 1) {
+			logger::error("Could not generate an auth token");
+			header.error_code = 0x000B;
+			client->reply(std::move(header));
+			return;
+		}
+
 		logger::info("Send auth token");
-		SendAuthToken(client, "ABCDEFGHIJKLMNOPQRSTUVWXYZ");
+		SendAuthToken(client, utils::unsigned_long_long_to_hex_string(user->get_id()) +
+			utils::unsigned_long_long_to_hex_string(random[0]) + utils::unsigned_long_long_to_hex_string(random[1]));
 	}
 
 	void AuthComponent::Login(Client* client, Header header) {
@@ -845,8 +864,11 @@ namespace Blaze {
 		std::string email    = request["MAIL"].GetString();
 		std::string password = request["PASS"].GetString();
 
+		trace::span span(0, trace::track::blaze, "Login", { { "client", client->get_id() } });
+
 		const auto& user = Repository::Users::GetUserByEmail(email, true);
 		if (user && user->get_password() == password) {
+			span.set_id(user->get_trace_id());
 			client->set_user(user);
 			SendLogin(client, std::move(header));
 		} else {
@@ -867,6 +889,7 @@ namespace Blaze {
 			return;
 		}
 
+		trace::span span(user->get_trace_id(), trace::track::blaze, "SilentLogin", { { "client", client->get_id() } });
 		logger::info("Silent Login");
 
 		TDF::Packet packet;
@@ -908,9 +931,11 @@ namespace Blaze {
 	void AuthComponent::LoginPersona(Client* client, Header header) {
 		logger::info("Login persona");
 
+		const auto& user = client->get_user();
+		trace::span span(user ? user->get_trace_id() : 0, trace::track::blaze, "LoginPersona", { { "client", client->get_id() } });
+
 		SendLoginPersona(client, std::move(header));
 
-		const auto& user = client->get_user();
 		if (user) {
 			UserSessionComponent::NotifyUserAdded(client, user->get_id(), user->get_name());
 			UserSessionComponent::NotifyUserUpdated(client, user->get_id());
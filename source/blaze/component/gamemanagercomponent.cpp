@@ -8,6 +8,7 @@
 #include "game/game.h"
 #include "utils/functions.h"
 #include "utils/logger.h"
+#include "utils/trace.h"
 
 #include <iostream>
 
@@ -938,6 +939,9 @@ namespace Blaze {
 	}
 
 	void GameManagerComponent::CreateGame(Client* client, Header header) {
+		const auto& user = client->get_user();
+		trace::span span(user ? user->get_trace_id() : 0, trace::track::blaze, "CreateGame", { { "client", client->get_id() } });
+
 		SendCreateGame(client, 1);
 
 		NotifyGameStateChange(client, 1, GameState::Initializing);
@@ -948,6 +952,10 @@ namespace Blaze {
 		auto& request = client->get_request();
 
 		uint32_t gameId = request["GID"].GetUint();
+
+		const auto& user = client->get_user();
+		trace::span span(user ? user->get_trace_id() : 0, trace::track::blaze, "JoinGame", { { "client", client->get_id() }, { "game", gameId } });
+
 		SendJoinGame(client, gameId);
 
 		UserSessionComponent::NotifyUserAdded(client, 1, "Dalkon");
@@ -990,6 +998,7 @@ namespace Blaze {
 			return;
 		}
 
+		trace::span span(user->get_trace_id(), trace::track::blaze, "FinalizeGameCreation", { { "client", client->get_id() }, { "game", gameInfo->id } });
 		Game::Manager::StartGame(gameInfo->id);
 
 		header.error_code = 0;
@@ -1019,7 +1028,13 @@ namespace Blaze {
 			return;
 		}
 
+		// The game record stays as before, only its server goes back to the pool for the next planet.
+		if (const auto& previousGameInfo = user->get_game_info()) {
+			Game::Manager::ReleaseServer(previousGameInfo->id);
+		}
+
 		auto gameInfo = Game::Manager::CreateGame();
+		gameInfo->traceId = user->get_trace_id();
 		user->set_game_info(gameInfo);
 
 		// Attributes
@@ -1044,6 +1059,21 @@ namespace Blaze {
 			.port = static_cast<uint16_t>(hnetData[1]["PORT"].GetUint())
 		};
 
+		// Hand out a pre-started server if one is idle, the client connects to whatever port we advertise.
+		uint16_t port = Game::Manager::AcquireServer(gameInfo->id);
+		if (port == 0) {
+			// Dynamic dedicated server capacity, "Unable to start planet. Returning to ship."
+			user->set_game_info(nullptr);
+			Game::Manager::RemoveGame(gameInfo->id);
+
+			header.error_code = 0x0132;
+			client->reply(std::move(header));
+			return;
+		}
+
+		gameInfo->internalIP.port = port;
+		gameInfo->externalIP.port = port;
+
 		// Other
 		gameInfo->name = request["GNAM"].GetString();
 		gameInfo->type = request["GTYP"].GetString();
@@ -3,6 +3,7 @@
 #include "redirectorcomponent.h"
 #include "../client.h"
 #include "utils/logger.h"
+#include "utils/trace.h"
 #include <iostream>
 
 /*
@@ -222,6 +223,8 @@ namespace Blaze {
 	}
 
 	void RedirectorComponent::ServerInstanceInfo(Client* client, Header header) {
+		// Nobody is logged in on the redirector connection, so these spans all go to trace 0.
+		trace::span span(0, trace::track::redirector, "ServerInstanceInfo", { { "client", client->get_id() } });
 		SendServerInstanceInfo(client, "127.0.0.1", 10041);
 	}
 }
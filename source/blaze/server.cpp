@@ -5,6 +5,7 @@
 #include <boost/bind.hpp>
 #include <iostream>
 
+#include "../game/startup.h"
 #include "utils/logger.h"
 
 // Blaze
@@ -70,21 +71,24 @@ bhzYZC4FokU2LZWUUDUCQCOdlEVsk42T36t837wE4HCpfw4Zdk1+ZgumkKXJmt+c
 			abort();
 		}
 
-		Client* client = new Client(mIoService, mContext);
-		mAcceptor.async_accept(client->get_socket(),
-			boost::bind(&Server::handle_accept, this, client, boost::asio::placeholders::error));
+		// Bound already, so clients wait in the backlog instead of being refused while we load.
+		Game::Startup::WhenReady([this] { do_accept(); });
 	}
 
 	Server::~Server() {
 
 	}
 
+	void Server::do_accept() {
+		Client* client = new Client(mIoService, mContext);
+		mAcceptor.async_accept(client->get_socket(),
+			boost::bind(&Server::handle_accept, this, client, boost::asio::placeholders::error));
+	}
+
 	void Server::handle_accept(Client* client, const boost::system::error_code& error) {
 		if (!error) {
 			client->start();
-			client = new Client(mIoService, mContext);
-			mAcceptor.async_accept(client->get_socket(),
-				boost::bind(&Server::handle_accept, this, client, boost::asio::placeholders::error));
+			do_accept();
 		} else {
 			std::cout << error.message() << std::endl;
 			delete client;
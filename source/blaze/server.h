@@ -18,6 +18,8 @@ namespace Blaze {
 			void handle_accept(Client* client, const boost::system::error_code& error);
 
 		private:
+			void do_accept();
+
 			static bool verify_callback(bool preverified, boost::asio::ssl::verify_context& context);
 
 		private:
@@ -1,6 +1,7 @@
 
 // Include
 #include "databuffer.h"
+#include <cstring>
 
 // Endianess
 #ifdef _MSC_VER
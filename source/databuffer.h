@@ -4,6 +4,7 @@
 #define _DATA_BUFFER_HEADER
 
 // Include
+#include <cstdint>
 #include <vector>
 #include <algorithm>
 
@@ -120,8 +121,8 @@ class DataBuffer {
 
 	private:
 		std::vector<uint8_t> mBuffer;
-		size_t mSize;
-		size_t mPosition;
+		size_t mSize = 0;
+		size_t mPosition = 0;
 };
 
 #endif
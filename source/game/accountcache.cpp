@@ -0,0 +1,120 @@
+
+// Include
+#include "accountcache.h"
+#include "config.h"
+#include "../utils/functions.h"
+
+// Game
+namespace Game {
+	// AccountCache
+	AccountCache::EntryList AccountCache::sEntries;
+	std::unordered_map<AccountCache::Key, AccountCache::EntryList::iterator, AccountCache::KeyHash> AccountCache::sIndex;
+	size_t AccountCache::sBytes = 0;
+
+	std::mutex AccountCache::sMutex;
+
+	size_t AccountCache::KeyHash::operator()(const Key& key) const {
+		size_t hash = std::hash<std::string>()(key.darksporeVersion);
+		hash ^= std::hash<uint64_t>()(key.userId) + 0x9E3779B97F4A7C15 + (hash << 6) + (hash >> 2);
+		hash ^= std::hash<uint64_t>()(key.version) + 0x9E3779B97F4A7C15 + (hash << 6) + (hash >> 2);
+		hash ^= std::hash<uint32_t>()(key.flags) + 0x9E3779B97F4A7C15 + (hash << 6) + (hash >> 2);
+		return hash;
+	}
+
+	AccountCache::Body AccountCache::Get(const Key& key) {
+		std::lock_guard<std::mutex> lock(sMutex);
+
+		auto it = sIndex.find(key);
+		if (it == sIndex.end()) {
+			return nullptr;
+		}
+
+		sEntries.splice(sEntries.begin(), sEntries, it->second);
+		return it->second->body;
+	}
+
+	std::shared_ptr<const compression::prefix> AccountCache::Document::GetCompressedHead() const {
+		static const size_t minCompressSize = utils::to_number<size_t>(Config::Get(CONFIG_COMPRESSION_MIN_SIZE));
+		if (!stored || xml.size() < minCompressSize) {
+			return nullptr;
+		}
+
+		std::call_once(compressFlag, [this] {
+			auto headEnd = xml.rfind("</");
+			if (headEnd == std::string::npos) {
+				return;
+			}
+
+			auto head = std::make_shared<const compression::prefix>(std::string_view(xml).substr(0, headEnd));
+
+			// Set under the cache lock so the size of the entry is the same when it is added and when it is dropped.
+			std::lock_guard<std::mutex> lock(sMutex);
+			compressedHead = std::move(head);
+
+			auto it = sIndex.find(key);
+			if (it != sIndex.end() && it->second->body.get() == this) {
+				sBytes += compressedHead->compressed_size();
+			}
+		});
+
+		return compressedHead;
+	}
+
+	AccountCache::Body AccountCache::Put(const Key& key, std::string body) {
+		const size_t budget = GetBudget();
+		if (body.size() > budget) {
+			return Make(std::move(body));
+		}
+
+		auto entryBody = std::make_shared<Document>();
+		entryBody->xml = std::move(body);
+		entryBody->key = key;
+		entryBody->stored = true;
+
+		const size_t size = GetSize(*entryBody);
+
+		std::lock_guard<std::mutex> lock(sMutex);
+
+		auto it = sIndex.find(key);
+		if (it != sIndex.end()) {
+			sBytes -= GetSize(*it->second->body);
+			sEntries.erase(it->second);
+			sIndex.erase(it);
+		}
+
+		while (!sEntries.empty() && sBytes + size > budget) {
+			const auto& last = sEntries.back();
+			sBytes -= GetSize(*last.body);
+			sIndex.erase(last.key);
+			sEntries.pop_back();
+		}
+
+		sEntries.push_front({ key, entryBody });
+		sIndex.emplace(key, sEntries.begin());
+		sBytes += size;
+
+		return entryBody;
+	}
+
+	AccountCache::Body AccountCache::Make(std::string body) {
+		auto document = std::make_shared<Document>();
+		document->xml = std::move(body);
+		return document;
+	}
+
+	void AccountCache::Clear() {
+		std::lock_guard<std::mutex> lock(sMutex);
+		sIndex.clear();
+		sEntries.clear();
+		sBytes = 0;
+	}
+
+	size_t AccountCache::GetSize(const Document& document) {
+		return document.xml.size() + (document.compressedHead ? document.compressedHead->compressed_size() : 0);
+	}
+
+	size_t AccountCache::GetBudget() {
+		static const size_t budget = utils::to_number<size_t>(Config::Get(CONFIG_ACCOUNT_CACHE_SIZE));
+		return budget;
+	}
+}
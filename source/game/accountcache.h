@@ -0,0 +1,91 @@
+
+#ifndef _GAME_ACCOUNTCACHE_HEADER
+#define _GAME_ACCOUNTCACHE_HEADER
+
+// Include
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include "../utils/compression.h"
+
+// Game
+namespace Game {
+	// AccountCache, serialized account responses keyed by user version so polling never rebuilds an unchanged user.
+	class AccountCache {
+		public:
+			enum Flags : uint32_t {
+				GetAccount = 1 << 0,
+				Creatures  = 1 << 1,
+				Decks      = 1 << 2,
+				Feed       = 1 << 3,
+				Stats      = 1 << 4
+			};
+
+			struct Key {
+				uint64_t userId = 0;
+				uint64_t version = 0;
+				std::string darksporeVersion;
+				uint32_t flags = 0;
+
+				bool operator==(const Key& other) const = default;
+			};
+
+			class Document {
+				public:
+					std::string xml;
+
+					// xml up to its closing root tag, which is all of it that utils::xml::Splice keeps. Compressed the first
+					// time a client takes it compressed and only for stored documents, one sent once is compressed whole.
+					std::shared_ptr<const compression::prefix> GetCompressedHead() const;
+
+				private:
+					Key key;
+					bool stored = false;
+
+					mutable std::once_flag compressFlag;
+					mutable std::shared_ptr<const compression::prefix> compressedHead;
+
+					friend class AccountCache;
+			};
+
+			using Body = std::shared_ptr<const Document>;
+
+			static Body Get(const Key& key);
+
+			// Stores body unless it alone is over the budget, the least recently used entries are dropped to make room.
+			// The head of a stored body is compressed once, responses then only compress what they splice in.
+			static Body Put(const Key& key, std::string body);
+
+			// Same as Put without storing it.
+			static Body Make(std::string body);
+
+			static void Clear();
+
+		private:
+			struct KeyHash {
+				size_t operator()(const Key& key) const;
+			};
+
+			struct Entry {
+				Key key;
+				Body body;
+			};
+
+			using EntryList = std::list<Entry>;
+
+			static size_t GetBudget();
+			static size_t GetSize(const Document& document);
+
+		private:
+			static EntryList sEntries;
+			static std::unordered_map<Key, EntryList::iterator, KeyHash> sIndex;
+			static size_t sBytes;
+
+			static std::mutex sMutex;
+	};
+}
+
+#endif
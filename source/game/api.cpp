@@ -1,16 +1,20 @@
 
 // Include
 #include "api.h"
+#include "accountcache.h"
+#include "attributes.h"
 #include "config.h"
+#include "game.h"
 #include "leaderboard.h"
 
-#include "../main.h"
 
 #include "../http/session.h"
 #include "../http/router.h"
 #include "../http/uri.h"
 #include "../http/multipart.h"
+#include "../raknet/server.h"
 
+#include "../repository/persistence.h"
 #include "../repository/template.h"
 #include "../repository/user.h"
 #include "../repository/part.h"
@@ -18,10 +22,13 @@
 
 #include "../utils/functions.h"
 #include "../utils/logger.h"
+#include "../utils/metrics.h"
+#include "../utils/trace.h"
 #include "../utils/eawebkit.h"
 
 #include <boost/beast/version.hpp>
 
+#include <charconv>
 #include <iostream>
 #include <filesystem>
 #include <stdlib.h>
@@ -115,6 +122,26 @@ namespace Game {
 </html>
 )";
 
+	namespace {
+		// Longest leaderboard page, also what a client that asks for no count gets.
+		constexpr uint32_t LeaderboardPageSize = 50;
+
+		// Nothing one match reports comes close, it keeps the running totals far from wrapping.
+		constexpr uint64_t MaxMatchValue = 1'000'000'000;
+
+		// A missing parameter reads as fallback. False if it is there but not a plain unsigned number.
+		bool get_number_parameter(const HTTP::URI& uri, const std::string& name, uint64_t& value, uint64_t fallback = 0) {
+			const auto text = uri.parameter(name);
+			if (text.empty()) {
+				value = fallback;
+				return true;
+			}
+
+			const auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+			return error == std::errc() && end == text.data() + text.size();
+		}
+	}
+
 
 	// API
 	API::API() {
@@ -144,9 +171,19 @@ namespace Game {
 		response.body() = std::move(file_data);
 	}
 
-	void API::setup() {
-		const auto& router = Application::GetApp().get_http_server()->get_router();
+	void API::responseWithWebKitFile(HTTP::Session& session, HTTP::Response& response, const std::string& path) {
+		// Pages are filled in by EAWebKit, everything else is a plain file and goes through the asset cache.
+		if (utils::EAWebKit::isTemplate(path)) {
+			response.body() = utils::EAWebKit::loadFile(path);
+		} else if (std::string wholePath = utils::EAWebKit::resolvePath(path); !wholePath.empty()) {
+			response.version() |= 0x1000'0000;
+			response.body() = std::move(wholePath);
+		} else {
+			response.result() = boost::beast::http::status::not_found;
+		}
+	}
 
+	void API::setup(const std::shared_ptr<HTTP::Router>& router) {
 		// Routing
 		router->add("/api", { boost::beast::http::verb::get, boost::beast::http::verb::post }, [](HTTP::Session& session, HTTP::Response& response) {
 			logger::info("Got API route.");
@@ -164,6 +201,13 @@ namespace Game {
 			else if (method == "api.panel.listUsers")     { recap_panel_listUsers(session, response); }
 			else if (method == "api.panel.getUserInfo")   { recap_panel_getUserInfo(session, response); }
 			else if (method == "api.panel.setUserInfo")   { recap_panel_setUserInfo(session, response); }
+			else if (method == "api.panel.setCapture")    { recap_panel_setCapture(session, response); }
+			else if (method == "api.panel.dumpCapture")   { recap_panel_dumpCapture(session, response); }
+			else if (method == "api.panel.createGame")    { recap_panel_createGame(session, response); }
+			else if (method == "api.panel.removeGame")    { recap_panel_removeGame(session, response); }
+			else if (method == "api.panel.listGames")     { recap_panel_listGames(session, response); }
+			else if (method == "api.panel.getCreatureStats") { recap_panel_getCreatureStats(session, response); }
+			else if (method == "api.panel.recordMatch")   { recap_panel_recordMatch(session, response); }
 			else {
 				logger::error("Undefined /recap/api method: " + method);
 				response.result() = boost::beast::http::status::internal_server_error;
@@ -192,14 +236,20 @@ namespace Game {
 			}
 
 			std::string folder = "www/" + Config::Get(CONFIG_DARKSPORE_LAUNCHER_THEMES_PATH) + mActiveTheme + "/";
-			std::string file_data = utils::EAWebKit::loadFile(folder + "index.html");
+
+			std::shared_ptr<const compression::prefix> compressed;
+			std::string file_data = utils::EAWebKit::loadFile(folder + "index.html", &compressed);
 
 			responseWithHtmlContents(response, file_data);
+			response.set_compressed_prefix(std::move(compressed));
 		});
 
 		router->add("/bootstrap/launcher/notes", { boost::beast::http::verb::get, boost::beast::http::verb::post }, [this](HTTP::Session& session, HTTP::Response& response) {
-			std::string file_data = utils::EAWebKit::loadFile("www/" + Config::Get(CONFIG_DARKSPORE_LAUNCHER_NOTES_PATH));			
+			std::shared_ptr<const compression::prefix> compressed;
+			std::string file_data = utils::EAWebKit::loadFile("www/" + Config::Get(CONFIG_DARKSPORE_LAUNCHER_NOTES_PATH), &compressed);
+
 			responseWithHtmlContents(response, file_data);
+			response.set_compressed_prefix(std::move(compressed));
 		});
 
 		router->add("/bootstrap/launcher/([/a-zA-Z0-9\\-_.]*)", { boost::beast::http::verb::get, boost::beast::http::verb::post }, [this](HTTP::Session& session, HTTP::Response& response) {
@@ -208,7 +258,7 @@ namespace Game {
 			std::string name = request.uri.resource().substr(removablePrefix.size());
 
 			std::string path = "www/" + Config::Get(CONFIG_DARKSPORE_LAUNCHER_THEMES_PATH) + mActiveTheme + name;
-			response.body() = utils::EAWebKit::loadFile(path);
+			responseWithWebKitFile(session, response, path);
 		});
 
 
@@ -237,9 +287,8 @@ namespace Game {
 							}
 						}
 					}
-					logger::info(" - " + name + " = " + value);
+					LOG_DEBUG("Cookie parameter", { { "name", name }, { "value", value } });
 				}
-				logger::info("");
 			}
 
 			auto version = request.uri.parameter("version");
@@ -264,6 +313,13 @@ namespace Game {
 				}
 			}
 
+			// Requests of one user never run concurrently, see Game::User::Lock.
+			const auto user = session.get_user();
+			std::unique_lock<std::recursive_mutex> userLock;
+			if (user) {
+				userLock = user->Lock();
+			}
+
 			if (method == "api.account.setNewPlayerStats") {
 				method = "api.account.auth";
 			}
@@ -374,11 +430,11 @@ namespace Game {
 		});
 
 		router->add("/web/sporelabsgame/([/a-zA-Z0-9\\-_.]*)", { boost::beast::http::verb::get, boost::beast::http::verb::post }, [this](HTTP::Session& session, HTTP::Response& response) {
-			response.body() = utils::EAWebKit::loadFile("www/ingame" + session.get_request().uri.resource().substr(18));
+			responseWithWebKitFile(session, response, "www/ingame" + session.get_request().uri.resource().substr(18));
 		});
 
 		router->add("/web/sporelabs/([/a-zA-Z0-9\\-_.]*)", { boost::beast::http::verb::get, boost::beast::http::verb::post }, [this](HTTP::Session& session, HTTP::Response& response) {
-			response.body() = utils::EAWebKit::loadFile("www/ingame" + session.get_request().uri.resource().substr(14));
+			responseWithWebKitFile(session, response, "www/ingame" + session.get_request().uri.resource().substr(14));
 		});
 
 
@@ -405,6 +461,12 @@ namespace Game {
 				response.body() = "";
 			}
 		});
+
+		// Metrics, Prometheus text format
+		router->add("/metrics", boost::beast::http::verb::get, [](HTTP::Session& session, HTTP::Response& response) {
+			response.set(boost::beast::http::field::content_type, "text/plain; version=0.0.4");
+			response.body() = metrics::registry::render();
+		});
 	}
 
 	void API::empty_xml_response(HTTP::Session& session, HTTP::Response& response) {
@@ -483,18 +545,17 @@ namespace Game {
 		utils::json::Set(document, "stat", "ok");
 
 		auto actualPartsSize = Repository::UserParts::ListAll().size();
-		auto parts = Repository::Parts::ListAll();
 		uint64_t index = 1;
-		for (auto& part : parts) {
-			Repository::UserParts::Add(std::make_shared<Game::UserPart>(actualPartsSize + index++, part->rigblock_asset_id, user->get_account().id));
+		for (const auto& part : Repository::Parts::ListAll()) {
+			Repository::UserParts::Add(std::make_shared<Game::UserPart>(actualPartsSize + index++, part.rigblock_asset_id, user->get_account().id));
 		}
 		Repository::UserParts::Save();
 
 		// TODO: Unlocking all creatures from start to test; remove that in the future
-		std::vector<Repository::CreatureTemplatePtr> templates = Repository::CreatureTemplates::ListAll();
+		auto templates = Repository::CreatureTemplates::ListAll();
 		user->get_account().creatureRewards = templates.size();
-		for (auto &templateCreature: templates) {
-			user->UnlockCreature(templateCreature->id);
+		for (const auto& templateCreature : templates) {
+			user->UnlockCreature(templateCreature.id);
 		}
 
 		// TODO: Unlocking everything from start to test; remove that in the future
@@ -533,11 +594,11 @@ namespace Game {
 			squad1.slot = squadSlot;
 			squad1.name = "Slot " + std::to_string(squadSlot);
 			squad1.locked = false;
-			squad1.creatures.Add(templates[templateId]->id);
+			squad1.creatures.Add(templates[templateId].id);
 			user->get_squads().data().push_back(squad1);
 		}
 
-		Repository::Users::SaveUser(user);
+		Repository::Persistence::MarkDirty(user);
 
 		response.set(boost::beast::http::field::content_type, "application/json");
 		response.body() = utils::json::ToString(document);
@@ -619,7 +680,7 @@ namespace Game {
 		}
 		else {
 			user->FromJson(userJson);
-			Repository::Users::SaveUser(user);
+			Repository::Persistence::MarkDirty(user);
 
 			// stat
 			utils::json::Set(document, "stat", "ok");
@@ -629,6 +690,181 @@ namespace Game {
 		response.body() = utils::json::ToString(document);
 	}
 
+	void API::recap_panel_setCapture(HTTP::Session& session, HTTP::Response& response) {
+		auto& request = session.get_request();
+		auto gameId = request.uri.parameteru("game");
+		auto enabled = request.uri.parameterb("enabled");
+
+		rapidjson::Document document = utils::json::NewDocumentObject();
+		if (Game::Manager::SetPacketCapture(gameId, enabled)) {
+			utils::json::Set(document, "stat", "ok");
+		} else {
+			utils::json::Set(document, "stat", "error");
+		}
+
+		response.set(boost::beast::http::field::content_type, "application/json");
+		response.body() = utils::json::ToString(document);
+	}
+
+	void API::recap_panel_dumpCapture(HTTP::Session& session, HTTP::Response& response) {
+		auto& request = session.get_request();
+		auto gameId = request.uri.parameteru("game");
+
+		rapidjson::Document document = utils::json::NewDocumentObject();
+
+		auto path = Game::Manager::DumpPacketCapture(gameId);
+		if (path.empty()) {
+			utils::json::Set(document, "stat", "error");
+		} else {
+			utils::json::Set(document, "stat", "ok");
+			utils::json::Set(document, "path", path);
+		}
+
+		response.set(boost::beast::http::field::content_type, "application/json");
+		response.body() = utils::json::ToString(document);
+	}
+
+	void API::recap_panel_createGame(HTTP::Session& session, HTTP::Response& response) {
+		rapidjson::Document document = utils::json::NewDocumentObject();
+
+		// Games created here only run on pooled servers, they have no Blaze side.
+		auto game = Game::Manager::CreateGame();
+		if (uint16_t port = Game::Manager::AcquireServer(game->id)) {
+			game->internalIP.port = port;
+			game->externalIP.port = port;
+
+			utils::json::Set(document, "stat", "ok");
+			utils::json::Set(document, "id", game->id);
+			utils::json::Set(document, "port", port);
+		} else {
+			Game::Manager::RemoveGame(game->id);
+			utils::json::Set(document, "stat", "error");
+		}
+
+		response.set(boost::beast::http::field::content_type, "application/json");
+		response.body() = utils::json::ToString(document);
+	}
+
+	void API::recap_panel_removeGame(HTTP::Session& session, HTTP::Response& response) {
+		auto& request = session.get_request();
+		auto gameId = static_cast<uint32_t>(request.uri.parameteru("game"));
+
+		rapidjson::Document document = utils::json::NewDocumentObject();
+		if (Game::Manager::GetGame(gameId)) {
+			Game::Manager::RemoveGame(gameId);
+			utils::json::Set(document, "stat", "ok");
+		} else {
+			utils::json::Set(document, "stat", "error");
+		}
+
+		response.set(boost::beast::http::field::content_type, "application/json");
+		response.body() = utils::json::ToString(document);
+	}
+
+	void API::recap_panel_listGames(HTTP::Session& session, HTTP::Response& response) {
+		rapidjson::Document document = utils::json::NewDocumentObject();
+
+		rapidjson::Document::AllocatorType& allocator = document.GetAllocator();
+
+		// stat
+		utils::json::Set(document, "stat", "ok");
+
+		rapidjson::Value value = utils::json::NewArray();
+		for (uint32_t id : Game::Manager::GetActiveGames()) {
+			RakNet::TickStats stats;
+			if (!Game::Manager::GetTickStats(id, stats)) {
+				continue;
+			}
+
+			rapidjson::Value object = utils::json::NewObject();
+			utils::json::Set(object, "id", id, allocator);
+			if (auto game = Game::Manager::GetGame(id)) {
+				utils::json::Set(object, "port", game->externalIP.port, allocator);
+			}
+			utils::json::Set(object, "ticks", stats.ticks, allocator);
+			utils::json::Set(object, "overruns", stats.overruns, allocator);
+			utils::json::Set(object, "maxTickUs", stats.maxMicroseconds, allocator);
+			utils::json::Add(value, object, allocator);
+		}
+		utils::json::Set(document, "games", value);
+
+		response.set(boost::beast::http::field::content_type, "application/json");
+		response.body() = utils::json::ToString(document);
+	}
+
+	void API::recap_panel_getCreatureStats(HTTP::Session& session, HTTP::Response& response) {
+		auto& request = session.get_request();
+		auto mail = request.uri.parameter("mail");
+		auto creatureId = static_cast<uint32_t>(request.uri.parameteru("creature"));
+
+		rapidjson::Document document = utils::json::NewDocumentObject();
+
+		rapidjson::Document::AllocatorType& allocator = document.GetAllocator();
+
+		const auto& user = Repository::Users::GetUserByEmail(mail, false);
+		Creature* creature = user ? user->GetCreatureById(creatureId) : nullptr;
+		if (!creature) {
+			// stat
+			utils::json::Set(document, "stat", "error");
+		}
+		else {
+			auto stats = StatEngine::Get(*creature, user->get_account().id);
+
+			// stat
+			utils::json::Set(document, "stat", "ok");
+			utils::json::Set(document, "maxHealth", stats.maxHealth);
+			utils::json::Set(document, "maxMana", stats.maxMana);
+
+			rapidjson::Value attributes = utils::json::NewArray();
+			for (size_t i = 0; i < Attribute::Count; ++i) {
+				rapidjson::Value value(stats.attributes[i]);
+				utils::json::Add(attributes, value, allocator);
+			}
+			utils::json::Set(document, "attributes", attributes);
+		}
+
+		response.set(boost::beast::http::field::content_type, "application/json");
+		response.body() = utils::json::ToString(document);
+	}
+
+	void API::recap_panel_recordMatch(HTTP::Session& session, HTTP::Response& response) {
+		auto& request = session.get_request();
+		auto mail = request.uri.parameter("mail");
+
+		rapidjson::Document document = utils::json::NewDocumentObject();
+
+		const auto& user = Repository::Users::GetUserByEmail(mail, false);
+		if (user == NULL) {
+			// stat
+			utils::json::Set(document, "stat", "error");
+		}
+		else {
+			MatchResult result;
+			uint64_t vs;
+
+			bool valid = get_number_parameter(request.uri, "xp", result.xp)
+				&& get_number_parameter(request.uri, "kills", result.kills)
+				&& get_number_parameter(request.uri, "deaths", result.deaths)
+				&& get_number_parameter(request.uri, "damage", result.damage)
+				&& get_number_parameter(request.uri, "healing", result.healing)
+				&& get_number_parameter(request.uri, "vs", vs);
+
+			for (uint64_t value : { result.xp, result.kills, result.deaths, result.damage, result.healing }) {
+				valid = valid && value <= MaxMatchValue;
+			}
+
+			if (valid) {
+				Leaderboards::Get(vs == 1).RecordMatch(user->get_id(), user->get_name(), result);
+			}
+
+			// stat
+			utils::json::Set(document, "stat", valid ? "ok" : "error");
+		}
+
+		response.set(boost::beast::http::field::content_type, "application/json");
+		response.body() = utils::json::ToString(document);
+	}
+
 	void API::bootstrap_config_getConfig(HTTP::Session& session, HTTP::Response& response) {
 		auto& request = session.get_request();
 		
@@ -761,16 +997,18 @@ namespace Game {
 
 		auto fullOwnedOnly = filter == "market_status_full-owned";
 		
+		const auto& user = session.get_user();
 		if (auto docResponse = document.append_child("response")) {
-			auto allParts = Repository::UserParts::ListAll();
-
 			if (auto parts = docResponse.append_child("parts")) {
-				for (const auto& part : allParts) {
-					if (fullOwnedOnly) {
-						if (part->equipped_to_creature_id == 0) part->WriteXml(parts, true);
-					}
-					else {
-						part->WriteXml(parts, true);
+				if (user) {
+					auto userParts = Repository::UserParts::ListByUser(user->get_account().id);
+					for (const auto& part : *userParts) {
+						if (fullOwnedOnly) {
+							if (part->equipped_to_creature_id == 0) part->WriteXml(parts, true);
+						}
+						else {
+							part->WriteXml(parts, true);
+						}
 					}
 				}
 			}
@@ -785,14 +1023,17 @@ namespace Game {
 	void API::game_inventory_getPartOfferList(HTTP::Session& session, HTTP::Response& response) {
 		pugi::xml_document document;
 
+		const auto& user = session.get_user();
 		if (auto docResponse = document.append_child("response")) {
-			auto allParts = Repository::UserParts::ListAll();
 			auto timestamp = utils::get_unix_time();
 
 			utils::xml::Set(docResponse, "expires", timestamp + (3 * 60 * 60 * 1000));
 			if (auto parts = docResponse.append_child("parts")) {
-				for (const auto& part : allParts) {
-					if (part->equipped_to_creature_id == 0) part->WriteXml(parts, true);
+				if (user) {
+					auto userParts = Repository::UserParts::ListByUser(user->get_account().id);
+					for (const auto& part : *userParts) {
+						if (part->equipped_to_creature_id == 0) part->WriteXml(parts, true);
+					}
 				}
 			}
 
@@ -823,6 +1064,7 @@ namespace Game {
 				else if (type == 'f') { // turn item into detail/flair
 					auto part = Repository::UserParts::getById(index);
 					part->flair = true;
+					Repository::UserParts::Update(part);
 				}
 				else if (type == 'w'){ // buy weapon
 					// TODO: Implement buying weapon
@@ -833,16 +1075,16 @@ namespace Game {
 				}
 			}
 			Repository::UserParts::Save();
-			Repository::Users::SaveUser(user);
+			Repository::Persistence::MarkDirty(user);
 		}
 
 		if (auto docResponse = document.append_child("response")) {
-			auto allParts = Repository::UserParts::ListAll();
-			auto timestamp = utils::get_unix_time();
-			
 			if (auto parts = docResponse.append_child("parts")) {
-				for (const auto& part : allParts) {
-					if (part->equipped_to_creature_id == 0) part->WriteXml(parts, true);
+				if (user) {
+					auto userParts = Repository::UserParts::ListByUser(user->get_account().id);
+					for (const auto& part : *userParts) {
+						if (part->equipped_to_creature_id == 0) part->WriteXml(parts, true);
+					}
 				}
 			}
 
@@ -868,6 +1110,7 @@ namespace Game {
 				auto part = Repository::UserParts::getById(partId);
 				if (part != nullptr) {
 					part->SetStatus(status);
+					Repository::UserParts::Update(part);
 				}
 			}
 			Repository::UserParts::Save();
@@ -885,35 +1128,32 @@ namespace Game {
 	void API::game_leaderboard_getLeaderboard(HTTP::Session& session, HTTP::Response& response) {
 		auto& request = session.get_request();
 
-		const auto& name    = request.uri.parameter("name");
-		const auto& start   = request.uri.parameteru("start");
-		const auto& count   = request.uri.parameteru("count");
-		//const auto& varient = request.uri.parameter("varient"); // eg.: "friends"
-		//const auto& vs      = request.uri.parameteru("vs");     // eg.: "1"
+		const auto& name = request.uri.parameter("name");
+
+		uint64_t start, count, vs;
+		if (!get_number_parameter(request.uri, "start", start) || start > std::numeric_limits<uint32_t>::max()) {
+			start = 0;
+		}
+		if (!get_number_parameter(request.uri, "count", count, LeaderboardPageSize) || count == 0) {
+			count = LeaderboardPageSize;
+		}
+		if (!get_number_parameter(request.uri, "vs", vs)) { // eg.: "1"
+			vs = 0;
+		}
+		count = std::min<uint64_t>(count, LeaderboardPageSize);
 
 		pugi::xml_document document;
 
 		auto docResponse = document.append_child("response");
 		if (auto leaderboard = docResponse.append_child("leaderboard")) {
-
-			if (0 == 0) {
-				// TODO: Get real players list
-				const auto& user = session.get_user();
-				std::vector<LeaderboardPlayerXp> playersList;
-				decltype(auto) userPlayer = playersList.emplace_back();
-				userPlayer.id = user->get_id();
-				userPlayer.name = user->get_name();
-				userPlayer.rank = 0;
-				userPlayer.xp = 0;
-				userPlayer.totalKills = 0;
-				userPlayer.deaths = 0;
-				userPlayer.killDeathRatio = 0;
-				userPlayer.damageMax = 0;
-				userPlayer.healingMax = 0;
-
+			const auto& user = session.get_user();
+			if (user) {
+				const auto stat = GetLeaderboardStat(name);
+				const auto& board = Leaderboards::Get(vs == 1);
+				const auto playersList = board.GetPage(stat, static_cast<uint32_t>(start), static_cast<uint32_t>(count));
 
 				utils::xml::Set(leaderboard, "count", playersList.size());
-				utils::xml::Set(leaderboard, "name", "xp");
+				utils::xml::Set(leaderboard, "name", std::string(GetLeaderboardStatName(stat)));
 
 				if (auto leaderboardStats = leaderboard.append_child("stats")) {
 					utils::xml::Set(leaderboardStats, "stat", "xp");
@@ -964,6 +1204,13 @@ namespace Game {
 		}
 
 		const auto& user = session.get_user();
+		trace::span span(user ? user->get_trace_id() : 0, trace::track::http, "api.account.auth");
+
+		// Only found by key here, so the router could not lock it.
+		std::unique_lock<std::recursive_mutex> userLock;
+		if (user) {
+			userLock = user->Lock();
+		}
 
 		/*
 			timestamp
@@ -1034,53 +1281,84 @@ namespace Game {
 				itemstore_cost_multiplier_epicunique
 		*/
 
-		pugi::xml_document document;
-		if (auto docResponse = document.append_child("response")) {
-			// Write "account" data
-			if (user) {
-				auto& account = user->get_account();
-
-				auto newPlayerProgress = request.uri.parameteru("new_player_progress");
-				if (newPlayerProgress != std::numeric_limits<uint64_t>::max()) {
-					account.newPlayerProgress = newPlayerProgress;
-				}
+		bool include_creatures = request.uri.parameter("include_creatures") == "true";
+		bool include_decks = request.uri.parameter("include_decks") == "true";
+		bool include_feed = request.uri.parameter("include_feed") == "true";
+		if (user) {
+			auto& account = user->get_account();
 
-				account.WriteXml(docResponse);
-			}
-			else {
-				Game::Account account;
-				account.WriteXml(docResponse);
+			auto newPlayerProgress = request.uri.parameteru("new_player_progress");
+			if (newPlayerProgress != std::numeric_limits<uint64_t>::max() && account.newPlayerProgress != newPlayerProgress) {
+				account.newPlayerProgress = newPlayerProgress;
+				user->Touch();
 			}
+		}
+
+		// Account, creatures, decks and feed only change with the user, so they are served from the cache.
+		AccountCache::Body head;
+		AccountCache::Key cacheKey;
+		if (user) {
+			cacheKey.userId = user->get_id();
+			cacheKey.version = user->get_version();
+			cacheKey.darksporeVersion = session.get_darkspore_version();
+			cacheKey.flags = (include_creatures ? AccountCache::Creatures : 0)
+				| (include_decks ? AccountCache::Decks : 0)
+				| (include_feed ? AccountCache::Feed : 0);
+
+			head = AccountCache::Get(cacheKey);
+		}
 
-			// Other
-			pugi::xml_node creatures;
-			if (request.uri.parameter("include_creatures") == "true") {
+		if (!head) {
+			pugi::xml_document document;
+			if (auto docResponse = document.append_child("response")) {
+				// Write "account" data
 				if (user) {
-					user->get_creatures().WriteXml(docResponse);
+					user->get_account().WriteXml(docResponse);
 				}
 				else {
-					docResponse.append_child("creatures");
+					Game::Account account;
+					account.WriteXml(docResponse);
 				}
-			}
 
-			if (request.uri.parameter("include_decks") == "true") {
-				if (user) {
-					user->get_squads().WriteXml(docResponse);
-				}
-				else {
-					docResponse.append_child("decks");
+				// Other
+				if (include_creatures) {
+					if (user) {
+						user->get_creatures().WriteXml(docResponse);
+					}
+					else {
+						docResponse.append_child("creatures");
+					}
 				}
-			}
 
-			if (request.uri.parameter("include_feed") == "true") {
-				if (user) {
-					user->get_feed().WriteXml(docResponse);
+				if (include_decks) {
+					if (user) {
+						user->get_squads().WriteXml(docResponse);
+					}
+					else {
+						docResponse.append_child("decks");
+					}
 				}
-				else {
-					docResponse.append_child("feed");
+
+				if (include_feed) {
+					if (user) {
+						user->get_feed().WriteXml(docResponse);
+					}
+					else {
+						docResponse.append_child("feed");
+					}
 				}
 			}
 
+			if (user) {
+				head = AccountCache::Put(cacheKey, utils::xml::ToString(document));
+			}
+			else {
+				head = AccountCache::Make(utils::xml::ToString(document));
+			}
+		}
+
+		pugi::xml_document document;
+		if (auto docResponse = document.append_child("response")) {
 			if (request.uri.parameter("include_server_tuning") == "true") {
 				if (auto server_tuning = docResponse.append_child("server_tuning")) {
 					auto timestamp = utils::get_unix_time();
@@ -1097,7 +1375,7 @@ namespace Game {
 			}
 
 			if (request.uri.parameter("include_settings") == "true") {
-				utils::xml::Set(docResponse, "settings", user->get_account().settings);
+				utils::xml::Set(docResponse, "settings", user ? user->get_account().settings : std::string());
 			}
 
 			if (request.uri.parameter("cookie") == "true") {
@@ -1115,7 +1393,8 @@ namespace Game {
 		}
 
 		response.set(boost::beast::http::field::content_type, "text/xml");
-		response.body() = utils::xml::ToString(document);
+		response.body() = utils::xml::Splice(head->xml, utils::xml::ToString(document));
+		response.set_compressed_prefix([head] { return head->GetCompressedHead(); });
 	}
 
 	void API::game_account_getAccount(HTTP::Session& session, HTTP::Response& response) {
@@ -1123,39 +1402,68 @@ namespace Game {
 
 		const auto& user = session.get_user();
 
-		pugi::xml_document document;
-		if (auto docResponse = document.append_child("response")) {
-			bool include_creatures = request.uri.parameter("include_creatures") == "true";
-			bool include_decks = request.uri.parameter("include_decks") == "true";
-			bool include_feed = request.uri.parameter("include_feed") == "true";
-			bool include_stats = request.uri.parameter("include_stats") == "true";
-			if (user) {
-				user->get_account().WriteXml(docResponse);
-
-				if (include_creatures) { user->get_creatures().WriteXml(docResponse); }
-				if (include_decks) { user->get_squads().WriteXml(docResponse); }
-				if (include_feed) { user->get_feed().WriteXml(docResponse); }
-				if (include_stats) {
-					auto stats = docResponse.append_child("stats");
-					auto stat = stats.append_child("stat");
-					utils::xml::Set(stat, "wins", 0);
+		bool include_creatures = request.uri.parameter("include_creatures") == "true";
+		bool include_decks = request.uri.parameter("include_decks") == "true";
+		bool include_feed = request.uri.parameter("include_feed") == "true";
+		bool include_stats = request.uri.parameter("include_stats") == "true";
+
+		AccountCache::Body head;
+		AccountCache::Key key;
+		if (user) {
+			key.userId = user->get_id();
+			key.version = user->get_version();
+			key.darksporeVersion = session.get_darkspore_version();
+			key.flags = AccountCache::GetAccount
+				| (include_creatures ? AccountCache::Creatures : 0)
+				| (include_decks ? AccountCache::Decks : 0)
+				| (include_feed ? AccountCache::Feed : 0)
+				| (include_stats ? AccountCache::Stats : 0);
+
+			head = AccountCache::Get(key);
+		}
+
+		if (!head) {
+			pugi::xml_document document;
+			if (auto docResponse = document.append_child("response")) {
+				if (user) {
+					user->get_account().WriteXml(docResponse);
+
+					if (include_creatures) { user->get_creatures().WriteXml(docResponse); }
+					if (include_decks) { user->get_squads().WriteXml(docResponse); }
+					if (include_feed) { user->get_feed().WriteXml(docResponse); }
+					if (include_stats) {
+						auto stats = docResponse.append_child("stats");
+						auto stat = stats.append_child("stat");
+						utils::xml::Set(stat, "wins", 0);
+					}
+				}
+				else {
+					Game::Account account;
+					account.WriteXml(docResponse);
+
+					if (include_creatures) { docResponse.append_child("creatures"); }
+					if (include_decks) { docResponse.append_child("decks"); }
+					if (include_feed) { docResponse.append_child("feed"); }
+					if (include_stats) { docResponse.append_child("stats"); }
 				}
 			}
-			else {
-				Game::Account account;
-				account.WriteXml(docResponse);
 
-				if (include_creatures) { docResponse.append_child("creatures"); }
-				if (include_decks) { docResponse.append_child("decks"); }
-				if (include_feed) { docResponse.append_child("feed"); }
-				if (include_stats) { docResponse.append_child("stats"); }
+			if (user) {
+				head = AccountCache::Put(key, utils::xml::ToString(document));
 			}
+			else {
+				head = AccountCache::Make(utils::xml::ToString(document));
+			}
+		}
 
+		pugi::xml_document document;
+		if (auto docResponse = document.append_child("response")) {
 			add_common_keys(docResponse, session.get_darkspore_version());
 		}
 
 		response.set(boost::beast::http::field::content_type, "text/xml");
-		response.body() = utils::xml::ToString(document);
+		response.body() = utils::xml::Splice(head->xml, utils::xml::ToString(document));
+		response.set_compressed_prefix([head] { return head->GetCompressedHead(); });
 	}
 
 	void API::game_account_logout(HTTP::Session& session, HTTP::Response& response) {
@@ -1184,7 +1492,7 @@ namespace Game {
 		const auto& user = session.get_user();
 		if (user) {
 			user->get_account().settings = request.uri.parameter("settings");
-			Repository::Users::SaveUser(user);
+			Repository::Persistence::MarkDirty(user);
 		}
 
 		pugi::xml_document document;
@@ -1226,7 +1534,7 @@ namespace Game {
 				}
 			}
 			user->get_squads().setData(squads);
-			Repository::Users::SaveUser(user);
+			Repository::Persistence::MarkDirty(user);
 		}
 		else {
 			logger::error("game.deck.updateDecks: User not found");
@@ -1333,16 +1641,18 @@ namespace Game {
 
 				auto partIds = utils::explode_string(request.uri.parameter("parts"), ",");
 				for (const auto& partId : partIds) {
-					Repository::UserParts::getById(std::stoi(partId))->equipped_to_creature_id = creatureId;
+					auto part = Repository::UserParts::getById(std::stoi(partId));
+					part->equipped_to_creature_id = creatureId;
+					Repository::UserParts::Update(part);
 				}
 				if (!partIds.empty()) Repository::UserParts::Save();
 
 				creature->itemPoints = request.uri.parameterd("points");
-				creature->stats = request.uri.parameter("stats");
-				creature->statsAbilityKeyvalues = request.uri.parameter("stats_ability_keyvalues");
+				creature->stats.Parse(request.uri.parameter("stats"));
+				creature->statsAbilityKeyvalues.Parse(request.uri.parameter("stats_ability_keyvalues"));
 				// thumb 
 				// thumb_crc 
-				Repository::Users::SaveUser(user);
+				Repository::Persistence::MarkDirty(user);
 			}
 		}
 		
@@ -1363,7 +1673,7 @@ namespace Game {
 		const auto& user = session.get_user();
 		if (user) {
 			user->UnlockCreature(templateId);
-			Repository::Users::SaveUser(user);
+			Repository::Persistence::MarkDirty(user);
 
 			creatureId = user->GetCreatureByTemplateId(templateId)->id;
 		}
@@ -5,9 +5,11 @@
 // Include
 #include <rapidjson/document.h>
 #include <pugixml.hpp>
+#include <memory>
 
 // HTTP
 namespace HTTP {
+	class Router;
 	class Session;
 	class URI;
 	class Response;
@@ -20,7 +22,7 @@ namespace Game {
 		public:
 			API();
 
-			void setup();
+			void setup(const std::shared_ptr<HTTP::Router>& router);
 
 			// default
 			void empty_xml_response(HTTP::Session& session, HTTP::Response& response);
@@ -36,6 +38,13 @@ namespace Game {
 			void recap_panel_listUsers(HTTP::Session& session, HTTP::Response& response);
 			void recap_panel_getUserInfo(HTTP::Session& session, HTTP::Response& response);
 			void recap_panel_setUserInfo(HTTP::Session& session, HTTP::Response& response);
+			void recap_panel_setCapture(HTTP::Session& session, HTTP::Response& response);
+			void recap_panel_dumpCapture(HTTP::Session& session, HTTP::Response& response);
+			void recap_panel_createGame(HTTP::Session& session, HTTP::Response& response);
+			void recap_panel_removeGame(HTTP::Session& session, HTTP::Response& response);
+			void recap_panel_listGames(HTTP::Session& session, HTTP::Response& response);
+			void recap_panel_getCreatureStats(HTTP::Session& session, HTTP::Response& response);
+			void recap_panel_recordMatch(HTTP::Session& session, HTTP::Response& response);
 
 			// bootstrap
 			void bootstrap_config_getConfig(HTTP::Session& session, HTTP::Response& response);
@@ -76,6 +85,7 @@ namespace Game {
 			void responseWithFileInStorage(HTTP::Session& session, HTTP::Response& response, std::string path);
 			void responseWithFileInStorageAtPath(HTTP::Session& session, HTTP::Response& response, std::string path);
 			void responseWithHtmlContents(HTTP::Response& response, std::string_view file_data);
+			void responseWithWebKitFile(HTTP::Session& session, HTTP::Response& response, const std::string& path);
 			void alertsResponse(HTTP::Session& session, HTTP::Response& response);
 
 			void add_broadcasts(pugi::xml_node& node);
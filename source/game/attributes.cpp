@@ -0,0 +1,247 @@
+
+// Include
+#include "attributes.h"
+#include "creature.h"
+#include "part.h"
+#include "template.h"
+#include "../repository/part.h"
+#include "../repository/template.h"
+#include "../repository/userpart.h"
+#include <algorithm>
+
+// Game
+namespace Game {
+	namespace {
+		constexpr uint32_t NoAttribute = Attribute::Count;
+
+		constexpr std::array<uint32_t, static_cast<size_t>(StatId::Count)> StatAttributes {
+			Attribute::Strength,
+			Attribute::Dexterity,
+			Attribute::Mind,
+			Attribute::MaxHealth,
+			Attribute::MaxMana,
+			Attribute::PhysicalDefense,
+			Attribute::EnergyDefense,
+			Attribute::CriticalRating,
+			Attribute::MovementSpeedBuff
+		};
+
+		enum class CrystalKind : uint8_t {
+			Flat,
+			Percent,
+			Flag
+		};
+
+		struct CrystalEffect {
+			uint32_t attribute = NoAttribute;
+			float value = 0;
+			CrystalKind kind = CrystalKind::Flat;
+		};
+
+		// Per common crystal, rare and epic ones give 1.5x and 2x, prismatic ones another 1.25x.
+		constexpr std::array<CrystalEffect, Crystal::Count> CrystalEffects {{
+			{ Attribute::AoeDamage, 0.05f },                                     // AoEDamage
+			{ Attribute::AttackSpeedScale, 0.05f },                              // AttackSpeed
+			{ Attribute::BuffDuration, 0.1f },                                   // BuffDuration
+			{ Attribute::CrowdControlDurationDecrease, 0.1f },                   // CCReduction
+			{ Attribute::CooldownScale, -0.05f },                                // Cooldown
+			{ Attribute::CriticalRating, 0.1f, CrystalKind::Percent },           // Crit
+			{ Attribute::DamageBuff, 0.05f },                                    // Damage
+			{},                                                                  // DamageAura
+			{ Attribute::DebuffDuration, -0.1f },                                // DebuffDuration
+			{ Attribute::DebuffDurationIncrease, 0.1f },                         // DebuffIncrease
+			{ Attribute::PhysicalDefense, 0.1f, CrystalKind::Percent },          // DefenseRating
+			{ Attribute::EnergyDefense, 0.1f, CrystalKind::Percent },            // DeflectionRating
+			{ Attribute::Dexterity, 0.1f, CrystalKind::Percent },                // Dexterity
+			{},                                                                  // DodgeRating
+			{ Attribute::MaxHealth, 0.1f, CrystalKind::Percent },                // Health
+			{ Attribute::ImmuneToPoisonOrDisease, 1.f, CrystalKind::Flag },      // ImmunePoison
+			{ Attribute::ImmuneToSleep, 1.f, CrystalKind::Flag },                // ImmuneSleep
+			{ Attribute::ImmuneToSlow, 1.f, CrystalKind::Flag },                 // ImmuneSlow
+			{ Attribute::ImmuneToStunned, 1.f, CrystalKind::Flag },              // ImmuneStun
+			{ Attribute::ImmuneToKnockback, 1.f, CrystalKind::Flag },            // Knockback
+			{ Attribute::LifeSteal, 0.02f },                                     // LifeLeech
+			{ Attribute::MaxMana, 0.1f, CrystalKind::Percent },                  // Mana
+			{},                                                                  // ManaCostReduction
+			{ Attribute::ManaSteal, 0.02f },                                     // ManaLeech
+			{ Attribute::Mind, 0.1f, CrystalKind::Percent },                     // Mind
+			{ Attribute::MovementSpeedBuff, 0.05f },                             // MoveSpeed
+			{ Attribute::OrbEffectiveness, 0.1f },                               // OrbEffectiveness
+			{ Attribute::OverdriveBuildup, 0.1f },                               // OverdriveBuildup
+			{ Attribute::PetDamage, 0.1f },                                      // PetDamage
+			{ Attribute::PetHealth, 0.1f },                                      // PetHealth
+			{ Attribute::ProjectileSpeedIncrease, 0.1f },                        // ProjectileSpeed
+			{ Attribute::RangeIncrease, 0.1f },                                  // RangeIncrease
+			{ Attribute::Strength, 0.1f, CrystalKind::Percent },                 // Strength
+			{ Attribute::Surefooted, 1.f, CrystalKind::Flag },                   // Surefooted
+			{}                                                                   // Thorns
+		}};
+
+		// Stat lists carry a base and a bonus column, both count towards the attribute.
+		void AddStats(AttributeVector& attributes, const StatList& stats) {
+			for (const auto& stat : stats) {
+				auto index = static_cast<size_t>(stat.id);
+				if (index < StatAttributes.size()) {
+					attributes[StatAttributes[index]] += stat.get(0) + stat.get(1);
+				}
+			}
+		}
+
+		uint64_t HashCombine(uint64_t hash, uint64_t value) {
+			constexpr uint64_t Prime = 0x100000001B3;
+			for (size_t i = 0; i < sizeof(value); ++i) {
+				hash ^= (value >> (i * 8)) & 0xFF;
+				hash *= Prime;
+			}
+			return hash;
+		}
+
+		constexpr uint64_t HashSeed = 0xCBF29CE484222325;
+	}
+
+	// AttributeVector
+	AttributeVector& AttributeVector::operator+=(const AttributeVector& other) {
+		Add(other);
+		return *this;
+	}
+
+	void AttributeVector::Add(const AttributeVector& flat, float scale) {
+		for (size_t i = 0; i < Size; ++i) {
+			values[i] += flat.values[i] * scale;
+		}
+	}
+
+	void AttributeVector::Scale(const AttributeVector& percent) {
+		for (size_t i = 0; i < Size; ++i) {
+			values[i] *= 1.f + percent.values[i];
+		}
+	}
+
+	// StatEngine
+	std::unordered_map<StatEngine::Key, CreatureStats, StatEngine::KeyHash> StatEngine::sCache;
+	std::mutex StatEngine::sMutex;
+
+	size_t StatEngine::KeyHash::operator()(const Key& key) const {
+		uint64_t hash = HashSeed;
+		hash = HashCombine(hash, key.userId);
+		hash = HashCombine(hash, key.partsHash);
+		hash = HashCombine(hash, key.crystalsHash);
+		hash = HashCombine(hash, (uint64_t(key.creatureId) << 32) | key.nounId);
+		hash = HashCombine(hash, key.version);
+		return static_cast<size_t>(hash);
+	}
+
+	CreatureStats StatEngine::Get(const Creature& creature, uint64_t userId, std::span<const CrystalBonus> crystals) {
+		auto creatureTemplate = Repository::CreatureTemplates::getById(creature.nounId);
+		if (!creatureTemplate) {
+			return {};
+		}
+
+		// Sorted, so the hash does not depend on the order parts were equipped in.
+		std::vector<uint16_t> rigblocks;
+		auto equippedParts = Repository::UserParts::ListByCreature(creature.id);
+		for (const auto& part : *equippedParts) {
+			if (part->user_id == userId) {
+				rigblocks.push_back(part->rigblock_asset_id);
+			}
+		}
+		std::sort(rigblocks.begin(), rigblocks.end());
+
+		Key key {};
+		key.userId = userId;
+		key.creatureId = creature.id;
+		key.nounId = creature.nounId;
+		key.version = creature.version;
+
+		key.partsHash = HashSeed;
+		for (auto rigblock : rigblocks) {
+			key.partsHash = HashCombine(key.partsHash, rigblock);
+		}
+
+		key.crystalsHash = HashSeed;
+		for (const auto& crystal : crystals) {
+			key.crystalsHash = HashCombine(key.crystalsHash, (uint64_t(crystal.type) << 24) | (uint64_t(crystal.level) << 8) | crystal.prismatic);
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(sMutex);
+
+			auto it = sCache.find(key);
+			if (it != sCache.end()) {
+				return it->second;
+			}
+		}
+
+		std::vector<const Part*> parts;
+		parts.reserve(rigblocks.size());
+		for (auto rigblock : rigblocks) {
+			if (auto part = Repository::Parts::getById(rigblock)) {
+				parts.push_back(part);
+			}
+		}
+
+		auto stats = Compute(*creatureTemplate, parts, crystals);
+		{
+			std::lock_guard<std::mutex> lock(sMutex);
+			if (sCache.size() >= MaxCachedEntries) {
+				sCache.clear();
+			}
+			sCache.emplace(key, stats);
+		}
+
+		return stats;
+	}
+
+	CreatureStats StatEngine::Compute(const CreatureTemplate& creatureTemplate, std::span<const Part* const> parts, std::span<const CrystalBonus> crystals) {
+		AttributeVector flat;
+		AddStats(flat, creatureTemplate.statsTemplate);
+
+		flat[Attribute::MinWeaponDamage] += static_cast<float>(creatureTemplate.weaponMinDamage);
+		flat[Attribute::MaxWeaponDamage] += static_cast<float>(creatureTemplate.weaponMaxDamage);
+
+		for (const Part* part : parts) {
+			AddStats(flat, part->stats);
+			AddStats(flat, part->modifiers);
+		}
+
+		AttributeVector percent;
+		for (const auto& crystal : crystals) {
+			if (crystal.type >= Crystal::Count) {
+				continue;
+			}
+
+			const auto& effect = CrystalEffects[crystal.type];
+			if (effect.attribute == NoAttribute) {
+				continue;
+			}
+
+			const float scale = (1.f + 0.5f * std::min<uint16_t>(crystal.level, 2)) * (crystal.prismatic ? 1.25f : 1.f);
+			switch (effect.kind) {
+				case CrystalKind::Flat:
+					flat[effect.attribute] += effect.value * scale;
+					break;
+
+				case CrystalKind::Percent:
+					percent[effect.attribute] += effect.value * scale;
+					break;
+
+				case CrystalKind::Flag:
+					flat[effect.attribute] = effect.value;
+					break;
+			}
+		}
+
+		CreatureStats stats;
+		stats.attributes = flat;
+		stats.attributes.Scale(percent);
+
+		stats.maxHealth = stats.attributes[Attribute::MaxHealth];
+		stats.maxMana = stats.attributes[Attribute::MaxMana];
+		return stats;
+	}
+
+	void StatEngine::Clear() {
+		std::lock_guard<std::mutex> lock(sMutex);
+		sCache.clear();
+	}
+}
@@ -0,0 +1,248 @@
+
+#ifndef _GAME_ATTRIBUTES_HEADER
+#define _GAME_ATTRIBUTES_HEADER
+
+// Include
+#include <cstdint>
+#include <array>
+#include <mutex>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+// Game
+namespace Game {
+	struct Creature;
+	class CreatureTemplate;
+	class Part;
+
+	// Attribute, indices into labsCharacter::mAttribute
+	namespace Attribute {
+		enum : uint32_t {
+			Strength = 0,
+			Dexterity,
+			Mind,
+			MaxHealthIncrease,
+			MaxHealth,
+			MaxMana,
+			DamageReduction,
+			PhysicalDefense,
+			PhysicalDamageReduction,
+			EnergyDefense,
+			CriticalRating,
+			NonCombatSpeed,
+			CombatSpeed,
+			DamageBuff,
+			Silence,
+			Immobilized,
+			DefenseBoostBasicDamage,
+			PhysicalDamageIncrease,
+			PhysicalDamageIncreaseFlat,
+			AutoCrit,
+			BehindDirectDamageIncrease,
+			BehindOrSideDirectDamageIncrease,
+			CriticalDamageIncrease,
+			AttackSpeedScale,
+			CooldownScale,
+			Frozen,
+			ProjectileSpeedIncrease,
+			AoeResistance,
+			EnergyDamageBuff,
+			Intangible,
+			HealingReduction,
+			EnergyDamageIncrease,
+			EnergyDamageIncreaseFlat,
+			Immune,
+			StealthDetection,
+			LifeSteal,
+			RejectModifier,
+			AoeDamage,
+			TechnologyTypeDamage,
+			SpacetimeTypeDamage,
+			LifeTypeDamage,
+			ElementsTypeDamage,
+			SupernaturalTypeDamage,
+			TechnologyTypeResistance,
+			SpacetimeTypeResistance,
+			LifeTypeResistance,
+			ElementsTypeResistance,
+			SupernaturalTypeResistance,
+			MovementSpeedBuff,
+			ImmuneToDebuffs,
+			BuffDuration,
+			DebuffDuration,
+			ManaSteal,
+			DebuffDurationIncrease,
+			EnergyDamageReduction,
+			Incorporeal,
+			DotDamageIncrease,
+			MindControlled,
+			SwapDisabled,
+			ImmuneToRandomTeleport,
+			ImmuneToBanish,
+			ImmuneToKnockback,
+			AoeRadius,
+			PetDamage,
+			PetHealth,
+			CrystalFind,
+			DNADropped,
+			RangeIncrease,
+			OrbEffectiveness,
+			OverdriveBuildup,
+			OverdriveDuration,
+			LootFind,
+			Surefooted,
+			ImmuneToStunned,
+			ImmuneToSleep,
+			ImmuneToTerrified,
+			ImmuneToSilence,
+			ImmuneToCursed,
+			ImmuneToPoisonOrDisease,
+			ImmuneToBurning,
+			ImmuneToRooted,
+			ImmuneToSlow,
+			ImmuneToPull,
+			DotDamageDoneIncrease,
+			AggroIncrease,
+			AggroDecrease,
+			PhysicalDamageDoneIncrease,
+			PhysicalDamageDoneByAbilityIncrease,
+			EnergyDamageDoneIncrease,
+			EnergyDamageDoneByAbilityIncrease,
+			ChannelTimeDecrease,
+			CrowdControlDurationDecrease,
+			DotDurationDecrease,
+			AoeDurationIncrease,
+			HealIncrease,
+			OnLockdown,
+			HoTDoneIncrease,
+			ProjectileDamageIncrease,
+			DeployBonusInvincibilityTime,
+			PhysicalDamageDecreaseFlat,
+			EnergyDamageDecreaseFlat,
+			MinWeaponDamage,
+			MaxWeaponDamage,
+			MinWeaponDamagePercent,
+			MaxWeaponDamagePercent,
+			DirectAttackDamage,
+			DirectAttackDamagePercent,
+			GetHitAnimDisabled,
+			XPBoost,
+			InvisibleToSecurityTeleporters,
+			BodyScale,
+			Count
+		};
+	}
+
+	// Crystal
+	namespace Crystal {
+		enum Type : uint8_t {
+			AoEDamage = 0,
+			AttackSpeed,
+			BuffDuration,
+			CCReduction,
+			Cooldown,
+			Crit,
+			Damage,
+			DamageAura,
+			DebuffDuration,
+			DebuffIncrease,
+			DefenseRating,
+			DeflectionRating,
+			Dexterity,
+			DodgeRating,
+			Health,
+			ImmunePoison,
+			ImmuneSleep,
+			ImmuneSlow,
+			ImmuneStun,
+			Knockback,
+			LifeLeech,
+			Mana,
+			ManaCostReduction,
+			ManaLeech,
+			Mind,
+			MoveSpeed,
+			OrbEffectiveness,
+			OverdriveBuildup,
+			PetDamage,
+			PetHealth,
+			ProjectileSpeed,
+			RangeIncrease,
+			Strength,
+			Surefooted,
+			Thorns,
+			Count
+		};
+	}
+
+	// CrystalBonus
+	struct CrystalBonus {
+		Crystal::Type type = Crystal::AoEDamage;
+		uint16_t level = 0;
+		bool prismatic = false;
+	};
+
+	// AttributeVector, padded to whole 8 float lanes so every pass over it is a straight vectorizable loop.
+	struct alignas(32) AttributeVector {
+		static constexpr size_t Lanes = 8;
+		static constexpr size_t Size = (Attribute::Count + Lanes - 1) / Lanes * Lanes;
+
+		std::array<float, Size> values {};
+
+		float& operator[](size_t index) { return values[index]; }
+		float operator[](size_t index) const { return values[index]; }
+
+		AttributeVector& operator+=(const AttributeVector& other);
+
+		// values[i] += flat[i] * scale
+		void Add(const AttributeVector& flat, float scale = 1.f);
+
+		// values[i] *= 1 + percent[i]
+		void Scale(const AttributeVector& percent);
+	};
+
+	// CreatureStats
+	struct CreatureStats {
+		AttributeVector attributes;
+
+		float maxHealth = 0;
+		float maxMana = 0;
+	};
+
+	// StatEngine
+	class StatEngine {
+		public:
+			// Final stats of a creature owned by userId, using the parts currently equipped to it. Results are cached
+			// by creature version and the equipped parts, so a squad deploy only computes what actually changed.
+			// Reads the repositories, so only call it from the io thread. Game servers use Compute.
+			static CreatureStats Get(const Creature& creature, uint64_t userId, std::span<const CrystalBonus> crystals = {});
+
+			static CreatureStats Compute(const CreatureTemplate& creatureTemplate, std::span<const Part* const> parts, std::span<const CrystalBonus> crystals = {});
+
+			static void Clear();
+
+		private:
+			struct Key {
+				uint64_t userId;
+				uint64_t partsHash;
+				uint64_t crystalsHash;
+				uint32_t creatureId;
+				uint32_t nounId;
+				uint32_t version;
+
+				bool operator==(const Key& other) const = default;
+			};
+
+			struct KeyHash {
+				size_t operator()(const Key& key) const;
+			};
+
+			static constexpr size_t MaxCachedEntries = 4096;
+
+			static std::unordered_map<Key, CreatureStats, KeyHash> sCache;
+			static std::mutex sMutex;
+	};
+}
+
+#endif
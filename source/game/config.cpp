@@ -3,15 +3,21 @@
 #include "config.h"
 #include "utils/logger.h"
 
+#include <algorithm>
+#include <cctype>
 #include <vector>
 #include <iostream>
 #include <pugixml.hpp>
-#include <ShlObj.h>
+
+#ifdef _WIN32
+#	include <ShlObj.h>
+#endif
 
 // Game
 namespace Game {
 	// Config
 	std::array<std::string, CONFIG_END> Config::mConfig;
+	std::atomic<uint64_t> Config::mVersion = 0;
 	
 	void Config::Load(const std::string& path) {
 		const auto get_path_value = [](std::string& value) -> std::string& {
@@ -32,6 +38,21 @@ namespace Game {
 			} else if (name == "DARKSPORE_INDEX_PAGE_PATH")      { mConfig[CONFIG_DARKSPORE_INDEX_PAGE_PATH] = value;
 			} else if (name == "DARKSPORE_LAUNCHER_NOTES_PATH")  { mConfig[CONFIG_DARKSPORE_LAUNCHER_NOTES_PATH] = value;
 			} else if (name == "DARKSPORE_LAUNCHER_THEMES_PATH") { mConfig[CONFIG_DARKSPORE_LAUNCHER_THEMES_PATH] = get_path_value(value);
+			} else if (name == "GAME_SERVER_POOL_SIZE")          { mConfig[CONFIG_GAME_SERVER_POOL_SIZE] = value;
+			} else if (name == "GAME_SERVER_POOL_PORT")          { mConfig[CONFIG_GAME_SERVER_POOL_PORT] = value;
+			} else if (name == "PACKET_CAPTURE")                 { mConfig[CONFIG_PACKET_CAPTURE] = value;
+			} else if (name == "SESSION_RECORDING")              { mConfig[CONFIG_SESSION_RECORDING] = value;
+			} else if (name == "USER_SAVE_INTERVAL")             { mConfig[CONFIG_USER_SAVE_INTERVAL] = value;
+			} else if (name == "ACCOUNT_CACHE_SIZE")             { mConfig[CONFIG_ACCOUNT_CACHE_SIZE] = value;
+			} else if (name == "LOG_LEVEL")                      { mConfig[CONFIG_LOG_LEVEL] = value;
+			} else if (name == "LOG_FILE")                       { mConfig[CONFIG_LOG_FILE] = value;
+			} else if (name == "LOG_FILE_SIZE")                  { mConfig[CONFIG_LOG_FILE_SIZE] = value;
+			} else if (name == "LOG_FILE_COUNT")                 { mConfig[CONFIG_LOG_FILE_COUNT] = value;
+			} else if (name == "TRACE_FILE")                     { mConfig[CONFIG_TRACE_FILE] = value;
+			} else if (name == "STARTUP_THREADS")                { mConfig[CONFIG_STARTUP_THREADS] = value;
+			} else if (name == "PRELOAD_USERS")                  { mConfig[CONFIG_PRELOAD_USERS] = value;
+			} else if (name == "ASSET_CACHE_SIZE")               { mConfig[CONFIG_ASSET_CACHE_SIZE] = value;
+			} else if (name == "COMPRESSION_MIN_SIZE")           { mConfig[CONFIG_COMPRESSION_MIN_SIZE] = value;
 			} else {
 				logger::warn("Game::Config: Unknown config value '" + name + "'");
 			}
@@ -44,6 +65,21 @@ namespace Game {
 		mConfig[CONFIG_DARKSPORE_INDEX_PAGE_PATH] = "index.html";
 		mConfig[CONFIG_DARKSPORE_LAUNCHER_NOTES_PATH] = "bootstrap/launcher/notes.html";
 		mConfig[CONFIG_DARKSPORE_LAUNCHER_THEMES_PATH] = "bootstrap/launcher/";
+		mConfig[CONFIG_GAME_SERVER_POOL_SIZE] = "2";
+		mConfig[CONFIG_GAME_SERVER_POOL_PORT] = "3660";
+		mConfig[CONFIG_PACKET_CAPTURE] = "false";
+		mConfig[CONFIG_SESSION_RECORDING] = "false";
+		mConfig[CONFIG_USER_SAVE_INTERVAL] = "5";
+		mConfig[CONFIG_ACCOUNT_CACHE_SIZE] = "8388608";
+		mConfig[CONFIG_LOG_LEVEL] = "info";
+		mConfig[CONFIG_LOG_FILE] = "";
+		mConfig[CONFIG_LOG_FILE_SIZE] = "10485760";
+		mConfig[CONFIG_LOG_FILE_COUNT] = "5";
+		mConfig[CONFIG_TRACE_FILE] = "";
+		mConfig[CONFIG_STARTUP_THREADS] = "0";
+		mConfig[CONFIG_PRELOAD_USERS] = "0";
+		mConfig[CONFIG_ASSET_CACHE_SIZE] = "33554432";
+		mConfig[CONFIG_COMPRESSION_MIN_SIZE] = "1024";
 
 		pugi::xml_document document;
 		if (auto parse_result = document.load_file(path.c_str())) {
@@ -53,6 +89,7 @@ namespace Game {
 		} else {
 			GenerateDefault(path);
 		}
+		mVersion++;
 	}
 
 	std::string Config::recapVersion() {
@@ -60,6 +97,7 @@ namespace Game {
 	}
 
 	std::string Config::darksporeAppDataFolder() {
+#ifdef _WIN32
 		wchar_t* localAppData = 0;
 		if (SUCCEEDED(SHGetKnownFolderPath(FOLDERID_RoamingAppData, 0, NULL, &localAppData)))
 		{
@@ -68,6 +106,7 @@ namespace Game {
 			localAppDataStr += "\\DarksporeData";
 			return localAppDataStr;
 		}
+#endif
 		return "";
 	}
 
@@ -79,7 +118,7 @@ namespace Game {
 		const auto& str = Get(key);
 		if (str == "1") {
 			return true;
-		} else if (_stricmp(str.c_str(), "true") == 0) {
+		} else if (str.size() == 4 && std::equal(str.begin(), str.end(), "true", [](char lhs, char rhs) { return std::tolower(static_cast<unsigned char>(lhs)) == rhs; })) {
 			return true;
 		} else {
 			return false;
@@ -88,6 +127,11 @@ namespace Game {
 
 	void Config::Set(ConfigValue key, const std::string& value) {
 		mConfig[key] = value;
+		mVersion++;
+	}
+
+	uint64_t Config::GetVersion() {
+		return mVersion.load(std::memory_order_relaxed);
 	}
 
 	void Config::GenerateDefault(const std::string& path) {
@@ -100,6 +144,21 @@ namespace Game {
 				case CONFIG_DARKSPORE_INDEX_PAGE_PATH:      return "DARKSPORE_INDEX_PAGE_PATH";
 				case CONFIG_DARKSPORE_LAUNCHER_NOTES_PATH:  return "DARKSPORE_LAUNCHER_NOTES_PATH";
 				case CONFIG_DARKSPORE_LAUNCHER_THEMES_PATH: return "DARKSPORE_LAUNCHER_THEMES_PATH";
+				case CONFIG_GAME_SERVER_POOL_SIZE:          return "GAME_SERVER_POOL_SIZE";
+				case CONFIG_GAME_SERVER_POOL_PORT:          return "GAME_SERVER_POOL_PORT";
+				case CONFIG_PACKET_CAPTURE:                 return "PACKET_CAPTURE";
+				case CONFIG_SESSION_RECORDING:              return "SESSION_RECORDING";
+				case CONFIG_USER_SAVE_INTERVAL:             return "USER_SAVE_INTERVAL";
+				case CONFIG_ACCOUNT_CACHE_SIZE:             return "ACCOUNT_CACHE_SIZE";
+				case CONFIG_LOG_LEVEL:                      return "LOG_LEVEL";
+				case CONFIG_LOG_FILE:                       return "LOG_FILE";
+				case CONFIG_LOG_FILE_SIZE:                  return "LOG_FILE_SIZE";
+				case CONFIG_LOG_FILE_COUNT:                 return "LOG_FILE_COUNT";
+				case CONFIG_TRACE_FILE:                     return "TRACE_FILE";
+				case CONFIG_STARTUP_THREADS:                return "STARTUP_THREADS";
+				case CONFIG_PRELOAD_USERS:                  return "PRELOAD_USERS";
+				case CONFIG_ASSET_CACHE_SIZE:               return "ASSET_CACHE_SIZE";
+				case CONFIG_COMPRESSION_MIN_SIZE:           return "COMPRESSION_MIN_SIZE";
 				default: return "UNKNOWN";
 			}
 		};
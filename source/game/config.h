@@ -5,6 +5,8 @@
 // Include
 #include <string>
 #include <array>
+#include <atomic>
+#include <cstdint>
 
 // Game
 namespace Game {
@@ -17,6 +19,21 @@ namespace Game {
 		CONFIG_DARKSPORE_INDEX_PAGE_PATH,
 		CONFIG_DARKSPORE_LAUNCHER_NOTES_PATH,
 		CONFIG_DARKSPORE_LAUNCHER_THEMES_PATH,
+		CONFIG_GAME_SERVER_POOL_SIZE,
+		CONFIG_GAME_SERVER_POOL_PORT,
+		CONFIG_PACKET_CAPTURE,
+		CONFIG_SESSION_RECORDING,
+		CONFIG_USER_SAVE_INTERVAL,
+		CONFIG_ACCOUNT_CACHE_SIZE,
+		CONFIG_LOG_LEVEL,
+		CONFIG_LOG_FILE,
+		CONFIG_LOG_FILE_SIZE,
+		CONFIG_LOG_FILE_COUNT,
+		CONFIG_TRACE_FILE,
+		CONFIG_STARTUP_THREADS,
+		CONFIG_PRELOAD_USERS,
+		CONFIG_ASSET_CACHE_SIZE,
+		CONFIG_COMPRESSION_MIN_SIZE,
 		CONFIG_END
 	};
 
@@ -33,11 +50,15 @@ namespace Game {
 			static bool GetBool(ConfigValue key);
 			static void Set(ConfigValue key, const std::string& value);
 
+			// Changes whenever a value does, for caches of anything rendered from the config.
+			static uint64_t GetVersion();
+
 		private:
 			static void GenerateDefault(const std::string& path);
 		
 		private:
 			static std::array<std::string, CONFIG_END> mConfig;
+			static std::atomic<uint64_t> mVersion;
 	};
 }
 
@@ -25,8 +25,8 @@ namespace Game {
 		nounId  = utils::xml::GetString<uint32_t>(node, "noun_id");
 		version = utils::xml::GetString<uint32_t>(node, "version");
 
-		stats = utils::xml::GetString(node, "stats");
-		statsAbilityKeyvalues = utils::xml::GetString(node, "stats_ability_keyvalues");
+		stats.Parse(utils::xml::GetString(node, "stats"));
+		statsAbilityKeyvalues.Parse(utils::xml::GetString(node, "stats_ability_keyvalues"));
 
 		auto partsXml = node.child("parts");
 		for (const auto& partXmlNode : partsXml) {
@@ -55,14 +55,14 @@ namespace Game {
 			utils::xml::Set(creature, "noun_id", nounId);
 			utils::xml::Set(creature, "version", version);
 
-			utils::xml::Set(creature, "stats", stats);
-			utils::xml::Set(creature, "stats_ability_keyvalues", statsAbilityKeyvalues);
+			utils::xml::Set(creature, "stats", stats.ToString());
+			utils::xml::Set(creature, "stats_ability_keyvalues", statsAbilityKeyvalues.ToString());
 
 			// TODO: 
 			//utils::xml::Set(creature, "stats_template_ability", templateCreature->statsTemplateAbilityKeyvalues);
 			//utils::xml::Set(creature, "stats_template_ability_keyvalues", templateCreature->statsTemplateAbilityKeyvalues);
-			utils::xml::Set(creature, "stats_template_ability", statsAbilityKeyvalues);
-			utils::xml::Set(creature, "stats_template_ability_keyvalues", statsAbilityKeyvalues);
+			utils::xml::Set(creature, "stats_template_ability", statsAbilityKeyvalues.ToString());
+			utils::xml::Set(creature, "stats_template_ability_keyvalues", statsAbilityKeyvalues.ToString());
 		}
 	}
 
@@ -97,14 +97,14 @@ namespace Game {
 			utils::xml::Set(creature, "noun_id", nounId);
 			utils::xml::Set(creature, "version", version);
 
-			utils::xml::Set(creature, "stats", stats);
-			utils::xml::Set(creature, "stats_ability_keyvalues", statsAbilityKeyvalues);
+			utils::xml::Set(creature, "stats", stats.ToString());
+			utils::xml::Set(creature, "stats_ability_keyvalues", statsAbilityKeyvalues.ToString());
 			
 			// TODO: 
 			//utils::xml::Set(creature, "stats_template_ability", templateCreature->statsTemplateAbilityKeyvalues);
 			//utils::xml::Set(creature, "stats_template_ability_keyvalues", templateCreature->statsTemplateAbilityKeyvalues);
-			utils::xml::Set(creature, "stats_template_ability", statsAbilityKeyvalues);
-			utils::xml::Set(creature, "stats_template_ability_keyvalues", statsAbilityKeyvalues);
+			utils::xml::Set(creature, "stats_template_ability", statsAbilityKeyvalues.ToString());
+			utils::xml::Set(creature, "stats_template_ability_keyvalues", statsAbilityKeyvalues.ToString());
 			
 			parts.WriteXml(creature, false);
 
@@ -141,8 +141,8 @@ namespace Game {
 		nounId  = utils::json::GetUint(object, "noun_id");
 		version = utils::json::GetUint(object, "version");
 
-		stats                 = utils::json::GetString(object, "stats");
-		statsAbilityKeyvalues = utils::json::GetString(object, "stats_ability_keyvalues");
+		stats.Parse(utils::json::GetString(object, "stats"));
+		statsAbilityKeyvalues.Parse(utils::json::GetString(object, "stats_ability_keyvalues"));
 	}
 
 	rapidjson::Value Creature::WriteJson(rapidjson::Document::AllocatorType& allocator) const { 
@@ -166,8 +166,8 @@ namespace Game {
 		utils::json::Set(object, "noun_id", nounId,  allocator);
 		utils::json::Set(object, "version", version, allocator);
 
-		utils::json::Set(object, "stats",                   stats,                 allocator);
-		utils::json::Set(object, "stats_ability_keyvalues", statsAbilityKeyvalues, allocator);
+		utils::json::Set(object, "stats",                   stats.ToString(),                 allocator);
+		utils::json::Set(object, "stats_ability_keyvalues", statsAbilityKeyvalues.ToString(), allocator);
 		return object;
 	}
 
@@ -1,12 +1,28 @@
 
 // Include
 #include "game.h"
+#include "config.h"
+#include "attributes.h"
 #include "../raknet/server.h"
+#include "../repository/template.h"
+#include "../utils/functions.h"
+#include "../utils/logger.h"
+
+#include <filesystem>
 
 // Game
 namespace Game {
+	namespace {
+		// Clients run their QoS check against this port, no game server may take it.
+		constexpr uint16_t ClientGamePort = 3659;
+	}
+
 	// Manager
 	std::map<uint32_t, std::unique_ptr<RakNet::Server>> Manager::sActiveGames;
+	std::vector<std::unique_ptr<RakNet::Server>> Manager::sServerPool;
+
+	uint16_t Manager::sServerPoolPort = 0;
+	uint16_t Manager::sServerPoolSize = 0;
 
 	std::map<uint32_t, GameInfoPtr> Manager::sGames;
 	std::map<std::string, Matchmaking> Manager::sMatchmaking;
@@ -31,6 +47,7 @@ namespace Game {
 		if (it != sGames.end()) {
 			sGames.erase(it);
 		}
+		ReleaseServer(id);
 	}
 
 	GameInfoPtr Manager::GetGame(uint32_t id) {
@@ -42,8 +59,164 @@ namespace Game {
 		auto it = sActiveGames.find(id);
 		if (it == sActiveGames.end()) {
 			auto game = GetGame(id);
-			if (game) {
-				sActiveGames[id] = std::make_unique<RakNet::Server>(game->externalIP.port, id);
+			if (game && AcquireServer(id) == 0) {
+				logger::error("Could not start a game server for game " + std::to_string(id));
+			}
+
+			it = sActiveGames.find(id);
+			if (game && it != sActiveGames.end()) {
+				it->second->set_trace_id(game->traceId);
+			}
+		}
+	}
+
+	void Manager::CreateServerPool() {
+		// Game servers only know the stat engine through this, so tools can run them without the repositories.
+		// They do not know the deploying user's creature yet, so there are no parts, unlike StatEngine::Get for the panel.
+		RakNet::Server::SetCharacterStatsProvider([](uint32_t templateId, std::span<const CrystalBonus> crystals, CreatureStats& stats) {
+			auto creatureTemplate = Repository::CreatureTemplates::getById(templateId);
+			if (!creatureTemplate) {
+				return false;
+			}
+
+			stats = StatEngine::Compute(*creatureTemplate, {}, crystals);
+			return true;
+		});
+
+		sServerPoolSize = utils::to_number<uint16_t>(Config::Get(CONFIG_GAME_SERVER_POOL_SIZE));
+		sServerPoolPort = utils::to_number<uint16_t>(Config::Get(CONFIG_GAME_SERVER_POOL_PORT));
+		if (sServerPoolSize == 0 || sServerPoolPort == 0) {
+			sServerPoolSize = 0;
+			return;
+		}
+
+		if (ClientGamePort >= sServerPoolPort && ClientGamePort < sServerPoolPort + sServerPoolSize) {
+			logger::warn("GAME_SERVER_POOL_PORT range includes port " + std::to_string(ClientGamePort) + ", starting the pool after it");
+			sServerPoolPort = ClientGamePort + 1;
+		}
+
+		sServerPool.reserve(sServerPoolSize);
+		for (uint16_t i = 0; i < sServerPoolSize; ++i) {
+			sServerPool.push_back(std::make_unique<RakNet::Server>(sServerPoolPort + i));
+		}
+
+		logger::info("Started " + std::to_string(sServerPoolSize) + " pooled game servers on ports " +
+			std::to_string(sServerPoolPort) + "-" + std::to_string(sServerPoolPort + sServerPoolSize - 1));
+	}
+
+	void Manager::DestroyServerPool() {
+		sActiveGames.clear();
+		sServerPool.clear();
+		sServerPoolSize = 0;
+	}
+
+	uint16_t Manager::AcquireServer(uint32_t id) {
+		auto it = sActiveGames.find(id);
+		if (it != sActiveGames.end()) {
+			return it->second->get_port();
+		}
+
+		std::unique_ptr<RakNet::Server> server;
+		if (!sServerPool.empty()) {
+			server = std::move(sServerPool.back());
+			sServerPool.pop_back();
+			server->assign(id);
+		} else {
+			// Pool exhausted (or disabled), start a server of our own on whatever port the OS gives it.
+			server = std::make_unique<RakNet::Server>(0, id);
+			if (server->get_port() == 0) {
+				return 0;
+			}
+		}
+
+		uint16_t port = server->get_port();
+		StartRecording(*server, id);
+
+		sActiveGames[id] = std::move(server);
+		return port;
+	}
+
+	std::vector<uint32_t> Manager::GetActiveGames() {
+		std::vector<uint32_t> ids;
+		ids.reserve(sActiveGames.size());
+		for (const auto& [id, server] : sActiveGames) {
+			ids.push_back(id);
+		}
+		return ids;
+	}
+
+	bool Manager::GetTickStats(uint32_t id, RakNet::TickStats& stats) {
+		auto it = sActiveGames.find(id);
+		if (it == sActiveGames.end()) {
+			return false;
+		}
+
+		stats = it->second->get_tick_stats();
+		return true;
+	}
+
+	void Manager::ReleaseServer(uint32_t id) {
+		auto it = sActiveGames.find(id);
+		if (it == sActiveGames.end()) {
+			return;
+		}
+
+		auto server = std::move(it->second);
+		sActiveGames.erase(it);
+
+		// Only servers on pre-allocated ports go back to the pool, servers started once the pool ran out are stopped.
+		uint16_t port = server->get_port();
+		if (port >= sServerPoolPort && port < sServerPoolPort + sServerPoolSize) {
+			server->stop_recording();
+			server->release();
+			sServerPool.push_back(std::move(server));
+		}
+	}
+
+	void Manager::StartRecording(RakNet::Server& server, uint32_t id) {
+		if (!Config::GetBool(CONFIG_SESSION_RECORDING)) {
+			return;
+		}
+
+		std::error_code error;
+		std::filesystem::create_directories("recordings", error);
+
+		server.start_recording("recordings/game_" + std::to_string(id) + "_" + std::to_string(utils::get_unix_time()) + ".rrec");
+	}
+
+	bool Manager::SetPacketCapture(uint32_t id, bool enabled) {
+		auto it = sActiveGames.find(id);
+		if (it == sActiveGames.end()) {
+			return false;
+		}
+
+		it->second->set_capture(enabled);
+		return true;
+	}
+
+	std::string Manager::DumpPacketCapture(uint32_t id) {
+		auto it = sActiveGames.find(id);
+		if (it == sActiveGames.end()) {
+			return {};
+		}
+
+		std::error_code error;
+		std::filesystem::create_directories("captures", error);
+
+		std::string path = "captures/game_" + std::to_string(id) + "_" + std::to_string(utils::get_unix_time()) + ".rcap";
+		if (!it->second->dump_capture(path)) {
+			logger::error("Could not write packet capture for game " + std::to_string(id));
+			return {};
+		}
+
+		logger::info("Wrote packet capture " + path);
+		return path;
+	}
+
+	void Manager::DumpPacketCaptures() {
+		for (const auto& [id, server] : sActiveGames) {
+			if (server->is_capturing()) {
+				DumpPacketCapture(id);
 			}
 		}
 	}
@@ -6,13 +6,14 @@
 #include "../blaze/types.h"
 
 #include <cstdint>
+#include <limits>
 #include <string>
 #include <vector>
 #include <map>
 #include <memory>
 
 // RakNet
-namespace RakNet { class Server; }
+namespace RakNet { class Server; struct TickStats; }
 
 // Game
 namespace Game {
@@ -38,6 +39,9 @@ namespace Game {
 
 		int64_t clientId = 0;
 
+		// Trace id of the user that created the game.
+		uint64_t traceId = 0;
+
 		IP internalIP;
 		IP externalIP;
 
@@ -88,11 +92,34 @@ namespace Game {
 			static GameInfoPtr GetGame(uint32_t id);
 			static void StartGame(uint32_t id);
 
+			// Server pool
+			static void CreateServerPool();
+			static void DestroyServerPool();
+
+			// Port of the server running game id, starting one if needed. 0 if no server could be started.
+			static uint16_t AcquireServer(uint32_t id);
+			static void ReleaseServer(uint32_t id);
+
+			static std::vector<uint32_t> GetActiveGames();
+			static bool GetTickStats(uint32_t id, RakNet::TickStats& stats);
+
+			// Packet capture
+			static bool SetPacketCapture(uint32_t id, bool enabled);
+			static std::string DumpPacketCapture(uint32_t id);
+			static void DumpPacketCaptures();
+
 			// Matchmaking
 			static Matchmaking& StartMatchmaking();
 
+		private:
+			static void StartRecording(RakNet::Server& server, uint32_t id);
+
 		private:
 			static std::map<uint32_t, std::unique_ptr<RakNet::Server>> sActiveGames;
+			static std::vector<std::unique_ptr<RakNet::Server>> sServerPool;
+
+			static uint16_t sServerPoolPort;
+			static uint16_t sServerPoolSize;
 
 			static std::map<uint32_t, GameInfoPtr> sGames;
 			static std::map<std::string, Matchmaking> sMatchmaking;
@@ -1,5 +1,366 @@
+
 // Include
 #include "leaderboard.h"
+#include "config.h"
+#include "../repository/persistence.h"
+#include "../utils/functions.h"
+#include "../utils/logger.h"
+#include <algorithm>
+#include <sstream>
 
+// Game
 namespace Game {
+	namespace {
+		constexpr std::array<std::string_view, static_cast<size_t>(LeaderboardStat::Count)> LeaderboardStatNames {
+			"xp", "totalKills", "deaths", "killDeathRatio", "damageMax", "healingMax"
+		};
+
+		constexpr std::chrono::seconds SnapshotInterval { 60 };
+
+		std::string GetSnapshotPath() {
+			return Config::Get(CONFIG_STORAGE_PATH) + "leaderboards.xml";
+		}
+	}
+
+	LeaderboardStat GetLeaderboardStat(std::string_view name) {
+		for (size_t i = 0; i < LeaderboardStatNames.size(); ++i) {
+			if (LeaderboardStatNames[i] == name) {
+				return static_cast<LeaderboardStat>(i);
+			}
+		}
+		return LeaderboardStat::Xp;
+	}
+
+	std::string_view GetLeaderboardStatName(LeaderboardStat stat) {
+		auto index = static_cast<size_t>(stat);
+		return index < LeaderboardStatNames.size() ? LeaderboardStatNames[index] : LeaderboardStatNames[0];
+	}
+
+	// RankTree
+	void RankTree::insert(uint64_t score, uint64_t id) {
+		int32_t index;
+		if (!mFreeNodes.empty()) {
+			index = mFreeNodes.back();
+			mFreeNodes.pop_back();
+		} else {
+			index = static_cast<int32_t>(mNodes.size());
+			mNodes.emplace_back();
+		}
+
+		auto& node = mNodes[index];
+		node.score = score;
+		node.id = id;
+		node.priority = mRandom();
+		node.size = 1;
+		node.left = Null;
+		node.right = Null;
+
+		int32_t left, right;
+		split(mRoot, score, id, left, right);
+		mRoot = merge(merge(left, index), right);
+	}
+
+	void RankTree::erase(uint64_t score, uint64_t id) {
+		mRoot = erase(mRoot, score, id);
+	}
+
+	uint32_t RankTree::rank(uint64_t score, uint64_t id) const {
+		uint32_t result = 0;
+
+		int32_t index = mRoot;
+		while (index != Null) {
+			const auto& node = mNodes[index];
+			if (less(score, id, node)) {
+				index = node.left;
+			} else {
+				if (node.score == score && node.id == id) {
+					return result + size(node.left);
+				}
+				result += size(node.left) + 1;
+				index = node.right;
+			}
+		}
+
+		return result;
+	}
+
+	void RankTree::collect(uint32_t start, uint32_t count, std::vector<uint64_t>& ids) const {
+		if (count > 0) {
+			collect(mRoot, start, static_cast<uint32_t>(ids.size()) + count, ids);
+		}
+	}
+
+	void RankTree::update(int32_t index) {
+		auto& node = mNodes[index];
+		node.size = 1 + size(node.left) + size(node.right);
+	}
+
+	void RankTree::split(int32_t index, uint64_t score, uint64_t id, int32_t& left, int32_t& right) {
+		if (index == Null) {
+			left = Null;
+			right = Null;
+			return;
+		}
+
+		auto& node = mNodes[index];
+		if (less(score, id, node)) {
+			split(node.left, score, id, left, node.left);
+			right = index;
+		} else {
+			split(node.right, score, id, node.right, right);
+			left = index;
+		}
+		update(index);
+	}
+
+	int32_t RankTree::merge(int32_t left, int32_t right) {
+		if (left == Null) return right;
+		if (right == Null) return left;
+
+		if (mNodes[left].priority > mNodes[right].priority) {
+			mNodes[left].right = merge(mNodes[left].right, right);
+			update(left);
+			return left;
+		} else {
+			mNodes[right].left = merge(left, mNodes[right].left);
+			update(right);
+			return right;
+		}
+	}
+
+	int32_t RankTree::erase(int32_t index, uint64_t score, uint64_t id) {
+		if (index == Null) {
+			return Null;
+		}
+
+		auto& node = mNodes[index];
+		if (node.score == score && node.id == id) {
+			mFreeNodes.push_back(index);
+			return merge(node.left, node.right);
+		}
+
+		if (less(score, id, node)) {
+			node.left = erase(node.left, score, id);
+		} else {
+			node.right = erase(node.right, score, id);
+		}
+		update(index);
+		return index;
+	}
+
+	void RankTree::collect(int32_t index, uint32_t start, uint32_t count, std::vector<uint64_t>& ids) const {
+		// count is the size ids should end up with. Whole subtrees before start are skipped by size,
+		// so this visits O(log n + count) nodes.
+		if (index == Null || ids.size() >= count) {
+			return;
+		}
+
+		const auto& node = mNodes[index];
+		uint32_t leftSize = size(node.left);
+		if (start < leftSize) {
+			collect(node.left, start, count, ids);
+		}
+
+		if (ids.size() < count && start <= leftSize) {
+			ids.push_back(node.id);
+		}
+
+		if (ids.size() < count) {
+			collect(node.right, start > leftSize ? start - leftSize - 1 : 0, count, ids);
+		}
+	}
+
+	// Leaderboard
+	void Leaderboard::RecordMatch(uint64_t playerId, const std::string& name, const MatchResult& result) {
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+
+			auto [it, inserted] = mPlayers.try_emplace(playerId);
+
+			auto& player = it->second;
+			if (inserted) {
+				player = {};
+				player.id = playerId;
+			} else {
+				Remove(player);
+			}
+
+			player.name = name;
+			player.xp += result.xp;
+			player.totalKills += result.kills;
+			player.deaths += result.deaths;
+			player.damageMax = std::max(player.damageMax, result.damage);
+			player.healingMax = std::max(player.healingMax, result.healing);
+
+			// In hundredths, the stats are integers.
+			player.killDeathRatio = (player.totalKills * 100) / std::max<uint64_t>(player.deaths, 1);
+
+			Insert(player);
+		}
+		Leaderboards::MarkDirty();
+	}
+
+	bool Leaderboard::GetPlayer(LeaderboardStat stat, uint64_t playerId, LeaderboardPlayerXp& player) const {
+		std::lock_guard<std::mutex> lock(mMutex);
+
+		auto it = mPlayers.find(playerId);
+		if (it == mPlayers.end()) {
+			return false;
+		}
+
+		player = it->second;
+		player.rank = mTrees[static_cast<size_t>(stat)].rank(GetValue(player, stat), playerId) + 1;
+		return true;
+	}
+
+	std::vector<LeaderboardPlayerXp> Leaderboard::GetPage(LeaderboardStat stat, uint32_t start, uint32_t count) const {
+		std::lock_guard<std::mutex> lock(mMutex);
+
+		const auto& tree = mTrees[static_cast<size_t>(stat)];
+
+		std::vector<uint64_t> ids;
+		ids.reserve(std::min(count, tree.size()));
+		tree.collect(start, count, ids);
+
+		std::vector<LeaderboardPlayerXp> players;
+		players.reserve(ids.size());
+		for (size_t i = 0; i < ids.size(); ++i) {
+			auto& player = players.emplace_back(mPlayers.at(ids[i]));
+			player.rank = start + static_cast<uint32_t>(i) + 1;
+		}
+
+		return players;
+	}
+
+	uint32_t Leaderboard::size() const {
+		std::lock_guard<std::mutex> lock(mMutex);
+		return mTrees[0].size();
+	}
+
+	void Leaderboard::ReadXml(const pugi::xml_node& node) {
+		std::lock_guard<std::mutex> lock(mMutex);
+		for (const auto& playerNode : node.children("player")) {
+			LeaderboardPlayerXp player {};
+			player.id = utils::xml::GetString<uint64_t>(playerNode, "id");
+			player.name = utils::xml::GetString(playerNode, "name");
+			player.xp = utils::xml::GetString<uint64_t>(playerNode, "xp");
+			player.totalKills = utils::xml::GetString<uint64_t>(playerNode, "totalKills");
+			player.deaths = utils::xml::GetString<uint64_t>(playerNode, "deaths");
+			player.killDeathRatio = utils::xml::GetString<uint64_t>(playerNode, "killDeathRatio");
+			player.damageMax = utils::xml::GetString<uint64_t>(playerNode, "damageMax");
+			player.healingMax = utils::xml::GetString<uint64_t>(playerNode, "healingMax");
+
+			if (mPlayers.emplace(player.id, player).second) {
+				Insert(player);
+			}
+		}
+	}
+
+	void Leaderboard::WriteXml(pugi::xml_node& node) const {
+		std::lock_guard<std::mutex> lock(mMutex);
+		for (const auto& [_, player] : mPlayers) {
+			if (auto playerNode = node.append_child("player")) {
+				utils::xml::Set(playerNode, "id", player.id);
+				utils::xml::Set(playerNode, "name", player.name);
+				utils::xml::Set(playerNode, "xp", player.xp);
+				utils::xml::Set(playerNode, "totalKills", player.totalKills);
+				utils::xml::Set(playerNode, "deaths", player.deaths);
+				utils::xml::Set(playerNode, "killDeathRatio", player.killDeathRatio);
+				utils::xml::Set(playerNode, "damageMax", player.damageMax);
+				utils::xml::Set(playerNode, "healingMax", player.healingMax);
+			}
+		}
+	}
+
+	uint64_t Leaderboard::GetValue(const LeaderboardPlayerXp& player, LeaderboardStat stat) {
+		switch (stat) {
+			case LeaderboardStat::Xp:             return player.xp;
+			case LeaderboardStat::TotalKills:     return player.totalKills;
+			case LeaderboardStat::Deaths:         return player.deaths;
+			case LeaderboardStat::KillDeathRatio: return player.killDeathRatio;
+			case LeaderboardStat::DamageMax:      return player.damageMax;
+			case LeaderboardStat::HealingMax:     return player.healingMax;
+			default:                              return 0;
+		}
+	}
+
+	void Leaderboard::Insert(const LeaderboardPlayerXp& player) {
+		for (size_t i = 0; i < mTrees.size(); ++i) {
+			mTrees[i].insert(GetValue(player, static_cast<LeaderboardStat>(i)), player.id);
+		}
+	}
+
+	void Leaderboard::Remove(const LeaderboardPlayerXp& player) {
+		for (size_t i = 0; i < mTrees.size(); ++i) {
+			mTrees[i].erase(GetValue(player, static_cast<LeaderboardStat>(i)), player.id);
+		}
+	}
+
+	// Leaderboards
+	std::array<Leaderboard, 2> Leaderboards::sLeaderboards;
+	std::unique_ptr<boost::asio::steady_timer> Leaderboards::sTimer;
+	std::atomic<bool> Leaderboards::sDirty = false;
+
+	void Leaderboards::Start(boost::asio::io_context& io) {
+		pugi::xml_document document;
+		if (document.load_file(GetSnapshotPath().c_str())) {
+			for (const auto& leaderboardNode : document.child("leaderboards").children("leaderboard")) {
+				auto versus = utils::xml::GetString<uint32_t>(leaderboardNode, "vs");
+				Get(versus != 0).ReadXml(leaderboardNode.child("players"));
+			}
+		}
+
+		logger::info("Leaderboards: loaded " + std::to_string(Get(false).size()) + " pve and " + std::to_string(Get(true).size()) + " pvp players");
+
+		sTimer = std::make_unique<boost::asio::steady_timer>(io);
+		ScheduleSnapshot();
+	}
+
+	void Leaderboards::Stop() {
+		if (sTimer) {
+			sTimer->cancel();
+			sTimer.reset();
+		}
+		Snapshot();
+	}
+
+	Leaderboard& Leaderboards::Get(bool versus) {
+		return sLeaderboards[versus ? 1 : 0];
+	}
+
+	void Leaderboards::MarkDirty() {
+		sDirty = true;
+	}
+
+	void Leaderboards::ScheduleSnapshot() {
+		sTimer->expires_after(SnapshotInterval);
+		sTimer->async_wait([](const boost::system::error_code& error) {
+			if (!error && sTimer) {
+				Snapshot();
+				ScheduleSnapshot();
+			}
+		});
+	}
+
+	void Leaderboards::Snapshot() {
+		if (!sDirty.exchange(false)) {
+			return;
+		}
+
+		pugi::xml_document document;
+		if (auto leaderboards = document.append_child("leaderboards")) {
+			for (size_t i = 0; i < sLeaderboards.size(); ++i) {
+				if (auto leaderboardNode = leaderboards.append_child("leaderboard")) {
+					utils::xml::Set(leaderboardNode, "vs", static_cast<uint32_t>(i));
+
+					auto players = leaderboardNode.append_child("players");
+					sLeaderboards[i].WriteXml(players);
+				}
+			}
+		}
+
+		std::ostringstream stream;
+		document.save(stream, "\t", 1U, pugi::encoding_latin1);
+		Repository::Persistence::QueueWrite(GetSnapshotPath(), stream.str());
+	}
 }
@@ -3,14 +3,23 @@
 #define _GAME_LEADERBOARD_HEADER
 
 #include <cstdint>
-#include <vector>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <random>
 #include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <boost/asio.hpp>
+#include <pugixml.hpp>
 
 // Game
 namespace Game {
 
 	struct LeaderboardPlayerXp {
-		uint32_t id;
+		uint64_t id;
 		std::string name;
 		uint32_t rank;
 
@@ -21,6 +30,121 @@ namespace Game {
 		uint64_t damageMax;
 		uint64_t healingMax;
 	};
+
+	enum class LeaderboardStat : uint8_t {
+		Xp = 0,
+		TotalKills,
+		Deaths,
+		KillDeathRatio,
+		DamageMax,
+		HealingMax,
+		Count
+	};
+
+	LeaderboardStat GetLeaderboardStat(std::string_view name);
+	std::string_view GetLeaderboardStatName(LeaderboardStat stat);
+
+	// What one player did in one match.
+	struct MatchResult {
+		uint64_t xp = 0;
+		uint64_t kills = 0;
+		uint64_t deaths = 0;
+		uint64_t damage = 0;
+		uint64_t healing = 0;
+	};
+
+	// RankTree, treap ordered by score (highest first) then id with subtree sizes, so rank and select are O(log n).
+	class RankTree {
+		public:
+			void insert(uint64_t score, uint64_t id);
+			void erase(uint64_t score, uint64_t id);
+
+			// Number of entries ahead of (score, id).
+			uint32_t rank(uint64_t score, uint64_t id) const;
+
+			// Ids at ranks [start, start + count).
+			void collect(uint32_t start, uint32_t count, std::vector<uint64_t>& ids) const;
+
+			uint32_t size() const { return size(mRoot); }
+
+		private:
+			static constexpr int32_t Null = -1;
+
+			struct Node {
+				uint64_t score;
+				uint64_t id;
+				uint32_t priority;
+				uint32_t size;
+				int32_t left;
+				int32_t right;
+			};
+
+			static bool less(uint64_t score, uint64_t id, const Node& node) {
+				return score > node.score || (score == node.score && id < node.id);
+			}
+
+			uint32_t size(int32_t index) const { return index == Null ? 0 : mNodes[index].size; }
+			void update(int32_t index);
+
+			// Splits index into entries ordered before (score, id) and the rest.
+			void split(int32_t index, uint64_t score, uint64_t id, int32_t& left, int32_t& right);
+			int32_t merge(int32_t left, int32_t right);
+			int32_t erase(int32_t index, uint64_t score, uint64_t id);
+
+			void collect(int32_t index, uint32_t start, uint32_t count, std::vector<uint64_t>& ids) const;
+
+		private:
+			std::vector<Node> mNodes;
+			std::vector<int32_t> mFreeNodes;
+			std::mt19937 mRandom { 0x5EED };
+			int32_t mRoot = Null;
+	};
+
+	// Leaderboard
+	class Leaderboard {
+		public:
+			void RecordMatch(uint64_t playerId, const std::string& name, const MatchResult& result);
+
+			bool GetPlayer(LeaderboardStat stat, uint64_t playerId, LeaderboardPlayerXp& player) const;
+			std::vector<LeaderboardPlayerXp> GetPage(LeaderboardStat stat, uint32_t start, uint32_t count) const;
+
+			uint32_t size() const;
+
+			void ReadXml(const pugi::xml_node& node);
+			void WriteXml(pugi::xml_node& node) const;
+
+		private:
+			static uint64_t GetValue(const LeaderboardPlayerXp& player, LeaderboardStat stat);
+
+			void Insert(const LeaderboardPlayerXp& player);
+			void Remove(const LeaderboardPlayerXp& player);
+
+		private:
+			std::unordered_map<uint64_t, LeaderboardPlayerXp> mPlayers;
+			std::array<RankTree, static_cast<size_t>(LeaderboardStat::Count)> mTrees;
+
+			mutable std::mutex mMutex;
+	};
+
+	// Leaderboards, one for pve and one for pvp, snapshotted to storage while anything changed.
+	class Leaderboards {
+		public:
+			static void Start(boost::asio::io_context& io);
+			static void Stop();
+
+			static Leaderboard& Get(bool versus);
+
+			static void MarkDirty();
+
+		private:
+			static void ScheduleSnapshot();
+			static void Snapshot();
+
+		private:
+			static std::array<Leaderboard, 2> sLeaderboards;
+			static std::unique_ptr<boost::asio::steady_timer> sTimer;
+			static std::atomic<bool> sDirty;
+	};
 }
 
 #endif
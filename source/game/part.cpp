@@ -43,14 +43,14 @@ namespace Game {
 		rarity        = utils::xml::GetString<uint8_t>(node, "rarity");
 		usage         = utils::xml::GetString<uint8_t>(node, "usage");
 
-		stats                  = utils::xml::GetString(node, "stats");
+		stats.Parse(utils::xml::GetString(node, "stats"));
 		type_full              = utils::xml::GetString(node, "type_full");
 		class_types_full       = utils::xml::GetString(node, "class_types_full");
 		science_types_full     = utils::xml::GetString(node, "science_types_full");
 		rarity_full            = utils::xml::GetString(node, "rarity_full");
 		png_key                = utils::xml::GetString(node, "png_key");
-		weapon_damage_modifier = utils::xml::GetString(node, "weapon_damage_modifier");
-		modifiers              = utils::xml::GetString(node, "modifiers");
+		weapon_damage_modifier.Parse(utils::xml::GetString(node, "weapon_damage_modifier"));
+		modifiers.Parse(utils::xml::GetString(node, "modifiers"));
 		rand_seed              = utils::xml::GetString(node, "rand_seed");
 
 		SetRigblock(utils::xml::GetString<uint32_t>(node, "rigblock_asset_id"));
@@ -85,14 +85,14 @@ namespace Game {
 				utils::xml::Set(part, "suffix_asset_id", suffix_asset_id);
 			}
 
-			utils::xml::Set(part, "stats", stats);
+			utils::xml::Set(part, "stats", stats.ToString());
 			utils::xml::Set(part, "type_full", type_full);
 			utils::xml::Set(part, "class_types_full", class_types_full);
 			utils::xml::Set(part, "science_types_full", science_types_full);
 			utils::xml::Set(part, "rarity_full", rarity_full);
 			utils::xml::Set(part, "png_key", png_key);
-			utils::xml::Set(part, "weapon_damage_modifier", weapon_damage_modifier);
-			utils::xml::Set(part, "modifiers", modifiers);
+			utils::xml::Set(part, "weapon_damage_modifier", weapon_damage_modifier.ToString());
+			utils::xml::Set(part, "modifiers", modifiers.ToString());
 			utils::xml::Set(part, "rand_seed", rand_seed);
 		}
 	}
@@ -106,14 +106,14 @@ namespace Game {
 		rarity = utils::json::GetUint8(object, "rarity");
 		usage = utils::json::GetUint8(object, "usage");
 
-		stats = utils::json::GetString(object, "stats");
+		stats.Parse(utils::json::GetString(object, "stats"));
 		type_full = utils::json::GetString(object, "type_full");
 		class_types_full = utils::json::GetString(object, "class_types_full");
 		science_types_full = utils::json::GetString(object, "science_types_full");
 		rarity_full = utils::json::GetString(object, "rarity_full");
 		png_key = utils::json::GetString(object, "png_key");
-		weapon_damage_modifier = utils::json::GetString(object, "weapon_damage_modifier");
-		modifiers = utils::json::GetString(object, "modifiers");
+		weapon_damage_modifier.Parse(utils::json::GetString(object, "weapon_damage_modifier"));
+		modifiers.Parse(utils::json::GetString(object, "modifiers"));
 		rand_seed = utils::json::GetString(object, "rand_seed");
 		
 		SetRigblock(utils::json::GetUint16(object, "rigblock_asset_id"));
@@ -146,14 +146,14 @@ namespace Game {
 			utils::json::Set(object, "suffix_asset_id", suffix_asset_id, allocator);
 		}
 
-		utils::json::Set(object, "stats", stats, allocator);
+		utils::json::Set(object, "stats", stats.ToString(), allocator);
 		utils::json::Set(object, "type_full", type_full, allocator);
 		utils::json::Set(object, "class_types_full", class_types_full, allocator);
 		utils::json::Set(object, "science_types_full", science_types_full, allocator);
 		utils::json::Set(object, "rarity_full", rarity_full, allocator);
 		utils::json::Set(object, "png_key", png_key, allocator);
-		utils::json::Set(object, "weapon_damage_modifier", weapon_damage_modifier, allocator);
-		utils::json::Set(object, "modifiers", modifiers, allocator);
+		utils::json::Set(object, "weapon_damage_modifier", weapon_damage_modifier.ToString(), allocator);
+		utils::json::Set(object, "modifiers", modifiers.ToString(), allocator);
 		utils::json::Set(object, "rand_seed", rand_seed, allocator);
 
 		return object;
@@ -6,6 +6,7 @@
 #include "game.h"
 
 #include <map>
+#include "stats.h"
 #include "../utils/functions.h"
 
 // Game
@@ -31,14 +32,14 @@ namespace Game {
 			uint8_t market_status;
 			uint8_t usage;
 
-			std::string stats;
+			StatList stats;
 			std::string type_full;
 			std::string class_types_full;
 			std::string science_types_full;
 			std::string rarity_full;
 			std::string png_key;
-			std::string weapon_damage_modifier;
-			std::string modifiers;
+			StatList weapon_damage_modifier;
+			StatList modifiers;
 			std::string rand_seed;
 
 			Part();
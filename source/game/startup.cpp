@@ -0,0 +1,129 @@
+
+// Include
+#include "startup.h"
+#include "config.h"
+#include "leaderboard.h"
+#include "../repository/part.h"
+#include "../repository/template.h"
+#include "../repository/user.h"
+#include "../repository/userpart.h"
+#include "../utils/functions.h"
+#include "../utils/logger.h"
+#include "../utils/metrics.h"
+#include <algorithm>
+#include <cstdio>
+#include <thread>
+
+// Game
+namespace Game {
+
+	std::vector<Startup::Stage> Startup::sStages;
+	std::vector<std::function<void()>> Startup::sWaiting;
+
+	std::unique_ptr<boost::asio::thread_pool> Startup::sPool;
+	boost::asio::io_context* Startup::sIo = nullptr;
+	Startup::Clock::time_point Startup::sStart;
+
+	std::mutex Startup::sMutex;
+	std::atomic<size_t> Startup::sRemaining = 0;
+	std::atomic<bool> Startup::sReady = false;
+
+	void Startup::Run(boost::asio::io_context& io) {
+		sIo = &io;
+		sStart = Clock::now();
+
+		// The stages only share the config, every repository guards its own loading and logs what it loaded.
+		sStages.push_back({ "parts", &Repository::Parts::Load });
+		sStages.push_back({ "templates", &Repository::CreatureTemplates::Load });
+		sStages.push_back({ "user_parts", &Repository::UserParts::Load });
+		sStages.push_back({ "leaderboards", [&io] { Leaderboards::Start(io); } });
+
+		const auto preloadCount = utils::to_number<size_t>(Config::Get(CONFIG_PRELOAD_USERS));
+		if (preloadCount > 0) {
+			sStages.push_back({ "users", [preloadCount] { Repository::Users::Preload(preloadCount); } });
+		}
+
+		auto threads = utils::to_number<size_t>(Config::Get(CONFIG_STARTUP_THREADS));
+		if (threads == 0) {
+			threads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+		}
+		threads = std::min(threads, sStages.size());
+
+		logger::info("Startup: loading " + std::to_string(sStages.size()) + " stages on " + std::to_string(threads) + " threads");
+
+		sRemaining = sStages.size();
+		sPool = std::make_unique<boost::asio::thread_pool>(threads);
+		for (auto& stage : sStages) {
+			boost::asio::post(*sPool, [&stage] {
+				const auto start = Clock::now();
+				try {
+					stage.function();
+				} catch (const std::exception& e) {
+					logger::error("Startup: stage " + stage.name + " failed: " + e.what());
+				}
+				stage.duration = Clock::now() - start;
+
+				if (--sRemaining == 0) {
+					boost::asio::post(*sIo, &Startup::Finish);
+				}
+			});
+		}
+	}
+
+	void Startup::Stop() {
+		if (sPool) {
+			sPool->join();
+			sPool.reset();
+		}
+	}
+
+	bool Startup::IsReady() {
+		return sReady.load(std::memory_order_acquire);
+	}
+
+	void Startup::WhenReady(std::function<void()> function) {
+		{
+			std::lock_guard<std::mutex> lock(sMutex);
+			if (!IsReady()) {
+				sWaiting.push_back(std::move(function));
+				return;
+			}
+		}
+		boost::asio::post(*sIo, std::move(function));
+	}
+
+	void Startup::Finish() {
+		const auto toMilliseconds = [](Clock::duration duration) {
+			return std::chrono::duration<double, std::milli>(duration).count();
+		};
+
+		Clock::duration busy {};
+		for (const auto& stage : sStages) {
+			busy += stage.duration;
+
+			char line[64];
+			std::snprintf(line, sizeof(line), "Startup: %-14s %9.1f ms", stage.name.c_str(), toMilliseconds(stage.duration));
+			logger::info(line);
+
+			metrics::registry::get_gauge("startup_stage_duration_milliseconds", "Time each startup stage took.", { { "stage", stage.name } })
+				.set(static_cast<int64_t>(toMilliseconds(stage.duration)));
+		}
+
+		const auto total = Clock::now() - sStart;
+		logger::info("Startup: ready", { { "total_ms", toMilliseconds(total) }, { "stages_ms", toMilliseconds(busy) } });
+
+		std::vector<std::function<void()>> waiting;
+		{
+			std::lock_guard<std::mutex> lock(sMutex);
+			sReady.store(true, std::memory_order_release);
+			waiting.swap(sWaiting);
+		}
+
+		for (auto& function : waiting) {
+			function();
+		}
+
+		// Every stage is done, the pool threads have nothing left to wait for.
+		Stop();
+	}
+}
@@ -0,0 +1,56 @@
+
+#ifndef _GAME_STARTUP_HEADER
+#define _GAME_STARTUP_HEADER
+
+// Include
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <boost/asio.hpp>
+#include <boost/asio/thread_pool.hpp>
+
+// Game
+namespace Game {
+
+	// Startup, loads everything the first player would otherwise wait for. The stages run in parallel on a
+	// thread pool while the listeners are already bound, servers hold players back until IsReady.
+	class Startup {
+		public:
+			static void Run(boost::asio::io_context& io);
+			static void Stop();
+
+			static bool IsReady();
+
+			// Runs function on the io thread once startup finished, right away if it already has.
+			static void WhenReady(std::function<void()> function);
+
+		private:
+			using Clock = std::chrono::steady_clock;
+
+			struct Stage {
+				std::string name;
+				std::function<void()> function;
+				Clock::duration duration {};
+			};
+
+			static void Finish();
+
+		private:
+			static std::vector<Stage> sStages;
+			static std::vector<std::function<void()>> sWaiting;
+
+			static std::unique_ptr<boost::asio::thread_pool> sPool;
+			static boost::asio::io_context* sIo;
+			static Clock::time_point sStart;
+
+			static std::mutex sMutex;
+			static std::atomic<size_t> sRemaining;
+			static std::atomic<bool> sReady;
+	};
+}
+
+#endif
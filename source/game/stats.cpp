@@ -0,0 +1,207 @@
+
+// Include
+#include "stats.h"
+#include <algorithm>
+#include <charconv>
+
+// Game
+namespace Game {
+	namespace {
+		constexpr std::array<std::string_view, static_cast<size_t>(StatId::Count)> StatNames {
+			"STR", "DEX", "MIND", "HLTH", "MANA", "PDEF", "EDEF", "CRTR", "MOV"
+		};
+
+		std::string_view Trim(std::string_view str) {
+			while (!str.empty() && (str.front() == ' ' || str.front() == '\t')) {
+				str.remove_prefix(1);
+			}
+
+			while (!str.empty() && (str.back() == ' ' || str.back() == '\t')) {
+				str.remove_suffix(1);
+			}
+
+			return str;
+		}
+
+		// Calls func with each trimmed, non empty "a, b, c" entry of a "; " separated list.
+		template<typename F>
+		void ForEachEntry(std::string_view text, F&& func) {
+			while (!text.empty()) {
+				auto end = text.find(';');
+				auto entry = Trim(text.substr(0, end));
+				if (!entry.empty()) {
+					func(entry);
+				}
+
+				if (end == std::string_view::npos) {
+					break;
+				}
+				text.remove_prefix(end + 1);
+			}
+		}
+
+		std::string_view NextField(std::string_view& entry) {
+			auto end = entry.find(',');
+			auto field = Trim(entry.substr(0, end));
+			entry = (end == std::string_view::npos) ? std::string_view() : entry.substr(end + 1);
+			return field;
+		}
+
+		float ParseFloat(std::string_view str) {
+			float value = 0;
+			std::from_chars(str.data(), str.data() + str.size(), value);
+			return value;
+		}
+
+		void AppendFloat(std::string& str, float value) {
+			char buffer[32];
+			auto [end, error] = std::to_chars(buffer, buffer + sizeof(buffer), value);
+			str.append(buffer, end);
+		}
+	}
+
+	StatId GetStatId(std::string_view name) {
+		for (size_t i = 0; i < StatNames.size(); ++i) {
+			if (StatNames[i] == name) {
+				return static_cast<StatId>(i);
+			}
+		}
+		return StatId::Unknown;
+	}
+
+	std::string_view GetStatName(StatId id) {
+		auto index = static_cast<size_t>(id);
+		return index < StatNames.size() ? StatNames[index] : std::string_view();
+	}
+
+	// StatList
+	void StatList::Parse(std::string text) {
+		mStats.clear();
+		ForEachEntry(text, [this](std::string_view entry) {
+			auto& stat = mStats.emplace_back();
+
+			auto name = NextField(entry);
+			stat.id = GetStatId(name);
+			if (stat.id == StatId::Unknown) {
+				stat.name = name;
+			}
+
+			while (!entry.empty() && stat.count < Stat::MaxValues) {
+				stat.values[stat.count++] = ParseFloat(NextField(entry));
+			}
+			stat.extra = Trim(entry);
+		});
+
+		mText = std::move(text);
+		mDirty = false;
+	}
+
+	const std::string& StatList::ToString() const {
+		if (mDirty) {
+			mText.clear();
+			for (const auto& stat : mStats) {
+				if (!mText.empty()) {
+					mText += "; ";
+				}
+
+				mText += (stat.id == StatId::Unknown) ? std::string_view(stat.name) : GetStatName(stat.id);
+				for (uint8_t i = 0; i < stat.count; ++i) {
+					mText += ", ";
+					AppendFloat(mText, stat.values[i]);
+				}
+
+				if (!stat.extra.empty()) {
+					mText += ", ";
+					mText += stat.extra;
+				}
+			}
+			mDirty = false;
+		}
+		return mText;
+	}
+
+	const Stat* StatList::Get(StatId id) const {
+		auto it = std::find_if(mStats.begin(), mStats.end(), [id](const Stat& stat) { return stat.id == id; });
+		return it != mStats.end() ? &*it : nullptr;
+	}
+
+	void StatList::Set(StatId id, float value, size_t index) {
+		if (id == StatId::Unknown || index >= Stat::MaxValues) {
+			return;
+		}
+
+		auto it = std::find_if(mStats.begin(), mStats.end(), [id](const Stat& stat) { return stat.id == id; });
+		if (it == mStats.end()) {
+			it = mStats.insert(mStats.end(), Stat {});
+			it->id = id;
+		}
+
+		it->values[index] = value;
+		it->count = std::max<uint8_t>(it->count, static_cast<uint8_t>(index + 1));
+		mDirty = true;
+	}
+
+	// AbilityStatList
+	void AbilityStatList::Parse(std::string text) {
+		mStats.clear();
+		ForEachEntry(text, [this](std::string_view entry) {
+			const auto original = entry;
+
+			auto key = NextField(entry);
+			auto separator = key.find('!');
+			if (separator == std::string_view::npos) {
+				mStats.emplace_back().raw = original;
+				return;
+			}
+
+			auto& stat = mStats.emplace_back();
+			std::from_chars(key.data(), key.data() + separator, stat.abilityId);
+			stat.key = key.substr(separator + 1);
+			stat.value = ParseFloat(NextField(entry));
+		});
+
+		mText = std::move(text);
+		mDirty = false;
+	}
+
+	const std::string& AbilityStatList::ToString() const {
+		if (mDirty) {
+			mText.clear();
+			for (const auto& stat : mStats) {
+				if (!mText.empty()) {
+					mText += "; ";
+				}
+
+				if (!stat.raw.empty()) {
+					mText += stat.raw;
+					continue;
+				}
+
+				mText += std::to_string(stat.abilityId);
+				mText += '!';
+				mText += stat.key;
+				mText += ", ";
+				AppendFloat(mText, stat.value);
+			}
+			mDirty = false;
+		}
+		return mText;
+	}
+
+	const AbilityStat* AbilityStatList::Get(uint32_t abilityId, std::string_view key) const {
+		auto it = std::find_if(mStats.begin(), mStats.end(), [&](const AbilityStat& stat) { return stat.raw.empty() && stat.abilityId == abilityId && stat.key == key; });
+		return it != mStats.end() ? &*it : nullptr;
+	}
+
+	void AbilityStatList::Set(uint32_t abilityId, std::string_view key, float value) {
+		auto it = std::find_if(mStats.begin(), mStats.end(), [&](const AbilityStat& stat) { return stat.raw.empty() && stat.abilityId == abilityId && stat.key == key; });
+		if (it == mStats.end()) {
+			it = mStats.insert(mStats.end(), AbilityStat {});
+			it->abilityId = abilityId;
+			it->key = key;
+		}
+
+		it->value = value;
+		mDirty = true;
+	}
+}
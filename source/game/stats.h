@@ -0,0 +1,108 @@
+
+#ifndef _GAME_STATS_HEADER
+#define _GAME_STATS_HEADER
+
+// Include
+#include <cstdint>
+#include <array>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Game
+namespace Game {
+	// StatId
+	enum class StatId : uint8_t {
+		Strength = 0,
+		Dexterity,
+		Mind,
+		Health,
+		Mana,
+		PhysicalDefense,
+		EnergyDefense,
+		CriticalRating,
+		Movement,
+		Count,
+		Unknown = 0xFF
+	};
+
+	StatId GetStatId(std::string_view name);
+	std::string_view GetStatName(StatId id);
+
+	// Stat
+	struct Stat {
+		static constexpr size_t MaxValues = 3;
+
+		std::array<float, MaxValues> values {};
+		StatId id = StatId::Unknown;
+		uint8_t count = 0;
+
+		// Only set for ids the server does not know about, so they survive a round trip.
+		std::string name;
+
+		// Values past MaxValues, written back as they were.
+		std::string extra;
+
+		float get(size_t index) const { return index < count ? values[index] : 0.f; }
+	};
+
+	// StatList, "STR, 14, 0; DEX, 13, 0; ..."
+	class StatList {
+		public:
+			StatList() = default;
+			explicit StatList(std::string text) { Parse(std::move(text)); }
+
+			decltype(auto) begin() const { return mStats.begin(); }
+			decltype(auto) end() const { return mStats.end(); }
+
+			bool empty() const { return mStats.empty(); }
+
+			void Parse(std::string text);
+			const std::string& ToString() const;
+
+			const Stat* Get(StatId id) const;
+			void Set(StatId id, float value, size_t index = 0);
+
+		private:
+			std::vector<Stat> mStats;
+
+			mutable std::string mText;
+			mutable bool mDirty = false;
+	};
+
+	// AbilityStat
+	struct AbilityStat {
+		std::string key;
+		float value = 0;
+		uint32_t abilityId = 0;
+
+		// Set for entries that are not "id!key, value", they are written back as they were and never match.
+		std::string raw;
+	};
+
+	// AbilityStatList, "885660025!minDamage, 5; 885660025!maxDamage, 8; ..."
+	class AbilityStatList {
+		public:
+			AbilityStatList() = default;
+			explicit AbilityStatList(std::string text) { Parse(std::move(text)); }
+
+			decltype(auto) begin() const { return mStats.begin(); }
+			decltype(auto) end() const { return mStats.end(); }
+
+			bool empty() const { return mStats.empty(); }
+
+			void Parse(std::string text);
+			const std::string& ToString() const;
+
+			const AbilityStat* Get(uint32_t abilityId, std::string_view key) const;
+			void Set(uint32_t abilityId, std::string_view key, float value);
+
+		private:
+			std::vector<AbilityStat> mStats;
+
+			mutable std::string mText;
+			mutable bool mDirty = false;
+	};
+}
+
+#endif
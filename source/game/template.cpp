@@ -20,9 +20,9 @@ namespace Game {
 
 		classType = utils::xml::GetString(node, "class");
 
-		statsTemplate = utils::xml::GetString(node, "stats_template");
+		statsTemplate.Parse(utils::xml::GetString(node, "stats_template"));
 		//stats_template_ability
-		statsTemplateAbilityKeyvalues = utils::xml::GetString(node, "stats_template_ability_keyvalues");
+		statsTemplateAbilityKeyvalues.Parse(utils::xml::GetString(node, "stats_template_ability_keyvalues"));
 
 		auto userParts = utils::xml::GetString(node, "creature_parts");
 		hasHands = (userParts != "no_hands");
@@ -50,12 +50,12 @@ namespace Game {
 
 			utils::xml::Set(creature, "class", classType);
 
-			utils::xml::Set(creature, "stats_template", statsTemplate);
+			utils::xml::Set(creature, "stats_template", statsTemplate.ToString());
 
 			// TODO: That's not correct, but it works for testing purposes
-			utils::xml::Set(creature, "stats_template_ability", statsTemplateAbilityKeyvalues);
+			utils::xml::Set(creature, "stats_template_ability", statsTemplateAbilityKeyvalues.ToString());
 			
-			utils::xml::Set(creature, "stats_template_ability_keyvalues", statsTemplateAbilityKeyvalues);
+			utils::xml::Set(creature, "stats_template_ability_keyvalues", statsTemplateAbilityKeyvalues.ToString());
 
 			if (hasFeet && !hasHands) {
 				utils::xml::Set(creature, "creature_parts", "no_hands");
@@ -94,9 +94,9 @@ namespace Game {
 
 		classType = utils::json::GetString(object, "classType");
 
-		statsTemplate = utils::json::GetString(object, "statsTemplate");
+		statsTemplate.Parse(utils::json::GetString(object, "statsTemplate"));
 		//statsTemplateAbility = utils::json::GetString(object, "statsTemplateAbility");
-		statsTemplateAbilityKeyvalues = utils::json::GetString(object, "statsTemplateAbilityKeyvalues");
+		statsTemplateAbilityKeyvalues.Parse(utils::json::GetString(object, "statsTemplateAbilityKeyvalues"));
 
 		hasFeet  = utils::json::GetBool(object, "hasFeet");
 		hasHands = utils::json::GetBool(object, "hasHands");
@@ -124,9 +124,9 @@ namespace Game {
 
 		utils::json::Set(object, "classType", classType, allocator);
 
-		utils::json::Set(object, "statsTemplate", statsTemplate, allocator);
+		utils::json::Set(object, "statsTemplate", statsTemplate.ToString(), allocator);
 		//utils::json::Set(object, "statsTemplateAbility", statsTemplateAbility, allocator);
-		utils::json::Set(object, "statsTemplateAbilityKeyvalues", statsTemplateAbilityKeyvalues, allocator);
+		utils::json::Set(object, "statsTemplateAbilityKeyvalues", statsTemplateAbilityKeyvalues.ToString(), allocator);
 
 		utils::json::Set(object, "hasFeet",  hasFeet,  allocator);
 		utils::json::Set(object, "hasHands", hasHands, allocator);
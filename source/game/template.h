@@ -4,6 +4,7 @@
 
 // Include
 #include <vector>
+#include "stats.h"
 #include "../utils/functions.h"
 
 // Game
@@ -128,7 +129,7 @@ namespace Game {
 
 			std::string classType;
 
-			std::string statsTemplate;
+			StatList statsTemplate;
 			//    example (with no spaces): STR, 14, 0; DEX, 13, 0; MIND, 23, 0; HLTH, 100, 70; MANA, 125, 23; PDEF, 50, 88; EDEF, 150, 138; CRTR, 50, 66; MOV, 0, 1                  
 
 			//stats_template_ability
@@ -137,7 +138,7 @@ namespace Game {
 			//		item = a!b,value
 			//	}
 
-			std::string statsTemplateAbilityKeyvalues;
+			AbilityStatList statsTemplateAbilityKeyvalues;
 			//    example (with no spaces): 885660025!minDamage, 5; 885660025!maxDamage, 8; 885660025!percentToHeal, 20; 1152331895!duration, 20; 1152331895!spawnMax, 2; 424126604!radius, 8; 424126604!healing, 5; 424126604!duration, 6; 424126604!minHealing, 21; 424126604!maxHealing, 32; 1577880566!Enrage.damage, 9; 1577880566!Enrage.duration, 30; 1577880566!Enrage.healing, 35; 1829107826!diameter, 12; 1829107826!damage, 6; 1829107826!duration, 10; 1829107826!speedDebuff, 75
 
 			bool hasFeet;
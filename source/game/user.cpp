@@ -3,6 +3,7 @@
 #include "user.h"
 #include "config.h"
 
+#include "../repository/user.h"
 #include "../utils/functions.h"
 #include <algorithm>
 #include <filesystem>
@@ -285,21 +286,39 @@ namespace Game {
 		return value;
 	}
 
+	void Feed::Add(FeedItem&& item) {
+		mItems.push_back(std::move(item));
+	}
+
 
 
 	// User
+	std::atomic<uint64_t> User::sVersionCounter = 0;
+
 	User::User(const std::string& name, const std::string& email, const std::string& password) : mName(name), mEmail(email), mPassword(password) {
-		// Empty
+		Touch();
 	}
 
 	User::User(const std::string& email) : mEmail(email) {
-		// Empty
+		Touch();
 	}
 
 	User::~User() {
 		
 	}
 
+	void User::set_auth_token(const std::string& authToken) {
+		if (mAuthToken != authToken) {
+			std::string oldAuthToken = std::move(mAuthToken);
+			mAuthToken = authToken;
+			Repository::Users::OnAuthTokenChanged(*this, oldAuthToken);
+		}
+	}
+
+	void User::Touch() {
+		mVersion = ++sVersionCounter;
+	}
+
 	bool User::UpdateState(uint32_t newState) {
 		if (mState != newState) {
 			mState = newState;
@@ -378,10 +397,12 @@ namespace Game {
 		if (mAccount.creatureRewards > 0) {
 			mCreatures.Add(templateId);
 			mAccount.creatureRewards--;
+			Touch();
 		}
 	}
 
 	void User::UnlockUpgrade(uint32_t unlockId) {
+		Touch();
 		switch (unlockId) {
 			case 1: // Catalysts
 				mAccount.unlockCatalysts++;
@@ -7,7 +7,9 @@
 #include "squad.h"
 #include "userpart.h"
 
+#include <atomic>
 #include <map>
+#include <mutex>
 #include "../utils/functions.h"
 
 // Game
@@ -136,7 +138,7 @@ namespace Game {
 			void set_name(const std::string& name) { mName = name; }
 
 			const std::string& get_auth_token() const { return mAuthToken; }
-			void set_auth_token(const std::string& authToken) { mAuthToken = authToken; }
+			void set_auth_token(const std::string& authToken);
 
 
 			const GameInfoPtr& get_game_info() const { return mGameInfo; }
@@ -145,6 +147,17 @@ namespace Game {
 
 			auto get_id() const { return mAccount.id; }
 
+			// Changes every time the user is modified, never repeats for the lifetime of the server.
+			uint64_t get_version() const { return mVersion; }
+			void Touch();
+
+			// Groups the spans of one login session in the trace file, 0 while logged out.
+			uint64_t get_trace_id() const { return mTraceId.load(std::memory_order_relaxed); }
+			void set_trace_id(uint64_t traceId) { mTraceId.store(traceId, std::memory_order_relaxed); }
+
+			// Serializes everything that reads or changes this user across threads, held for a whole request.
+			std::unique_lock<std::recursive_mutex> Lock() const { return std::unique_lock(mMutex); }
+
 			bool UpdateState(uint32_t newState);
 
 			// Squad
@@ -181,8 +194,15 @@ namespace Game {
 
 			GameInfoPtr mGameInfo;
 
+			uint64_t mVersion = 0;
+			std::atomic<uint64_t> mTraceId = 0;
+
+			mutable std::recursive_mutex mMutex;
+
 			uint32_t mId = 0;
 			uint32_t mState = 0;
+
+			static std::atomic<uint64_t> sVersionCounter;
 	};
 
 	using UserPtr = std::shared_ptr<Game::User>;
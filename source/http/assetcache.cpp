@@ -0,0 +1,493 @@
+
+// Include
+#include "assetcache.h"
+#include "router.h"
+#include "session.h"
+
+#include "../game/config.h"
+#include "../utils/compression.h"
+#include "../utils/functions.h"
+#include "../utils/logger.h"
+#include "../utils/metrics.h"
+
+#include <boost/beast/version.hpp>
+#include <boost/optional.hpp>
+
+#include <algorithm>
+#include <ctime>
+#include <fstream>
+
+// HTTP
+namespace HTTP {
+	namespace {
+		constexpr std::chrono::seconds CheckInterval { 1 };
+
+		// Body that points into a cached asset and keeps it alive until the response is written.
+		struct asset_body {
+			struct value_type {
+				AssetPtr asset;
+				std::string_view data;
+			};
+
+			static uint64_t size(const value_type& body) {
+				return body.data.size();
+			}
+
+			class writer {
+				public:
+					using const_buffers_type = boost::asio::const_buffer;
+
+					template<bool isRequest, class Fields>
+					writer(const boost::beast::http::header<isRequest, Fields>&, const value_type& body) : mBody(body) {}
+
+					void init(boost::beast::error_code& error) {
+						error = {};
+					}
+
+					boost::optional<std::pair<const_buffers_type, bool>> get(boost::beast::error_code& error) {
+						error = {};
+						return { { const_buffers_type(mBody.data.data(), mBody.data.size()), false } };
+					}
+
+				private:
+					const value_type& mBody;
+			};
+		};
+
+		uint64_t hash_content(std::string_view content) {
+			// FNV-1a, only has to tell versions of one file apart.
+			uint64_t hash = 0xCBF29CE484222325;
+			for (unsigned char c : content) {
+				hash = (hash ^ c) * 0x100000001B3;
+			}
+			return hash;
+		}
+
+		std::string format_http_date(std::filesystem::file_time_type writeTime) {
+			const auto systemTime = std::chrono::system_clock::now() +
+				std::chrono::duration_cast<std::chrono::system_clock::duration>(writeTime - std::filesystem::file_time_type::clock::now());
+			const auto seconds = std::chrono::system_clock::to_time_t(systemTime);
+
+			std::tm tstruct {};
+#ifdef _WIN32
+			gmtime_s(&tstruct, &seconds);
+#else
+			gmtime_r(&seconds, &tstruct);
+#endif
+			char buf[64];
+			std::strftime(buf, sizeof(buf), "%a, %d %b %Y %H:%M:%S GMT", &tstruct);
+			return buf;
+		}
+
+		boost::beast::string_view trim(boost::beast::string_view value) {
+			while (!value.empty() && (value.front() == ' ' || value.front() == '\t')) {
+				value.remove_prefix(1);
+			}
+			while (!value.empty() && (value.back() == ' ' || value.back() == '\t')) {
+				value.remove_suffix(1);
+			}
+			return value;
+		}
+
+		bool matches_etag(boost::beast::string_view ifNoneMatch, const Asset& asset) {
+			while (!ifNoneMatch.empty()) {
+				auto comma = ifNoneMatch.find(',');
+				auto tag = trim(ifNoneMatch.substr(0, comma));
+				ifNoneMatch = comma == boost::beast::string_view::npos ? boost::beast::string_view {} : ifNoneMatch.substr(comma + 1);
+
+				// If-None-Match uses the weak comparison.
+				if (tag.starts_with("W/")) {
+					tag.remove_prefix(2);
+				}
+
+				if (tag == "*" || tag == asset.etag || (!asset.gzipEtag.empty() && tag == asset.gzipEtag)) {
+					return true;
+				}
+			}
+			return false;
+		}
+
+		bool is_not_modified(const boost::beast::http::request<boost::beast::http::string_body>& request, const Asset& asset) {
+			if (auto it = request.find(boost::beast::http::field::if_none_match); it != request.end()) {
+				return matches_etag(it->value(), asset);
+			}
+
+			// Clients send back the Last-Modified they were given, so an exact match is all that is needed.
+			if (auto it = request.find(boost::beast::http::field::if_modified_since); it != request.end()) {
+				return trim(it->value()) == asset.lastModified;
+			}
+
+			return false;
+		}
+
+		// ByteRange, the first and last byte of a satisfiable range.
+		struct ByteRange {
+			uint64_t first = 0;
+			uint64_t last = 0;
+		};
+
+		bool parse_number(boost::beast::string_view text, uint64_t& value) {
+			if (text.empty() || text.size() > 19) {
+				return false;
+			}
+
+			value = 0;
+			for (char c : text) {
+				if (c < '0' || c > '9') {
+					return false;
+				}
+				value = value * 10 + static_cast<uint64_t>(c - '0');
+			}
+			return true;
+		}
+
+		// Only a single range is supported, anything else (multiple ranges, other units, garbage) is ignored
+		// and answered with the whole file. An unsatisfiable range leaves range empty.
+		bool parse_range(boost::beast::string_view value, uint64_t size, boost::optional<ByteRange>& range) {
+			value = trim(value);
+			if (!value.starts_with("bytes=")) {
+				return false;
+			}
+
+			value = trim(value.substr(6));
+			if (value.find(',') != boost::beast::string_view::npos) {
+				return false;
+			}
+
+			const auto dash = value.find('-');
+			if (dash == boost::beast::string_view::npos) {
+				return false;
+			}
+
+			const auto firstText = trim(value.substr(0, dash));
+			const auto lastText = trim(value.substr(dash + 1));
+
+			uint64_t first = 0;
+			uint64_t last = 0;
+			if (firstText.empty()) {
+				// Suffix range, the last n bytes.
+				uint64_t length = 0;
+				if (!parse_number(lastText, length)) {
+					return false;
+				}
+
+				if (length > 0 && size > 0) {
+					range = ByteRange { size - std::min(length, size), size - 1 };
+				}
+				return true;
+			}
+
+			if (!parse_number(firstText, first)) {
+				return false;
+			}
+
+			if (lastText.empty()) {
+				last = size - 1;
+			} else if (!parse_number(lastText, last) || last < first) {
+				return false;
+			}
+
+			if (first < size) {
+				range = ByteRange { first, std::min(last, size - 1) };
+			}
+			return true;
+		}
+
+		// If-Range needs a strong match, otherwise the client gets the whole (changed) file.
+		bool matches_if_range(const boost::beast::http::request<boost::beast::http::string_body>& request, const Asset& asset) {
+			auto it = request.find(boost::beast::http::field::if_range);
+			if (it == request.end()) {
+				return true;
+			}
+
+			const auto value = trim(it->value());
+			return value == asset.etag || value == asset.lastModified;
+		}
+
+		std::string format_content_range(const ByteRange& range, uint64_t size) {
+			return "bytes " + std::to_string(range.first) + "-" + std::to_string(range.last) + "/" + std::to_string(size);
+		}
+
+		template<class Response>
+		void set_asset_fields(Response& response, const Asset& asset, bool gzip, const std::map<boost::beast::http::field, std::string>& fields, bool keepAlive) {
+			for (const auto& [field, value] : fields) {
+				response.set(field, value);
+			}
+
+			response.set(boost::beast::http::field::server, BOOST_BEAST_VERSION_STRING);
+			response.set(boost::beast::http::field::etag, gzip ? asset.gzipEtag : asset.etag);
+			response.set(boost::beast::http::field::last_modified, asset.lastModified);
+			response.set(boost::beast::http::field::cache_control, "no-cache");
+			if (!asset.gzipContent.empty()) {
+				response.set(boost::beast::http::field::vary, "Accept-Encoding");
+			}
+			response.set(boost::beast::http::field::accept_ranges, "bytes");
+			response.keep_alive(keepAlive);
+		}
+	}
+
+	// AssetCache
+	AssetCache::EntryList AssetCache::sEntries;
+	std::unordered_map<std::string, AssetCache::EntryList::iterator> AssetCache::sIndex;
+	size_t AssetCache::sBytes = 0;
+
+	std::mutex AssetCache::sMutex;
+
+	AssetPtr AssetCache::Get(const std::string& path) {
+		static auto& hits = metrics::registry::get_counter("http_asset_cache_total", "Static file lookups by outcome.", { { "result", "hit" } });
+		static auto& misses = metrics::registry::get_counter("http_asset_cache_total", "Static file lookups by outcome.", { { "result", "miss" } });
+
+		const auto now = Clock::now();
+
+		AssetPtr asset;
+		{
+			std::lock_guard<std::mutex> lock(sMutex);
+
+			auto it = sIndex.find(path);
+			if (it != sIndex.end()) {
+				auto entry = it->second;
+				sEntries.splice(sEntries.begin(), sEntries, entry);
+				if (now < entry->checked + CheckInterval) {
+					hits.add();
+					return entry->asset;
+				}
+
+				entry->checked = now;
+				asset = entry->asset;
+			}
+		}
+
+		std::error_code error;
+		if (!std::filesystem::is_regular_file(path, error)) {
+			Remove(path);
+			return nullptr;
+		}
+
+		const auto writeTime = std::filesystem::last_write_time(path, error);
+		const auto size = error ? 0 : std::filesystem::file_size(path, error);
+		if (error) {
+			Remove(path);
+			return nullptr;
+		}
+
+		if (asset && asset->writeTime == writeTime && asset->size == size) {
+			hits.add();
+			return asset;
+		}
+
+		misses.add();
+		asset = Load(path, writeTime, size);
+		if (asset) {
+			Put(asset, now);
+		} else {
+			Remove(path);
+		}
+		return asset;
+	}
+
+	void AssetCache::Clear() {
+		std::lock_guard<std::mutex> lock(sMutex);
+		sIndex.clear();
+		sEntries.clear();
+		sBytes = 0;
+	}
+
+	AssetPtr AssetCache::Load(const std::string& path, std::filesystem::file_time_type writeTime, uint64_t size) {
+		auto asset = std::make_shared<Asset>();
+		asset->path = path;
+		asset->mimeType = mime_type(path);
+		asset->writeTime = writeTime;
+		asset->size = size;
+		asset->lastModified = format_http_date(writeTime);
+
+		// A few big files would push everything else out, they are read from disk every time instead.
+		if (size <= GetBudget() / 8) {
+			std::ifstream stream(path, std::ios::binary);
+			if (!stream.is_open()) {
+				return nullptr;
+			}
+
+			asset->content.resize(static_cast<size_t>(size));
+			if (!stream.read(asset->content.data(), asset->content.size())) {
+				logger::warn("AssetCache: could not read " + path);
+				return nullptr;
+			}
+
+			asset->etag = "\"" + utils::unsigned_long_long_to_hex_string(hash_content(asset->content)) + "\"";
+			asset->cached = true;
+
+			if (is_compressible(asset->mimeType)) {
+				auto gzipContent = compression::gzip(asset->content, 9);
+				if (gzipContent.size() < asset->content.size() * 9 / 10) {
+					asset->gzipContent = std::move(gzipContent);
+					asset->gzipEtag = asset->etag.substr(0, asset->etag.size() - 1) + "-gz\"";
+				}
+			}
+		} else {
+			const auto ticks = static_cast<uint64_t>(writeTime.time_since_epoch().count());
+			asset->etag = "\"" + utils::unsigned_long_long_to_hex_string(size) + "-" + utils::unsigned_long_long_to_hex_string(ticks) + "\"";
+		}
+
+		return asset;
+	}
+
+	void AssetCache::Put(const AssetPtr& asset, Clock::time_point checked) {
+		const size_t budget = GetBudget();
+		const size_t cost = GetCost(*asset);
+
+		std::lock_guard<std::mutex> lock(sMutex);
+
+		auto it = sIndex.find(asset->path);
+		if (it != sIndex.end()) {
+			sBytes -= GetCost(*it->second->asset);
+			sEntries.erase(it->second);
+			sIndex.erase(it);
+		}
+
+		while (!sEntries.empty() && sBytes + cost > budget) {
+			const auto& last = sEntries.back();
+			sBytes -= GetCost(*last.asset);
+			sIndex.erase(last.asset->path);
+			sEntries.pop_back();
+		}
+
+		sEntries.push_front({ asset, checked });
+		sIndex.emplace(asset->path, sEntries.begin());
+		sBytes += cost;
+	}
+
+	void AssetCache::Remove(const std::string& path) {
+		std::lock_guard<std::mutex> lock(sMutex);
+
+		auto it = sIndex.find(path);
+		if (it != sIndex.end()) {
+			sBytes -= GetCost(*it->second->asset);
+			sEntries.erase(it->second);
+			sIndex.erase(it);
+		}
+	}
+
+	size_t AssetCache::GetBudget() {
+		static const size_t budget = utils::to_number<size_t>(Game::Config::Get(Game::CONFIG_ASSET_CACHE_SIZE));
+		return budget;
+	}
+
+	size_t AssetCache::GetCost(const Asset& asset) {
+		return asset.path.size() + asset.content.size() + asset.gzipContent.size();
+	}
+
+	// Functions
+	bool send_file(Session& session, const std::string& path, boost::beast::http::status result, uint32_t version, bool keepAlive,
+		const std::map<boost::beast::http::field, std::string>& fields) {
+		const auto& request = session.get_request().data;
+
+		auto asset = AssetCache::Get(path);
+		if (!asset) {
+			return false;
+		}
+
+		const bool acceptsGzip = !asset->gzipContent.empty() &&
+			negotiate_encoding(request[boost::beast::http::field::accept_encoding], false) == ContentEncoding::Gzip;
+
+		if (result == boost::beast::http::status::ok && is_not_modified(request, *asset)) {
+			boost::beast::http::response<boost::beast::http::empty_body> response {
+				boost::beast::http::status::not_modified, version
+			};
+
+			set_asset_fields(response, *asset, acceptsGzip, fields, keepAlive);
+			session.send(std::move(response));
+			return true;
+		}
+
+		// Ranges always refer to the identity representation, so a ranged response is never compressed.
+		boost::optional<ByteRange> range;
+		bool ranged = false;
+		if (result == boost::beast::http::status::ok && request.method() == boost::beast::http::verb::get) {
+			if (auto it = request.find(boost::beast::http::field::range); it != request.end() && matches_if_range(request, *asset)) {
+				ranged = parse_range(it->value(), asset->size, range);
+			}
+		}
+
+		if (ranged && !range) {
+			boost::beast::http::response<boost::beast::http::empty_body> response {
+				boost::beast::http::status::range_not_satisfiable, version
+			};
+
+			set_asset_fields(response, *asset, false, fields, keepAlive);
+			response.set(boost::beast::http::field::content_range, "bytes */" + std::to_string(asset->size));
+			response.content_length(0);
+			session.send(std::move(response));
+			return true;
+		}
+
+		const bool gzip = !ranged && acceptsGzip;
+		std::string_view data = gzip ? asset->gzipContent : asset->content;
+
+		if (request.method() == boost::beast::http::verb::head) {
+			boost::beast::http::response<boost::beast::http::empty_body> response {
+				result, version
+			};
+
+			set_asset_fields(response, *asset, gzip, fields, keepAlive);
+			response.set(boost::beast::http::field::content_type, asset->mimeType);
+			if (gzip) {
+				response.set(boost::beast::http::field::content_encoding, "gzip");
+			}
+			response.content_length(asset->cached ? data.size() : asset->size);
+			session.send(std::move(response));
+			return true;
+		}
+
+		uint64_t offset = 0;
+		uint64_t length = asset->cached ? data.size() : asset->size;
+		if (range) {
+			result = boost::beast::http::status::partial_content;
+			offset = range->first;
+			length = range->last - range->first + 1;
+		}
+
+		if (asset->cached) {
+			data = data.substr(static_cast<size_t>(offset), static_cast<size_t>(length));
+
+			boost::beast::http::response<asset_body> response {
+				std::piecewise_construct,
+				std::make_tuple(asset_body::value_type { asset, data }),
+				std::make_tuple(result, version)
+			};
+
+			set_asset_fields(response, *asset, gzip, fields, keepAlive);
+			response.set(boost::beast::http::field::content_type, asset->mimeType);
+			if (gzip) {
+				response.set(boost::beast::http::field::content_encoding, "gzip");
+			}
+			if (range) {
+				response.set(boost::beast::http::field::content_range, format_content_range(*range, asset->size));
+			}
+			response.content_length(data.size());
+			session.send(std::move(response));
+			return true;
+		}
+
+		// Big files skip the cache and go from disk to the socket, see Session::send_file.
+		boost::beast::error_code error;
+		auto file = std::make_shared<boost::beast::file>();
+		file->open(path.c_str(), boost::beast::file_mode::scan, error);
+		if (error) {
+			logger::error("Could not open file " + path + ": " + error.message());
+			return false;
+		}
+
+		boost::beast::http::response<boost::beast::http::empty_body> response {
+			result, version
+		};
+
+		set_asset_fields(response, *asset, gzip, fields, keepAlive);
+		response.set(boost::beast::http::field::content_type, asset->mimeType);
+		if (range) {
+			response.set(boost::beast::http::field::content_range, format_content_range(*range, asset->size));
+		}
+		response.content_length(length);
+		session.send_file(std::move(response), std::move(file), offset, length);
+		return true;
+	}
+}
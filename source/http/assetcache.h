@@ -0,0 +1,89 @@
+
+#ifndef _HTTP_ASSETCACHE_HEADER
+#define _HTTP_ASSETCACHE_HEADER
+
+// Include
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+// HTTP
+namespace HTTP {
+	class Session;
+
+	// Asset, a static file with its validators. Only files small enough for the cache keep their content.
+	struct Asset {
+		std::string path;
+
+		// Empty for files that are streamed from disk.
+		std::string content;
+
+		// Empty unless the file is text and compressing saved something.
+		std::string gzipContent;
+
+		std::string etag;
+		std::string lastModified;
+
+		// Sent with gzipContent, a different representation needs a different strong validator.
+		std::string gzipEtag;
+		boost::beast::string_view mimeType;
+
+		std::filesystem::file_time_type writeTime;
+		uint64_t size = 0;
+
+		bool cached = false;
+	};
+
+	using AssetPtr = std::shared_ptr<const Asset>;
+
+	// AssetCache, static files keyed by path with a byte budget and LRU eviction. Files are checked for changes
+	// by their write time and size at most once per second.
+	class AssetCache {
+		public:
+			// nullptr when path is not a readable file.
+			static AssetPtr Get(const std::string& path);
+
+			static void Clear();
+
+		private:
+			using Clock = std::chrono::steady_clock;
+
+			struct Entry {
+				AssetPtr asset;
+				Clock::time_point checked;
+			};
+
+			using EntryList = std::list<Entry>;
+
+			static AssetPtr Load(const std::string& path, std::filesystem::file_time_type writeTime, uint64_t size);
+			static void Put(const AssetPtr& asset, Clock::time_point checked);
+			static void Remove(const std::string& path);
+
+			static size_t GetBudget();
+			static size_t GetCost(const Asset& asset);
+
+		private:
+			static EntryList sEntries;
+			static std::unordered_map<std::string, EntryList::iterator> sIndex;
+			static size_t sBytes;
+
+			static std::mutex sMutex;
+	};
+
+	// Answers the current request with the file at path through the AssetCache. Conditional requests are
+	// answered with 304, clients that accept gzip get the compressed copy and a single byte Range is answered
+	// with 206. False if there is no such file.
+	bool send_file(Session& session, const std::string& path, boost::beast::http::status result, uint32_t version, bool keepAlive,
+		const std::map<boost::beast::http::field, std::string>& fields = {});
+}
+
+#endif
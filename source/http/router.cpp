@@ -1,9 +1,11 @@
 
 // Include
 #include "router.h"
+#include "assetcache.h"
 #include "session.h"
 #include "uri.h"
 
+#include "../game/config.h"
 #include "../utils/functions.h"
 #include "../utils/logger.h"
 
@@ -12,10 +14,79 @@
 #include <boost/beast/http.hpp>
 #include <boost/beast/version.hpp>
 
+#include <cassert>
+#include <cstdlib>
 #include <iostream>
 
 // HTTP
 namespace HTTP {
+	namespace {
+		boost::beast::string_view trim(boost::beast::string_view value) {
+			while (!value.empty() && (value.front() == ' ' || value.front() == '\t')) {
+				value.remove_prefix(1);
+			}
+			while (!value.empty() && (value.back() == ' ' || value.back() == '\t')) {
+				value.remove_suffix(1);
+			}
+			return value;
+		}
+	}
+
+	// Functions
+	ContentEncoding negotiate_encoding(boost::beast::string_view acceptEncoding, bool allowDeflate) {
+		// Codings that are not listed are not acceptable, unless * is.
+		double gzip = -1;
+		double deflate = -1;
+		double any = 0;
+
+		while (!acceptEncoding.empty()) {
+			auto comma = acceptEncoding.find(',');
+			auto coding = trim(acceptEncoding.substr(0, comma));
+			acceptEncoding = comma == boost::beast::string_view::npos ? boost::beast::string_view {} : acceptEncoding.substr(comma + 1);
+
+			auto semicolon = coding.find(';');
+			auto name = trim(coding.substr(0, semicolon));
+
+			double weight = 1;
+			if (semicolon != boost::beast::string_view::npos) {
+				if (auto q = coding.find("q=", semicolon); q != boost::beast::string_view::npos) {
+					weight = std::strtod(std::string(coding.substr(q + 2)).c_str(), nullptr);
+				}
+			}
+
+			if (boost::beast::iequals(name, "gzip") || boost::beast::iequals(name, "x-gzip")) {
+				gzip = weight;
+			} else if (boost::beast::iequals(name, "deflate")) {
+				deflate = weight;
+			} else if (name == "*") {
+				any = weight;
+			}
+		}
+
+		if (gzip < 0) {
+			gzip = any;
+		}
+		if (deflate < 0 || !allowDeflate) {
+			deflate = allowDeflate ? any : 0;
+		}
+
+		if (gzip > 0 && gzip >= deflate) {
+			return ContentEncoding::Gzip;
+		} else if (deflate > 0) {
+			return ContentEncoding::Deflate;
+		}
+		return ContentEncoding::Identity;
+	}
+
+	bool is_compressible(boost::beast::string_view contentType) {
+		contentType = trim(contentType.substr(0, contentType.find(';')));
+		return contentType.starts_with("text/") ||
+			contentType == "application/javascript" ||
+			contentType == "application/json" ||
+			contentType == "application/xml" ||
+			contentType == "image/svg+xml";
+	}
+
 	// Response
 	void Response::set(boost::beast::http::field field, const std::string& value) {
 		mFields[field] = value;
@@ -41,35 +112,31 @@ namespace HTTP {
 		return mKeepAlive;
 	}
 
+	void Response::set_compressed_prefix(std::shared_ptr<const compression::prefix> prefix) {
+		mCompressedPrefix = std::move(prefix);
+		mCompressedPrefixFn = nullptr;
+	}
+
+	void Response::set_compressed_prefix(PrefixFn prefixFn) {
+		mCompressedPrefix.reset();
+		mCompressedPrefixFn = std::move(prefixFn);
+	}
+
 	void Response::send(Session& session) {
 		uint32_t realVersion = mVersion & 0xFFFFFFF;
 		if (mVersion & 0x1000'0000) {
-			boost::beast::error_code error;
-			boost::beast::http::file_body::value_type body;
-			body.open(mBody.c_str(), boost::beast::file_mode::scan, error);
-			if (error == boost::beast::errc::no_such_file_or_directory) {
+			if (!send_file(session, mBody, mResult, realVersion, mKeepAlive, mFields)) {
 				logger::error("Could not find file " + mBody);
-			} else if (error) {
-				logger::error("Something error finding file " + mBody);
-			}
 
-			const auto size = body.size();
-			boost::beast::http::response<boost::beast::http::file_body> response {
-				std::piecewise_construct,
-				std::make_tuple(std::move(body)),
-				std::make_tuple(mResult, realVersion)
-			};
+				boost::beast::http::response<boost::beast::http::empty_body> response {
+					boost::beast::http::status::not_found, realVersion
+				};
 
-			for (const auto& [field, value] : mFields) {
-				response.set(field, value);
+				response.set(boost::beast::http::field::server, BOOST_BEAST_VERSION_STRING);
+				response.keep_alive(mKeepAlive);
+				response.content_length(0);
+				session.send(std::move(response));
 			}
-
-			response.set(boost::beast::http::field::server, BOOST_BEAST_VERSION_STRING);
-			response.set(boost::beast::http::field::content_type, mime_type(mBody));
-
-			response.keep_alive(mKeepAlive);
-			response.content_length(size);
-			session.send(std::move(response));
 		} else {
 			boost::beast::http::response<boost::beast::http::string_body> response {
 				mResult, realVersion
@@ -81,9 +148,42 @@ namespace HTTP {
 
 			response.set(boost::beast::http::field::server, BOOST_BEAST_VERSION_STRING);
 
+			// Small bodies fit in a packet or two anyway, compressing them only costs time.
+			static const size_t minCompressSize = utils::to_number<size_t>(Game::Config::Get(Game::CONFIG_COMPRESSION_MIN_SIZE));
+
+			auto encoding = ContentEncoding::Identity;
+			auto contentType = mFields.find(boost::beast::http::field::content_type);
+			if (mBody.size() >= minCompressSize && contentType != mFields.end() && is_compressible(contentType->second)) {
+				response.set(boost::beast::http::field::vary, "Accept-Encoding");
+				encoding = negotiate_encoding(session.get_request().data[boost::beast::http::field::accept_encoding]);
+			}
+
+			if (encoding == ContentEncoding::Identity) {
+				response.body() = std::move(mBody);
+			} else {
+				if (!mCompressedPrefix && mCompressedPrefixFn) {
+					mCompressedPrefix = mCompressedPrefixFn();
+				}
+
+				// A prefix that is not the start of the body would produce a stream that decompresses to something else.
+				const bool hasPrefix = mCompressedPrefix && mCompressedPrefix->matches(mBody);
+				assert(!mCompressedPrefix || hasPrefix);
+				if (mCompressedPrefix && !hasPrefix) {
+					logger::warn("Compressed prefix does not match the response body, compressing all of it.");
+				}
+
+				const std::string_view rest = hasPrefix ? std::string_view(mBody).substr(mCompressedPrefix->size()) : std::string_view(mBody);
+				if (encoding == ContentEncoding::Gzip) {
+					response.set(boost::beast::http::field::content_encoding, "gzip");
+					response.body() = hasPrefix ? mCompressedPrefix->gzip(rest) : compression::gzip(rest);
+				} else {
+					response.set(boost::beast::http::field::content_encoding, "deflate");
+					response.body() = hasPrefix ? mCompressedPrefix->zlib(rest) : compression::zlib(rest);
+				}
+			}
+
 			response.keep_alive(mKeepAlive);
-			response.body() = mBody;
-			response.content_length(mBody.length());
+			response.content_length(response.body().length());
 			session.send(std::move(response));
 		}
 	}
@@ -110,6 +210,10 @@ namespace HTTP {
 
 	void RoutePath::construct() {
 		mRegExpr = std::regex(mPath);
+
+		const std::string method(boost::beast::http::to_string(mMethod));
+		mRequests = &metrics::registry::get_counter("http_requests_total", "HTTP requests handled by a route.", { { "route", mPath }, { "method", method } });
+		mDuration = &metrics::registry::get_histogram("http_request_duration_seconds", "Time spent in HTTP route handlers.", { { "route", mPath }, { "method", method } });
 	}
 
 	// Router
@@ -123,10 +227,15 @@ namespace HTTP {
 				response.version() = request.data.version();
 				response.keep_alive() = request.data.keep_alive();
 
+				route.mRequests->add();
+				metrics::scoped_timer timer(*route.mDuration);
 				route.mFunction(session, response);
 				return true;
 			}
 		}
+
+		static auto& unmatched = metrics::registry::get_counter("http_unmatched_requests_total", "HTTP requests that matched no route.");
+		unmatched.add();
 		return false;
 	}
 
@@ -4,9 +4,13 @@
 
 // Include
 #include "uri.h"
+#include "../utils/compression.h"
+#include "../utils/metrics.h"
 
 #include <boost/beast/core.hpp>
 #include <boost/beast/http.hpp>
+#include <functional>
+#include <memory>
 #include <vector>
 #include <regex>
 
@@ -14,6 +18,17 @@
 namespace HTTP {
 	class Session;
 
+	enum class ContentEncoding : uint8_t {
+		Identity = 0,
+		Gzip,
+		Deflate
+	};
+
+	// The coding the client weighs highest among the ones we can send, gzip wins ties.
+	ContentEncoding negotiate_encoding(boost::beast::string_view acceptEncoding, bool allowDeflate = true);
+
+	bool is_compressible(boost::beast::string_view contentType);
+
 	// Response
 	class Response {
 		public:
@@ -27,12 +42,23 @@ namespace HTTP {
 			uint32_t& version();
 			bool& keep_alive();
 
+			using PrefixFn = std::function<std::shared_ptr<const compression::prefix>()>;
+
+			// The body starts with the data of prefix, only the rest is compressed when the client takes it compressed.
+			void set_compressed_prefix(std::shared_ptr<const compression::prefix> prefix);
+
+			// Same, but the prefix is only asked for when the response is actually sent compressed.
+			void set_compressed_prefix(PrefixFn prefixFn);
+
 			void send(Session& session);
 
 		private:
 			std::map<boost::beast::http::field, std::string> mFields;
 			std::string mBody;
 
+			std::shared_ptr<const compression::prefix> mCompressedPrefix;
+			PrefixFn mCompressedPrefixFn;
+
 			boost::beast::http::status mResult;
 			boost::beast::http::verb mMethod;
 
@@ -64,6 +90,9 @@ namespace HTTP {
 			std::string mPath;
 			std::regex mRegExpr;
 
+			metrics::counter* mRequests = nullptr;
+			metrics::histogram* mDuration = nullptr;
+
 			friend class Router;
 	};
 
@@ -0,0 +1,145 @@
+
+// Include
+#include "sendfile.h"
+
+#if defined(__linux__)
+#	include <sys/sendfile.h>
+#	include <cerrno>
+#elif defined(BOOST_ASIO_HAS_WINDOWS_OVERLAPPED_PTR)
+#	include <mswsock.h>
+#endif
+
+// HTTP
+namespace HTTP {
+	namespace {
+		// Biggest chunk handed to the kernel at once, TransmitFile takes at most 2^31 - 2 bytes per call.
+		constexpr uint64_t MaxChunk = 0x4000'0000;
+
+		// SendFileOperation, keeps the file and the progress alive across waits for the socket.
+		class SendFileOperation : public std::enable_shared_from_this<SendFileOperation> {
+			public:
+				SendFileOperation(boost::asio::ip::tcp::socket& socket, std::shared_ptr<boost::beast::file> file, uint64_t offset, uint64_t length,
+					std::chrono::steady_clock::duration timeout, SendFileHandler handler) :
+					mSocket(socket), mTimer(socket.get_executor()), mFile(std::move(file)), mHandler(std::move(handler)), mTimeout(timeout), mOffset(offset), mRemaining(length) {}
+
+				void run();
+
+			private:
+				void finish(boost::beast::error_code error) {
+					mTimer.cancel();
+					mHandler(mTimedOut ? boost::beast::error::timeout : error, mSent);
+				}
+
+				// Armed again before every wait for the socket, so only a client that stops reading runs into it.
+				void arm_timer() {
+					mTimer.expires_after(mTimeout);
+					mTimer.async_wait([self = shared_from_this()](boost::beast::error_code error) {
+						if (!error) {
+							// Fails the pending wait, which finishes the operation.
+							self->mTimedOut = true;
+
+							boost::beast::error_code ignored;
+							self->mSocket.close(ignored);
+						}
+					});
+				}
+
+				void advance(std::size_t sent) {
+					mOffset += sent;
+					mRemaining -= sent;
+					mSent += sent;
+				}
+
+			private:
+				boost::asio::ip::tcp::socket& mSocket;
+				boost::asio::steady_timer mTimer;
+				std::shared_ptr<boost::beast::file> mFile;
+				SendFileHandler mHandler;
+				std::chrono::steady_clock::duration mTimeout;
+
+				uint64_t mOffset;
+				uint64_t mRemaining;
+				std::size_t mSent = 0;
+
+				bool mTimedOut = false;
+		};
+
+#if defined(__linux__)
+		void SendFileOperation::run() {
+			// sendfile blocks on a blocking socket, asio only tells us when there is room again.
+			boost::beast::error_code error;
+			if (!mSocket.native_non_blocking()) {
+				mSocket.native_non_blocking(true, error);
+				if (error) {
+					return finish(error);
+				}
+			}
+
+			while (mRemaining > 0) {
+				off_t offset = static_cast<off_t>(mOffset);
+				const auto sent = ::sendfile(mSocket.native_handle(), mFile->native_handle(), &offset, static_cast<size_t>(std::min(mRemaining, MaxChunk)));
+				if (sent > 0) {
+					advance(static_cast<std::size_t>(sent));
+				} else if (sent == 0) {
+					// The file got shorter than it was when we sent the header.
+					return finish(boost::asio::error::eof);
+				} else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+					arm_timer();
+					mSocket.async_wait(boost::asio::ip::tcp::socket::wait_write, [self = shared_from_this()](boost::beast::error_code error) {
+						if (error) {
+							self->finish(error);
+						} else {
+							self->run();
+						}
+					});
+					return;
+				} else if (errno != EINTR) {
+					return finish(boost::beast::error_code(errno, boost::system::system_category()));
+				}
+			}
+			finish({});
+		}
+#elif defined(BOOST_ASIO_HAS_WINDOWS_OVERLAPPED_PTR)
+		void SendFileOperation::run() {
+			if (mRemaining == 0) {
+				return finish({});
+			}
+
+			boost::asio::windows::overlapped_ptr overlapped(mSocket.get_executor(), [self = shared_from_this()](boost::beast::error_code error, std::size_t sent) {
+				self->advance(sent);
+				if (error) {
+					self->finish(error);
+				} else if (sent == 0) {
+					self->finish(boost::asio::error::eof);
+				} else {
+					self->run();
+				}
+			});
+
+			arm_timer();
+
+			overlapped.get()->Offset = static_cast<DWORD>(mOffset & 0xFFFFFFFF);
+			overlapped.get()->OffsetHigh = static_cast<DWORD>(mOffset >> 32);
+
+			const auto chunk = static_cast<DWORD>(std::min(mRemaining, MaxChunk));
+			const BOOL ok = ::TransmitFile(mSocket.native_handle(), mFile->native_handle(), chunk, 0, overlapped.get(), nullptr, 0);
+
+			const DWORD lastError = ::GetLastError();
+			if (!ok && lastError != ERROR_IO_PENDING) {
+				overlapped.complete(boost::beast::error_code(lastError, boost::asio::error::get_system_category()), 0);
+			} else {
+				overlapped.release();
+			}
+		}
+#else
+		void SendFileOperation::run() {
+			finish(boost::asio::error::operation_not_supported);
+		}
+#endif
+	}
+
+	void async_send_file(boost::asio::ip::tcp::socket& socket, std::shared_ptr<boost::beast::file> file, uint64_t offset, uint64_t length,
+		std::chrono::steady_clock::duration timeout, SendFileHandler handler) {
+		std::make_shared<SendFileOperation>(socket, std::move(file), offset, length, timeout, std::move(handler))->run();
+	}
+}
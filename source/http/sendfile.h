@@ -0,0 +1,85 @@
+
+#ifndef _HTTP_SENDFILE_HEADER
+#define _HTTP_SENDFILE_HEADER
+
+// Include
+#include <boost/asio.hpp>
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+#include <boost/optional.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+// HTTP
+namespace HTTP {
+	// sendfile(2) on Linux and TransmitFile on Windows hand the file to the kernel, elsewhere it goes through file_range_body.
+#if defined(__linux__) || defined(BOOST_ASIO_HAS_WINDOWS_OVERLAPPED_PTR)
+	constexpr bool HasNativeSendFile = true;
+#else
+	constexpr bool HasNativeSendFile = false;
+#endif
+
+	using SendFileHandler = std::function<void(boost::beast::error_code, std::size_t)>;
+
+	// Writes length bytes of file starting at offset to socket without copying them through user space.
+	// The socket is closed when no data could be sent for timeout, a client that stops reading fails with error::timeout.
+	void async_send_file(boost::asio::ip::tcp::socket& socket, std::shared_ptr<boost::beast::file> file, uint64_t offset, uint64_t length,
+		std::chrono::steady_clock::duration timeout, SendFileHandler handler);
+
+	// file_range_body, length bytes of a file starting at offset, read in chunks.
+	struct file_range_body {
+		struct value_type {
+			std::shared_ptr<boost::beast::file> file;
+			uint64_t offset = 0;
+			uint64_t length = 0;
+		};
+
+		static uint64_t size(const value_type& body) {
+			return body.length;
+		}
+
+		class writer {
+			public:
+				using const_buffers_type = boost::asio::const_buffer;
+
+				template<bool isRequest, class Fields>
+				writer(const boost::beast::http::header<isRequest, Fields>&, const value_type& body) : mBody(body), mRemaining(body.length) {}
+
+				void init(boost::beast::error_code& error) {
+					mBody.file->seek(mBody.offset, error);
+				}
+
+				boost::optional<std::pair<const_buffers_type, bool>> get(boost::beast::error_code& error) {
+					const auto amount = static_cast<std::size_t>(std::min<uint64_t>(mRemaining, sizeof(mBuffer)));
+					if (amount == 0) {
+						error = {};
+						return boost::none;
+					}
+
+					const auto read = mBody.file->read(mBuffer, amount, error);
+					if (error) {
+						return boost::none;
+					}
+
+					if (read == 0) {
+						error = boost::asio::error::eof;
+						return boost::none;
+					}
+
+					mRemaining -= read;
+					return { { const_buffers_type(mBuffer, read), mRemaining > 0 } };
+				}
+
+			private:
+				const value_type& mBody;
+				uint64_t mRemaining;
+				char mBuffer[64 * 1024];
+		};
+	};
+}
+
+#endif
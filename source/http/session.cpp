@@ -1,9 +1,11 @@
 
 // Include
 #include "session.h"
+#include "assetcache.h"
 #include "server.h"
 
 #include "../game/config.h"
+#include "../game/startup.h"
 #include "utils/logger.h"
 
 #include <boost/beast/version.hpp>
@@ -83,7 +85,7 @@ namespace HTTP {
 	void handle_request(Session& session, Router& router) {
 		auto& request = session.get_request().data;
 
-		logger::info("PATH " + std::string(request.target()));
+		LOG_INFO("HTTP request", { { "path", std::string_view(request.target().data(), request.target().size()) } });
 
 		// Returns a bad request response
 		const auto bad_request = [&request](boost::beast::string_view why) {
@@ -113,20 +115,6 @@ namespace HTTP {
 			return response;
 		};
 
-		// Returns a server error response
-		const auto server_error = [&request](boost::beast::string_view what) {
-			boost::beast::http::response<boost::beast::http::string_body> response {
-				boost::beast::http::status::internal_server_error, request.version()
-			};
-
-			response.set(boost::beast::http::field::server, BOOST_BEAST_VERSION_STRING);
-			response.set(boost::beast::http::field::content_type, "text/html");
-			response.keep_alive(request.keep_alive());
-			response.body() = "An error occurred: '" + std::string(what) + "'";
-			response.prepare_payload();
-			return response;
-		};
-
 		// Make sure we can handle the method
 		if (request.method() != boost::beast::http::verb::get && request.method() != boost::beast::http::verb::head && request.method() != boost::beast::http::verb::post) {
 			return session.send(bad_request("Unknown HTTP-method"));
@@ -137,6 +125,21 @@ namespace HTTP {
 			return session.send(bad_request("Illegal request-target"));
 		}
 
+		// Nothing is served until the repositories are loaded, the launcher and the game retry on 503.
+		if (!Game::Startup::IsReady()) {
+			boost::beast::http::response<boost::beast::http::string_body> response {
+				boost::beast::http::status::service_unavailable, request.version()
+			};
+
+			response.set(boost::beast::http::field::server, BOOST_BEAST_VERSION_STRING);
+			response.set(boost::beast::http::field::content_type, "text/html");
+			response.set(boost::beast::http::field::retry_after, "5");
+			response.keep_alive(request.keep_alive());
+			response.body() = "The server is starting up.";
+			response.prepare_payload();
+			return session.send(std::move(response));
+		}
+
 		// Router stuff
 		{
 			Response response;
@@ -151,51 +154,9 @@ namespace HTTP {
 			path.append("index.html");
 		}
 
-		// Attempt to open the file
-		boost::beast::error_code error;
-		boost::beast::http::file_body::value_type body;
-		body.open(path.c_str(), boost::beast::file_mode::scan, error);
-
-		// Handle the case where the file doesn't exist
-		if (error == boost::beast::errc::no_such_file_or_directory) {
+		if (!send_file(session, path, boost::beast::http::status::ok, request.version(), request.keep_alive())) {
 			return session.send(not_found(request.target()));
 		}
-
-		// Handle an unknown error
-		if (error) {
-			return session.send(server_error(error.message()));
-		}
-
-		// Cache the size since we need it after the move
-		const auto size = body.size();
-
-		if (request.method() == boost::beast::http::verb::head) {
-			// Respond to HEAD request
-			boost::beast::http::response<boost::beast::http::empty_body> response {
-				boost::beast::http::status::ok, request.version()
-			};
-
-			response.set(boost::beast::http::field::server, BOOST_BEAST_VERSION_STRING);
-			response.set(boost::beast::http::field::content_type, mime_type(path));
-			response.content_length(size);
-			response.keep_alive(request.keep_alive());
-
-			return session.send(std::move(response));
-		} else {
-			// Respond to GET request
-			boost::beast::http::response<boost::beast::http::file_body> response {
-				std::piecewise_construct,
-				std::make_tuple(std::move(body)),
-				std::make_tuple(boost::beast::http::status::ok, request.version())
-			};
-
-			response.set(boost::beast::http::field::server, BOOST_BEAST_VERSION_STRING);
-			response.set(boost::beast::http::field::content_type, mime_type(path));
-			response.content_length(size);
-			response.keep_alive(request.keep_alive());
-
-			return session.send(std::move(response));
-		}
 	}
 
 	// Session
@@ -210,6 +171,32 @@ namespace HTTP {
 		do_read();
 	}
 
+	void Session::send_file(boost::beast::http::response<boost::beast::http::empty_body>&& header,
+		std::shared_ptr<boost::beast::file> file, uint64_t offset, uint64_t length) {
+		if constexpr (!HasNativeSendFile) {
+			boost::beast::http::response<file_range_body> response {
+				std::move(header), file_range_body::value_type { std::move(file), offset, length }
+			};
+			return send(std::move(response));
+		}
+
+		auto sp = std::make_shared<boost::beast::http::response<boost::beast::http::empty_body>>(std::move(header));
+		mResponse = sp;
+
+		// Write the header, then let the kernel copy the file straight to the socket
+		const bool close = sp->need_eof();
+		boost::beast::http::async_write(mStream, *sp,
+			[self = shared_from_this(), file = std::move(file), offset, length, close](boost::beast::error_code error, std::size_t) {
+				if (error) {
+					return self->handle_write(close, error, 0);
+				}
+
+				async_send_file(self->mStream.socket(), file, offset, length, std::chrono::seconds(30), [self, close](boost::beast::error_code error, std::size_t sent) {
+					self->handle_write(close, error, sent);
+				});
+			});
+	}
+
 	void Session::do_read() {
 		mRequest = {};
 		mStream.expires_after(std::chrono::seconds(30));
@@ -4,6 +4,7 @@
 
 // Include
 #include "uri.h"
+#include "sendfile.h"
 
 #include "../game/user.h"
 
@@ -48,6 +49,10 @@ namespace HTTP {
 					boost::beast::bind_front_handler(&Session::handle_write, shared_from_this(), sp->need_eof()));
 			}
 
+			// Writes header and then length bytes of file from offset, handed to the kernel where possible.
+			void send_file(boost::beast::http::response<boost::beast::http::empty_body>&& header,
+				std::shared_ptr<boost::beast::file> file, uint64_t offset, uint64_t length);
+
 		private:
 			void do_read();
 			void do_close();
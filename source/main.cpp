@@ -4,9 +4,16 @@
 
 #include "http/uri.h"
 #include "game/config.h"
+#include "game/game.h"
+#include "game/leaderboard.h"
+#include "game/startup.h"
+#include "repository/persistence.h"
+#include "utils/functions.h"
 #include "utils/logger.h"
+#include "utils/trace.h"
 
 #include <iostream>
+#include <windows.h>
 
 /*
 
@@ -44,8 +51,23 @@ bool Application::OnInit() {
 	// Config
 	Game::Config::Load("config.xml");
 
-	// Game
+	// Logging
+	logger::options logOptions;
+	logOptions.minimum = logger::parse_level(Game::Config::Get(Game::CONFIG_LOG_LEVEL));
+	logOptions.path = Game::Config::Get(Game::CONFIG_LOG_FILE);
+	logOptions.max_file_size = utils::to_number<uint64_t>(Game::Config::Get(Game::CONFIG_LOG_FILE_SIZE));
+	logOptions.max_files = utils::to_number<uint32_t>(Game::Config::Get(Game::CONFIG_LOG_FILE_COUNT));
+	logger::start(logOptions);
+
+	// Tracing, off unless a file is configured
+	trace::start(Game::Config::Get(Game::CONFIG_TRACE_FILE));
+
+	// Game, the catalogs and stores load in the background while the listeners below are bound
+	Repository::Persistence::Start(mIoService);
+	Game::Startup::Run(mIoService);
+
 	mGameAPI = std::make_unique<Game::API>();
+	Game::Manager::CreateServerPool();
 
 	// Blaze
 	mRedirectorServer = std::make_unique<Blaze::Server>(mIoService, 42127);
@@ -63,18 +85,27 @@ bool Application::OnInit() {
 	mQosServer->set_router(router);
 
 	//
-	mGameAPI->setup();
+	mGameAPI->setup(router);
 
 	return true;
 }
 
 int Application::OnExit() {
+	// Packet captures of running games are written out on the way down. This is also where we end up when
+	// Run stops on an exception, signal handlers are no place for file I/O and walking the game map.
+	Game::Manager::DumpPacketCaptures();
+	Game::Manager::DestroyServerPool();
+	Game::Startup::Stop();
+	Game::Leaderboards::Stop();
+	Repository::Persistence::Stop();
 	mGameAPI.reset();
 	mGmsServer.reset();
 	mRedirectorServer.reset();
 	mBlazeServer.reset();
 	mHttpServer.reset();
 	mQosServer.reset();
+	trace::stop();
+	logger::stop();
 	return 0;
 }
 
@@ -0,0 +1,140 @@
+
+// Include
+#include "capture.h"
+
+#include <InternalPacket.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+// RakNet
+namespace RakNet {
+	// PacketCapture
+	PacketCapture::PacketCapture() = default;
+
+	PacketCapture::~PacketCapture() {
+		delete[] mSlots.load();
+	}
+
+	void PacketCapture::set_enabled(bool enabled) {
+		if (enabled && !mSlots.load(std::memory_order_acquire)) {
+			// The ring is only allocated the first time capture is turned on and lives as long as the plugin.
+			Slot* expected = nullptr;
+			Slot* slots = new Slot[SlotCount];
+			if (!mSlots.compare_exchange_strong(expected, slots, std::memory_order_acq_rel)) {
+				delete[] slots;
+			}
+		}
+		mEnabled.store(enabled, std::memory_order_release);
+	}
+
+	bool PacketCapture::is_enabled() const {
+		return mEnabled.load(std::memory_order_relaxed);
+	}
+
+	bool PacketCapture::dump(const std::string& path, uint32_t gameId) const {
+		const Slot* slots = mSlots.load(std::memory_order_acquire);
+		if (!slots) {
+			return false;
+		}
+
+		struct Entry {
+			uint64_t sequence;
+			Capture::RecordHeader header;
+			std::vector<uint8_t> data;
+		};
+
+		std::vector<Entry> entries;
+		entries.reserve(SlotCount);
+
+		for (size_t i = 0; i < SlotCount; ++i) {
+			const Slot& slot = slots[i];
+
+			uint64_t before = slot.sequence.load(std::memory_order_acquire);
+			if (before == 0 || (before & 1) != 0) {
+				continue;
+			}
+
+			Entry entry;
+			entry.sequence = before;
+			entry.header = slot.header;
+			entry.data.assign(slot.data, slot.data + std::min<size_t>(entry.header.capturedLength, SlotSize));
+
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (slot.sequence.load(std::memory_order_relaxed) == before) {
+				entries.push_back(std::move(entry));
+			}
+		}
+
+		std::sort(entries.begin(), entries.end(), [](const Entry& lhs, const Entry& rhs) {
+			return lhs.sequence < rhs.sequence;
+		});
+
+		std::ofstream file(path, std::ios::binary | std::ios::trunc);
+		if (!file.is_open()) {
+			return false;
+		}
+
+		Capture::FileHeader fileHeader;
+		fileHeader.gameId = gameId;
+		fileHeader.count = static_cast<uint32_t>(entries.size());
+		file.write(reinterpret_cast<const char*>(&fileHeader), sizeof(fileHeader));
+
+		for (const auto& entry : entries) {
+			file.write(reinterpret_cast<const char*>(&entry.header), sizeof(entry.header));
+			file.write(reinterpret_cast<const char*>(entry.data.data()), entry.data.size());
+		}
+
+		return file.good();
+	}
+
+	void PacketCapture::OnDirectSocketSend(const char* data, const BitSize_t bitsUsed, SystemAddress remoteSystemAddress) {
+		Record(Capture::Kind::Datagram, Capture::Direction::Outbound, data, BITS_TO_BYTES(bitsUsed), remoteSystemAddress);
+	}
+
+	void PacketCapture::OnDirectSocketReceive(const char* data, const BitSize_t bitsUsed, SystemAddress remoteSystemAddress) {
+		Record(Capture::Kind::Datagram, Capture::Direction::Inbound, data, BITS_TO_BYTES(bitsUsed), remoteSystemAddress);
+	}
+
+	void PacketCapture::OnInternalPacket(InternalPacket* internalPacket, unsigned /*frameNumber*/, SystemAddress remoteSystemAddress, RakNetTime /*time*/, int isSend) {
+		const auto direction = isSend ? Capture::Direction::Outbound : Capture::Direction::Inbound;
+		Record(Capture::Kind::Message, direction, internalPacket->data, BITS_TO_BYTES(internalPacket->dataBitLength), remoteSystemAddress);
+	}
+
+	void PacketCapture::Record(Capture::Kind kind, Capture::Direction direction, const void* data, size_t length, const SystemAddress& address) {
+		if (!mEnabled.load(std::memory_order_relaxed)) {
+			return;
+		}
+
+		Slot* slots = mSlots.load(std::memory_order_acquire);
+		if (!slots) {
+			return;
+		}
+
+		// Seqlock per slot: odd while being written, 2 * (n + 1) once record n is complete.
+		uint64_t sequence = mHead.fetch_add(1, std::memory_order_relaxed);
+		Slot& slot = slots[sequence % SlotCount];
+
+		slot.sequence.store(2 * sequence + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+
+		const size_t capturedLength = std::min(length, SlotSize);
+
+		auto& header = slot.header;
+		header.timestamp = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+		header.address = address.binaryAddress;
+		header.port = address.port;
+		header.direction = direction;
+		header.kind = kind;
+		header.length = static_cast<uint16_t>(std::min<size_t>(length, 0xFFFF));
+		header.capturedLength = static_cast<uint16_t>(capturedLength);
+		if (data && capturedLength > 0) {
+			std::memcpy(slot.data, data, capturedLength);
+		}
+
+		slot.sequence.store(2 * (sequence + 1), std::memory_order_release);
+	}
+}
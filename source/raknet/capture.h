@@ -0,0 +1,85 @@
+
+#ifndef _RAKNET_CAPTURE_HEADER
+#define _RAKNET_CAPTURE_HEADER
+
+// Include
+#include <PluginInterface2.h>
+#include <MTUSize.h>
+
+#include <cstdint>
+#include <atomic>
+#include <string>
+
+// RakNet
+namespace RakNet {
+	// Capture file: FileHeader, then count * (RecordHeader + capturedLength bytes).
+	namespace Capture {
+		constexpr uint32_t Magic = 0x50414352; // RCAP
+		constexpr uint16_t Version = 1;
+
+		enum class Direction : uint8_t {
+			Inbound = 0,
+			Outbound
+		};
+
+		enum class Kind : uint8_t {
+			Datagram = 0, // raw UDP payload as it hit the socket
+			Message       // reassembled reliability layer message, starts with the message id
+		};
+
+#pragma pack(push, 1)
+		struct FileHeader {
+			uint32_t magic = Magic;
+			uint16_t version = Version;
+			uint32_t gameId = 0;
+			uint32_t count = 0;
+		};
+
+		struct RecordHeader {
+			uint64_t timestamp = 0; // microseconds since epoch
+			uint32_t address = 0;
+			uint16_t port = 0;
+			Direction direction = Direction::Inbound;
+			Kind kind = Kind::Datagram;
+			uint16_t length = 0;
+			uint16_t capturedLength = 0;
+		};
+#pragma pack(pop)
+	}
+
+	// PacketCapture
+	class PacketCapture : public PluginInterface2 {
+		public:
+			static constexpr size_t SlotCount = 2048;
+			static constexpr size_t SlotSize = MAXIMUM_MTU_SIZE;
+
+			PacketCapture();
+			~PacketCapture();
+
+			void set_enabled(bool enabled);
+			bool is_enabled() const;
+
+			bool dump(const std::string& path, uint32_t gameId) const;
+
+			// PluginInterface2
+			void OnDirectSocketSend(const char* data, const BitSize_t bitsUsed, SystemAddress remoteSystemAddress) override;
+			void OnDirectSocketReceive(const char* data, const BitSize_t bitsUsed, SystemAddress remoteSystemAddress) override;
+			void OnInternalPacket(InternalPacket* internalPacket, unsigned frameNumber, SystemAddress remoteSystemAddress, RakNetTime time, int isSend) override;
+
+		private:
+			struct Slot {
+				std::atomic<uint64_t> sequence { 0 };
+				Capture::RecordHeader header;
+				uint8_t data[SlotSize];
+			};
+
+			void Record(Capture::Kind kind, Capture::Direction direction, const void* data, size_t length, const SystemAddress& address);
+
+		private:
+			std::atomic<Slot*> mSlots { nullptr };
+			std::atomic<uint64_t> mHead { 0 };
+			std::atomic<bool> mEnabled { false };
+	};
+}
+
+#endif
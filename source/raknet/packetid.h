@@ -0,0 +1,107 @@
+
+#ifndef _RAKNET_PACKETID_HEADER
+#define _RAKNET_PACKETID_HEADER
+
+// Include
+#include <RakNetTypes.h>
+
+// Every Darkspore message id, the server and the tools build their tables from this one list.
+#define RAKNET_DARKSPORE_PACKET_IDS(X) \
+	X(HelloPlayer, 0x80) \
+	X(ReconnectPlayer, 0x81) \
+	X(Connected, 0x82) \
+	X(Goodbye, 0x83) \
+	X(PlayerJoined, 0x84) \
+	X(PartyMergeComplete, 0x85) \
+	X(PlayerDeparted, 0x86) \
+	X(VoteKickStarted, 0x87) \
+	X(PlayerStatusUpdate, 0x88) \
+	X(GameAborted, 0x89) \
+	X(GameState, 0x8A) \
+	X(DirectorState, 0x8B) \
+	X(ObjectCreate, 0x8C) \
+	X(ObjectUpdate, 0x8D) \
+	X(ObjectDelete, 0x8E) \
+	X(ObjectTeleport, 0x8F) \
+	X(ObjectJump, 0x90) \
+	X(ObjectPlayerMove, 0x91) \
+	X(ForcePhysicsUpdate, 0x92) \
+	X(PhysicsChanged, 0x93) \
+	X(LocomotionDataUpdate, 0x94) \
+	X(LocomotionDataUnreliableUpdate, 0x95) \
+	X(AttributeDataUpdate, 0x96) \
+	X(CombatantDataUpdate, 0x97) \
+	X(InteractableDataUpdate, 0x98) \
+	X(AgentBlackboardUpdate, 0x99) \
+	X(LootDataUpdate, 0x9A) \
+	X(ServerEvent, 0x9B) \
+	X(ActionCommandMsgs, 0x9C) \
+	X(PlayerDamage, 0x9E) \
+	X(LootSpawned, 0x9F) \
+	X(LootAcquired, 0xA0) \
+	X(LabsPlayerUpdate, 0xA1) \
+	X(ModifierCreated, 0xA2) \
+	X(ModifierUpdated, 0xA3) \
+	X(ModifierDeleted, 0xA4) \
+	X(SetAnimationState, 0xA5) \
+	X(SetObjectGfxState, 0xA6) \
+	X(PlayerCharacterDeploy, 0xA7) \
+	X(ActionCommandResponse, 0xA8) \
+	X(ChainPlayerMsgs, 0xA9) \
+	X(ChainVoteMsgs, 0xAA) \
+	X(ChainLevelResultsMsgs, 0xAB) \
+	X(ChainCashOutMsgs, 0xAC) \
+	X(ChainGameMsgs, 0xAD) \
+	X(ChainGameOverMsgs, 0xAE) \
+	X(QuickGameMsgs, 0xAF) \
+	X(GamePrepareForStart, 0xB0) \
+	X(GameStart, 0xB1) \
+	X(CheatMessageDontUseInReleaseButDontChangeTheIndexOfTheMessagesBelowInCaseWeAreRunningOnADevServer, 0xB2) \
+	X(ArenaPlayerMsgs, 0xB3) \
+	X(ArenaLobbyMsgs, 0xB4) \
+	X(ArenaGameMsgs, 0xB5) \
+	X(ArenaResultsMsgs, 0xB6) \
+	X(ObjectivesInitForLevel, 0xB7) \
+	X(ObjectiveUpdated, 0xB8) \
+	X(ObjectivesComplete, 0xB9) \
+	X(JuggernautPlayerMsgs, 0xBA) \
+	X(JuggernautLobbyMsgs, 0xBB) \
+	X(JuggernautGameMsgs, 0xBC) \
+	X(JuggernautResultsMsgs, 0xBD) \
+	X(CombatEvent, 0xBE) \
+	X(ReloadLevel, 0xBF) \
+	X(GravityForceUpdate, 0xC0) \
+	X(CooldownUpdate, 0xC1) \
+	X(CrystalDragMessage, 0xC2) \
+	X(CrystalMessage, 0xC3) \
+	X(KillRacePlayerMsgs, 0xC4) \
+	X(KillRaceLobbyMsgs, 0xC5) \
+	X(KillRaceGameMsgs, 0xC6) \
+	X(KillRaceResultsMsgs, 0xC7) \
+	X(TutorialGameMsgs, 0xC8) \
+	X(CinematicMsgs, 0xC9) \
+	X(ObjectiveAdd, 0xCA) \
+	X(LootDropMessage, 0xCB) \
+	X(DebugPing, 0xCC)
+
+// RakNet
+namespace RakNet {
+	// Packet
+	namespace PacketID {
+#define RAKNET_PACKET_ID(name, value) constexpr MessageID name = value;
+		RAKNET_DARKSPORE_PACKET_IDS(RAKNET_PACKET_ID)
+#undef RAKNET_PACKET_ID
+	}
+
+	// nullptr for ids that are not Darkspore messages.
+	constexpr const char* GetPacketName(MessageID id) {
+		switch (id) {
+#define RAKNET_PACKET_ID(name, value) case value: return #name;
+			RAKNET_DARKSPORE_PACKET_IDS(RAKNET_PACKET_ID)
+#undef RAKNET_PACKET_ID
+			default: return nullptr;
+		}
+	}
+}
+
+#endif
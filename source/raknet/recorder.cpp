@@ -0,0 +1,50 @@
+
+// Include
+#include "recorder.h"
+
+#include <algorithm>
+
+// RakNet
+namespace RakNet {
+	// SessionRecorder
+	bool SessionRecorder::open(const std::string& path, uint32_t gameId) {
+		close();
+
+		mFile.open(path, std::ios::binary | std::ios::trunc);
+		if (!mFile.is_open()) {
+			return false;
+		}
+
+		Recording::FileHeader header;
+		header.gameId = gameId;
+		mFile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+		mStartTime = std::chrono::steady_clock::now();
+		return true;
+	}
+
+	void SessionRecorder::close() {
+		if (mFile.is_open()) {
+			mFile.close();
+		}
+	}
+
+	bool SessionRecorder::is_open() const {
+		return mFile.is_open();
+	}
+
+	void SessionRecorder::record(const Packet* packet) {
+		if (!mFile.is_open() || !packet) {
+			return;
+		}
+
+		Recording::RecordHeader header;
+		header.time = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - mStartTime).count();
+		header.address = packet->systemAddress.binaryAddress;
+		header.port = packet->systemAddress.port;
+		header.length = static_cast<uint16_t>(std::min<uint32_t>(packet->length, 0xFFFF));
+
+		mFile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		mFile.write(reinterpret_cast<const char*>(packet->data), header.length);
+	}
+}
@@ -0,0 +1,52 @@
+
+#ifndef _RAKNET_RECORDER_HEADER
+#define _RAKNET_RECORDER_HEADER
+
+// Include
+#include <RakNetTypes.h>
+
+#include <cstdint>
+#include <chrono>
+#include <fstream>
+#include <string>
+
+// RakNet
+namespace RakNet {
+	// Recording file: FileHeader, then RecordHeader + length bytes for every inbound game message.
+	namespace Recording {
+		constexpr uint32_t Magic = 0x43455252; // RREC
+		constexpr uint16_t Version = 1;
+
+#pragma pack(push, 1)
+		struct FileHeader {
+			uint32_t magic = Magic;
+			uint16_t version = Version;
+			uint32_t gameId = 0;
+		};
+
+		struct RecordHeader {
+			uint64_t time = 0; // microseconds since the recording started
+			uint32_t address = 0;
+			uint16_t port = 0;
+			uint16_t length = 0;
+		};
+#pragma pack(pop)
+	}
+
+	// SessionRecorder
+	class SessionRecorder {
+		public:
+			bool open(const std::string& path, uint32_t gameId);
+			void close();
+
+			bool is_open() const;
+
+			void record(const Packet* packet);
+
+		private:
+			std::ofstream mFile;
+			std::chrono::steady_clock::time_point mStartTime;
+	};
+}
+
+#endif
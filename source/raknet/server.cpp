@@ -3,6 +3,10 @@
 #include "server.h"
 #include "../utils/functions.h"
 #include "../utils/logger.h"
+#include "../utils/metrics.h"
+#include "../utils/trace.h"
+#include "../game/config.h"
+#include "../game/attributes.h"
 #include "../game/creature.h"
 
 #include <MessageIdentifiers.h>
@@ -12,8 +16,10 @@
 #include <BitStream.h>
 #include <GetTime.h>
 
+#include <chrono>
 #include <ctime>
 #include <iomanip>
+#include <sstream>
 #include <iostream>
 #include <algorithm>
 #include <tuple>
@@ -394,122 +400,7 @@ namespace Hash {
 }
 
 // Abilities
-namespace Ability {
-	enum : uint32_t {
-		Strength = 0,
-		Dexterity,
-		Mind,
-		MaxHealthIncrease,
-		MaxHealth,
-		MaxMana,
-		DamageReduction,
-		PhysicalDefense,
-		PhysicalDamageReduction,
-		EnergyDefense,
-		CriticalRating,
-		NonCombatSpeed,
-		CombatSpeed,
-		DamageBuff,
-		Silence,
-		Immobilized,
-		DefenseBoostBasicDamage,
-		PhysicalDamageIncrease,
-		PhysicalDamageIncreaseFlat,
-		AutoCrit,
-		BehindDirectDamageIncrease,
-		BehindOrSideDirectDamageIncrease,
-		CriticalDamageIncrease,
-		AttackSpeedScale,
-		CooldownScale,
-		Frozen,
-		ProjectileSpeedIncrease,
-		AoeResistance,
-		EnergyDamageBuff,
-		Intangible,
-		HealingReduction,
-		EnergyDamageIncrease,
-		EnergyDamageIncreaseFlat,
-		Immune,
-		StealthDetection,
-		LifeSteal,
-		RejectModifier,
-		AoeDamage,
-		TechnologyTypeDamage,
-		SpacetimeTypeDamage,
-		LifeTypeDamage,
-		ElementsTypeDamage,
-		SupernaturalTypeDamage,
-		TechnologyTypeResistance,
-		SpacetimeTypeResistance,
-		LifeTypeResistance,
-		ElementsTypeResistance,
-		SupernaturalTypeResistance,
-		MovementSpeedBuff,
-		ImmuneToDebuffs,
-		BuffDuration,
-		DebuffDuration,
-		ManaSteal,
-		DebuffDurationIncrease,
-		EnergyDamageReduction,
-		Incorporeal,
-		DotDamageIncrease,
-		MindControlled,
-		SwapDisabled,
-		ImmuneToRandomTeleport,
-		ImmuneToBanish,
-		ImmuneToKnockback,
-		AoeRadius,
-		PetDamage,
-		PetHealth,
-		CrystalFind,
-		DNADropped,
-		RangeIncrease,
-		OrbEffectiveness,
-		OverdriveBuildup,
-		OverdriveDuration,
-		LootFind,
-		Surefooted,
-		ImmuneToStunned,
-		ImmuneToSleep,
-		ImmuneToTerrified,
-		ImmuneToSilence,
-		ImmuneToCursed,
-		ImmuneToPoisonOrDisease,
-		ImmuneToBurning,
-		ImmuneToRooted,
-		ImmuneToSlow,
-		ImmuneToPull,
-		DotDamageDoneIncrease,
-		AggroIncrease,
-		AggroDecrease,
-		PhysicalDamageDoneIncrease,
-		PhysicalDamageDoneByAbilityIncrease,
-		EnergyDamageDoneIncrease,
-		EnergyDamageDoneByAbilityIncrease,
-		ChannelTimeDecrease,
-		CrowdControlDurationDecrease,
-		DotDurationDecrease,
-		AoeDurationIncrease,
-		HealIncrease,
-		OnLockdown,
-		HoTDoneIncrease,
-		ProjectileDamageIncrease,
-		DeployBonusInvincibilityTime,
-		PhysicalDamageDecreaseFlat,
-		EnergyDamageDecreaseFlat,
-		MinWeaponDamage,
-		MaxWeaponDamage,
-		MinWeaponDamagePercent,
-		MaxWeaponDamagePercent,
-		DirectAttackDamage,
-		DirectAttackDamagePercent,
-		GetHitAnimDisabled,
-		XPBoost,
-		InvisibleToSecurityTeleporters,
-		BodyScale,
-		Count
-	};
-}
+namespace Ability = Game::Attribute;
 
 using tObjID = uint32_t;
 
@@ -580,8 +471,16 @@ struct labsCharacter {
 	float mGearScore = 300.f;
 	float mGearScoreFlattened = 300.f;
 
-	// make some sort of map?
-	float mAttribute[Ability::Count];
+	float mAttribute[Ability::Count] {};
+
+	void SetStats(const Game::CreatureStats& stats) {
+		std::copy_n(stats.attributes.values.begin(), Ability::Count, mAttribute);
+
+		mMaxHealthPoints = stats.maxHealth;
+		mHealthPoints = stats.maxHealth;
+		mMaxManaPoints = stats.maxMana;
+		mManaPoints = stats.maxMana;
+	}
 
 	void WriteTo(RakNet::BitStream& stream) const {
 		constexpr auto size = bytes_to_bits(0x620);
@@ -647,43 +546,8 @@ struct labsCharacter {
 };
 
 struct labsCrystal {
-	enum Type {
-		AoEDamage = 0,
-		AttackSpeed,
-		BuffDuration,
-		CCReduction,
-		Cooldown,
-		Crit,
-		Damage,
-		DamageAura,
-		DebuffDuration,
-		DebuffIncrease,
-		DefenseRating,
-		DeflectionRating,
-		Dexterity,
-		DodgeRating,
-		Health,
-		ImmunePoison,
-		ImmuneSleep,
-		ImmuneSlow,
-		ImmuneStun,
-		Knockback,
-		LifeLeech,
-		Mana,
-		ManaCostReduction,
-		ManaLeech,
-		Mind,
-		MoveSpeed,
-		OrbEffectiveness,
-		OverdriveBuildup,
-		PetDamage,
-		PetHealth,
-		ProjectileSpeed,
-		RangeIncrease,
-		Strength,
-		Surefooted,
-		Thorns
-	};
+	using Type = Game::Crystal::Type;
+	using enum Game::Crystal::Type;
 
 	uint32_t crystalNoun;
 	uint16_t level;
@@ -1366,6 +1230,22 @@ struct ServerEvent {
 
 // RakNet
 namespace RakNet {
+	namespace {
+		metrics::histogram& GetPacketMetric(uint8_t packetType) {
+			// Created on first use, game servers run on their own threads so the slots are atomic.
+			static std::array<std::atomic<metrics::histogram*>, 256> packetMetrics {};
+
+			auto metric = packetMetrics[packetType].load(std::memory_order_acquire);
+			if (!metric) {
+				metric = &metrics::registry::get_histogram("raknet_packet_duration_seconds", "Time spent handling game packets.", {
+					{ "packet", std::to_string(packetType) }
+				});
+				packetMetrics[packetType].store(metric, std::memory_order_release);
+			}
+			return *metric;
+		}
+	}
+
 	enum GState : int32_t {
 		Boot = 0,
 		Login,
@@ -1413,26 +1293,74 @@ namespace RakNet {
 	};
 
 	// Server
-	Server::Server(uint16_t port, uint32_t gameId) : mGameId(gameId) {
-		mThread = std::thread([this, port] {
+	CharacterStatsProvider Server::sCharacterStatsProvider;
+
+	void Server::SetCharacterStatsProvider(CharacterStatsProvider provider) {
+		sCharacterStatsProvider = std::move(provider);
+	}
+
+	Server::Server(uint16_t port, uint32_t gameId) : mGameId(gameId), mPort(port) {
+		std::promise<void> started;
+		auto startedFuture = started.get_future();
+
+		mCapture.set_enabled(Game::Config::GetBool(Game::CONFIG_PACKET_CAPTURE));
+		mThread = std::thread([this, port, &started] {
 			mSelf = RakNetworkFactory::GetRakPeerInterface();
 			mSelf->SetTimeoutTime(30000, UNASSIGNED_SYSTEM_ADDRESS);
-#ifdef PACKET_LOGGING
-			mSelf->AttachPlugin(&mLogger);
-#endif
-			if (mSelf->Startup(4, 30, &SocketDescriptor(port, nullptr), 1)) {
+			mSelf->AttachPlugin(&mCapture);
+
+			SocketDescriptor socketDescriptor(port, nullptr);
+			const bool bound = mSelf->Startup(4, 30, &socketDescriptor, 1);
+			if (bound) {
+				mPort = mSelf->GetInternalID().port;
+			} else {
+				logger::error("Could not start a game server on port " + std::to_string(port));
+				mPort = 0;
+			}
+			started.set_value();
+
+			if (bound) {
 				mSelf->SetMaximumIncomingConnections(4);
 				mSelf->SetOccasionalPing(true);
 				mSelf->SetUnreliableTimeout(1000);
 				while (is_running()) {
+					if (mResetPending.exchange(false)) {
+						ResetConnections();
+					}
+					if (mRecordingPending.exchange(false)) {
+						ApplyRecordingChange();
+					}
+
+					const auto tickStart = std::chrono::steady_clock::now();
 					run_one();
-					RakSleep(30);
+
+					const auto elapsed = std::chrono::steady_clock::now() - tickStart;
+					const auto elapsedMicroseconds = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count());
+
+					mTicks.fetch_add(1, std::memory_order_relaxed);
+					if (elapsedMicroseconds > mMaxTickMicroseconds.load(std::memory_order_relaxed)) {
+						mMaxTickMicroseconds.store(elapsedMicroseconds, std::memory_order_relaxed);
+					}
+
+					static auto& tickDuration = metrics::registry::get_histogram("raknet_tick_duration_seconds", "Time spent in one game server tick.");
+					static auto& tickOverruns = metrics::registry::get_counter("raknet_tick_overruns_total", "Game server ticks that took longer than the tick interval.");
+					tickDuration.observe(elapsed);
+
+					if (elapsed < TickInterval) {
+						RakSleep(static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::milliseconds>(TickInterval - elapsed).count()));
+					} else {
+						mTickOverruns.fetch_add(1, std::memory_order_relaxed);
+						tickOverruns.add();
+					}
 				}
 			}
 
+			mRecorder.close();
 			mSelf->Shutdown(300);
 			RakNetworkFactory::DestroyRakPeerInterface(mSelf);
 		});
+
+		startedFuture.wait();
 	}
 
 	Server::~Server() {
@@ -1453,6 +1381,82 @@ namespace RakNet {
 		return mRunning;
 	}
 
+	void Server::assign(uint32_t gameId) {
+		// Tick stats are per game, not per pooled server.
+		mTicks = 0;
+		mTickOverruns = 0;
+		mMaxTickMicroseconds = 0;
+		mGameId = gameId;
+	}
+
+	void Server::release() {
+		// Connections are dropped on the server thread before the next run_one.
+		mGameId = InvalidGameId;
+		mTraceId = 0;
+		mResetPending = true;
+	}
+
+	bool Server::is_assigned() const {
+		return mGameId != InvalidGameId;
+	}
+
+	void Server::set_capture(bool enabled) {
+		mCapture.set_enabled(enabled);
+	}
+
+	bool Server::is_capturing() const {
+		return mCapture.is_enabled();
+	}
+
+	bool Server::dump_capture(const std::string& path) const {
+		return mCapture.dump(path, mGameId);
+	}
+
+	void Server::start_recording(const std::string& path) {
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mRecordingPath = path;
+		}
+		mRecordingPending = true;
+	}
+
+	void Server::stop_recording() {
+		start_recording(std::string());
+	}
+
+	TickStats Server::get_tick_stats() const {
+		TickStats stats;
+		stats.ticks = mTicks.load(std::memory_order_relaxed);
+		stats.overruns = mTickOverruns.load(std::memory_order_relaxed);
+		stats.maxMicroseconds = mMaxTickMicroseconds.load(std::memory_order_relaxed);
+		return stats;
+	}
+
+	void Server::ApplyRecordingChange() {
+		std::string path;
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			path = mRecordingPath;
+		}
+
+		if (path.empty()) {
+			mRecorder.close();
+		} else if (!mRecorder.open(path, mGameId)) {
+			logger::error("Could not open session recording " + path);
+		}
+	}
+
+	void Server::ResetConnections() {
+		SystemAddress addresses[4];
+		uint16_t count = 4;
+		if (mSelf->GetConnectionList(addresses, &count)) {
+			for (uint16_t i = 0; i < count; ++i) {
+				mSelf->CloseConnection(addresses[i], true);
+			}
+		}
+		mInStream.Reset();
+	}
+
 	void Server::run_one() {
 		const auto GetPacketIdentifier = [this]() -> MessageID {
 			uint8_t message;
@@ -1472,13 +1476,27 @@ namespace RakNet {
 		};
 
 		for (Packet* packet = mSelf->Receive(); packet; mSelf->DeallocatePacket(packet), packet = mSelf->Receive()) {
-			mInStream = BitStream(packet->data, packet->bitSize * 8, false);
+			BindInStream(packet);
 
 			uint8_t packetType = GetPacketIdentifier();
-			logger::warn("--- "  + std::to_string((int)packetType) + " gotten from raknet ---");
+			LOG_DEBUG("RakNet packet", { { "type", static_cast<int>(packetType) } });
+
+			const auto handleStart = std::chrono::steady_clock::now();
+			if (packetType >= ID_USER_PACKET_ENUM) {
+				mRecorder.record(packet);
+			}
+
 			switch (packetType) {
 				case ID_DISCONNECTION_NOTIFICATION:    logger::warn("ID_DISCONNECTION_NOTIFICATION from " + std::string(packet->systemAddress.ToString(true))); break;
-				case ID_NEW_INCOMING_CONNECTION:       OnNewIncomingConnection(packet); break;
+				case ID_NEW_INCOMING_CONNECTION: {
+					if (is_assigned()) {
+						OnNewIncomingConnection(packet);
+					} else {
+						logger::warn("Rejected connection to idle game server on port " + std::to_string(mPort));
+						mSelf->CloseConnection(packet->systemAddress, true);
+					}
+					break;
+				}
 				case ID_CONNECTION_REQUEST:            logger::warn("Trying to connect to RakNet"); break;
 				case ID_INCOMPATIBLE_PROTOCOL_VERSION: logger::warn("ID_INCOMPATIBLE_PROTOCOL_VERSION"); break;
 				case ID_CONNECTION_LOST:               logger::warn("ID_CONNECTION_LOST from " + std::string(packet->systemAddress.ToString(true))); break;
@@ -1490,9 +1508,31 @@ namespace RakNet {
 					break;
 				}
 			}
+
+			if (packetType >= ID_USER_PACKET_ENUM) {
+				const uint64_t elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - handleStart).count();
+
+				auto& stats = mMessageStats[packetType];
+				stats.count++;
+				stats.totalNanoseconds += elapsed;
+				stats.maxNanoseconds = std::max(stats.maxNanoseconds, elapsed);
+
+				GetPacketMetric(packetType).observe(elapsed);
+			}
 		}
 
+		BindInStream(nullptr);
+	}
+
+	void Server::BindInStream(Packet* packet) {
+		// Reads straight out of the RakNet packet, the stream never owns or copies the data.
 		mInStream.Reset();
+		if (packet) {
+			mInStream.SetData(packet->data);
+			mInStream.SetWriteOffset(packet->length << 3);
+		} else {
+			mInStream.SetData(nullptr);
+		}
 	}
 
 	void Server::ParsePacket(Packet* packet, MessageID packetType) {
@@ -1509,10 +1549,12 @@ namespace RakNet {
 	}
 
 	void Server::OnNewIncomingConnection(Packet* packet) {
+		trace::span span(mTraceId, trace::track::raknet, "NewIncomingConnection", { { "game", mGameId.load() }, { "port", mPort } });
 		SendConnected(packet);
 	}
 
 	void Server::OnHelloPlayer(Packet* packet) {
+		trace::span span(mTraceId, trace::track::raknet, "HelloPlayer", { { "game", mGameId.load() } });
 		SendHelloPlayer(packet);
 		// if ok
 		SendPlayerJoined(packet);
@@ -1536,6 +1578,7 @@ namespace RakNet {
 		uint8_t value;
 		mInStream.Read<uint8_t>(value);
 
+		trace::span span(mTraceId, trace::track::raknet, "PlayerStatusUpdate", { { "game", mGameId.load() }, { "status", value } });
 		logger::info("Player Status Update: " + (int)value);
 
 		switch (value) {
@@ -1565,17 +1608,22 @@ namespace RakNet {
 	}
 
 	void Server::OnActionCommandMsgs(Packet* packet) {
-		std::cout << "OnActionCommandMsgs" << std::endl;
-		std::cout << std::hex;
+		// Clients (and the bots) send these at a steady rate, only dump them when debugging.
+		if (!logger::enabled(logger::level::debug)) {
+			return;
+		}
+
+		std::ostringstream stream;
+		stream << std::hex << std::setfill('0');
 
 		uint32_t value;
 		for (size_t i = 0; i < 16; ++i) {
 			mInStream.Read<uint32_t>(value);
 			for (size_t j = 0; j < 4; ++j) {
-				std::cout << std::setw(2) << std::setfill('0') << static_cast<int>(reinterpret_cast<uint8_t*>(&value)[j]) << " ";
+				stream << std::setw(2) << static_cast<int>(reinterpret_cast<uint8_t*>(&value)[j]) << " ";
 			}
 		}
-		std::cout << std::resetiosflags(0) << std::endl;
+		logger::write(logger::level::debug, "OnActionCommandMsgs " + stream.str());
 	}
 	
 	void Server::OnDebugPing(Packet* packet) {
@@ -1613,74 +1661,74 @@ namespace RakNet {
 			u16: port
 		*/
 
-		BitStream outStream(8);
-		outStream.Write(PacketID::HelloPlayer);
-		outStream.Write<uint8_t>(0x01); // Player id?
-		outStream.Write<uint8_t>(mGameId);
-		outStream.WriteBits(reinterpret_cast<const uint8_t*>(&addr.binaryAddress), sizeof(addr.binaryAddress) * 8, true);
-		outStream.Write(addr.port);
+		auto outStream = mStreamPool.acquire(0x08);
+		outStream->Write(PacketID::HelloPlayer);
+		outStream->Write<uint8_t>(0x01); // Player id?
+		outStream->Write<uint8_t>(mGameId);
+		outStream->WriteBits(reinterpret_cast<const uint8_t*>(&addr.binaryAddress), sizeof(addr.binaryAddress) * 8, true);
+		outStream->Write(addr.port);
 
-		mSelf->Send(&outStream, HIGH_PRIORITY, UNRELIABLE_WITH_ACK_RECEIPT, 0, packet->systemAddress, false);
+		mSelf->Send(outStream.get(), HIGH_PRIORITY, UNRELIABLE_WITH_ACK_RECEIPT, 0, packet->systemAddress, false);
 	}
 
 	void Server::SendConnected(Packet* packet) {
 		// TODO: verify incoming connection
 
-		BitStream outStream(8);
-		outStream.Write(PacketID::Connected);
+		auto outStream = mStreamPool.acquire(0x00);
+		outStream->Write(PacketID::Connected);
 
-		mSelf->Send(&outStream, HIGH_PRIORITY, UNRELIABLE_WITH_ACK_RECEIPT, 0, packet->systemAddress, false);
+		mSelf->Send(outStream.get(), HIGH_PRIORITY, UNRELIABLE_WITH_ACK_RECEIPT, 0, packet->systemAddress, false);
 	}
 
 	void Server::SendPlayerJoined(Packet* packet) {
 		// Packet size: 0x01
-		BitStream outStream(8);
-		outStream.Write(PacketID::PlayerJoined);
-		outStream.Write<uint8_t>(mGameId);
+		auto outStream = mStreamPool.acquire(0x01);
+		outStream->Write(PacketID::PlayerJoined);
+		outStream->Write<uint8_t>(mGameId);
 
-		mSelf->Send(&outStream, HIGH_PRIORITY, UNRELIABLE_WITH_ACK_RECEIPT, 0, packet->systemAddress, false);
+		mSelf->Send(outStream.get(), HIGH_PRIORITY, UNRELIABLE_WITH_ACK_RECEIPT, 0, packet->systemAddress, false);
 	}
 
 	void Server::SendPlayerDeparted(Packet* packet) {
 		// Packet size: 0x01
-		BitStream outStream(8);
-		outStream.Write(PacketID::PlayerDeparted);
-		outStream.Write<uint8_t>(mGameId);
+		auto outStream = mStreamPool.acquire(0x01);
+		outStream->Write(PacketID::PlayerDeparted);
+		outStream->Write<uint8_t>(mGameId);
 
-		mSelf->Send(&outStream, HIGH_PRIORITY, UNRELIABLE_WITH_ACK_RECEIPT, 0, packet->systemAddress, false);
+		mSelf->Send(outStream.get(), HIGH_PRIORITY, UNRELIABLE_WITH_ACK_RECEIPT, 0, packet->systemAddress, false);
 	}
 
 	void Server::SendPlayerStatusUpdate(Packet* packet, Blaze::PlayerState playerState) {
-		BitStream outStream(8);
-		outStream.Write(PacketID::PlayerStatusUpdate);
-		outStream.Write<uint8_t>(static_cast<uint8_t>(playerState));
+		auto outStream = mStreamPool.acquire(0x01);
+		outStream->Write(PacketID::PlayerStatusUpdate);
+		outStream->Write<uint8_t>(static_cast<uint8_t>(playerState));
 
-		mSelf->Send(&outStream, HIGH_PRIORITY, UNRELIABLE_WITH_ACK_RECEIPT, 0, packet->systemAddress, false);
+		mSelf->Send(outStream.get(), HIGH_PRIORITY, UNRELIABLE_WITH_ACK_RECEIPT, 0, packet->systemAddress, false);
 	}
 
 	void Server::SendGameState(Packet* packet, uint32_t gameState) {
 		// Packet size: 0x19
-		BitStream outStream(8);
-		outStream.Write(PacketID::GameState);
+		auto outStream = mStreamPool.acquire(0x19);
+		outStream->Write(PacketID::GameState);
 
-		Write<uint32_t>(outStream, gameState);
-		Write<uint32_t>(outStream, 0x99);
-		Write<uint32_t>(outStream, 0x82);
-		Write<uint32_t>(outStream, 0x66);
-		Write<uint32_t>(outStream, 0x31);
-		Write<uint8_t>(outStream, 0x00);
-		Write<uint32_t>(outStream, 0x52);
+		Write<uint32_t>(*outStream, gameState);
+		Write<uint32_t>(*outStream, 0x99);
+		Write<uint32_t>(*outStream, 0x82);
+		Write<uint32_t>(*outStream, 0x66);
+		Write<uint32_t>(*outStream, 0x31);
+		Write<uint8_t>(*outStream, 0x00);
+		Write<uint32_t>(*outStream, 0x52);
 
-		mSelf->Send(&outStream, HIGH_PRIORITY, UNRELIABLE_WITH_ACK_RECEIPT, 0, packet->systemAddress, false);
+		mSelf->Send(outStream.get(), HIGH_PRIORITY, UNRELIABLE_WITH_ACK_RECEIPT, 0, packet->systemAddress, false);
 	}
 
 	void Server::SendLabsPlayerUpdate(Packet* packet, bool fullUpdate) {
-		BitStream outStream(8);
-		outStream.Write(PacketID::LabsPlayerUpdate);
+		auto outStream = mStreamPool.acquire(0x2000);
+		outStream->Write(PacketID::LabsPlayerUpdate);
 
 		// Player ID?
-		Write<uint8_t>(outStream, 0x01);
-		Write<uint16_t>(outStream, fullUpdate ? 0x1000 : 0x0000);
+		Write<uint8_t>(*outStream, 0x01);
+		Write<uint16_t>(*outStream, fullUpdate ? 0x1000 : 0x0000);
 
 		labsPlayer player;
 		player.mPlayerOnlineId = 0x01;
@@ -1709,28 +1757,37 @@ namespace RakNet {
 		// Crystals
 		player.mCrystals[0] = labsCrystal(labsCrystal::Damage, 0, true);
 
+		const Game::CrystalBonus crystals[] = {
+			{ labsCrystal::Damage, 0, true }
+		};
+
+		Game::CreatureStats stats;
+		if (sCharacterStatsProvider && sCharacterStatsProvider(player.mCharacters[0].nounDef, crystals, stats)) {
+			player.mCharacters[0].SetStats(stats);
+		}
+
 		// write player
-		player.WriteReflection(outStream);
+		player.WriteReflection(*outStream);
 
 		// write characters
 		for (const auto& character : player.mCharacters) {
-			character.WriteReflection(outStream);
+			character.WriteReflection(*outStream);
 		}
 
 		// write crystals
 		for (const auto& crystal : player.mCrystals) {
-			crystal.WriteReflection(outStream);
+			crystal.WriteReflection(*outStream);
 		}
 
-		mSelf->Send(&outStream, HIGH_PRIORITY, UNRELIABLE_WITH_ACK_RECEIPT, 0, packet->systemAddress, false);
+		mSelf->Send(outStream.get(), HIGH_PRIORITY, UNRELIABLE_WITH_ACK_RECEIPT, 0, packet->systemAddress, false);
 	}
 
 	void Server::SendDirectorState(Packet* packet) {
 		// Packet size: reflection(variable)
-		BitStream outStream(8);
-		outStream.Write(PacketID::DirectorState);
+		auto outStream = mStreamPool.acquire(0x00);
+		outStream->Write(PacketID::DirectorState);
 
-		mSelf->Send(&outStream, HIGH_PRIORITY, UNRELIABLE_WITH_ACK_RECEIPT, 0, packet->systemAddress, false);
+		mSelf->Send(outStream.get(), HIGH_PRIORITY, UNRELIABLE_WITH_ACK_RECEIPT, 0, packet->systemAddress, false);
 	}
 
 	void Server::SendPlayerCharacterDeploy(Packet* packet, uint32_t id) {
@@ -1764,23 +1821,23 @@ namespace RakNet {
 		constexpr uint32_t hash_none = utils::hash_id("none");
 
 		// Packet size: 0x09
-		BitStream outStream(8);
-		outStream.Write(PacketID::PlayerCharacterDeploy);
+		auto outStream = mStreamPool.acquire(0x09);
+		outStream->Write(PacketID::PlayerCharacterDeploy);
 
-		Write<uint32_t>(outStream, static_cast<uint32_t>(Game::CreatureTemplateID::BlitzAlpha));
-		Write<uint8_t>(outStream, 0x01);
-		Write<uint32_t>(outStream, id);
+		Write<uint32_t>(*outStream, static_cast<uint32_t>(Game::CreatureTemplateID::BlitzAlpha));
+		Write<uint8_t>(*outStream, 0x01);
+		Write<uint32_t>(*outStream, id);
 
-		mSelf->Send(&outStream, HIGH_PRIORITY, UNRELIABLE_WITH_ACK_RECEIPT, 0, packet->systemAddress, false);
+		mSelf->Send(outStream.get(), HIGH_PRIORITY, UNRELIABLE_WITH_ACK_RECEIPT, 0, packet->systemAddress, false);
 	}
 
 	void Server::SendObjectCreate(Packet* packet, uint32_t id, uint32_t noun) {
 		// Packet size: 0x04
-		BitStream outStream(8);
-		outStream.Write(PacketID::ObjectCreate);
+		auto outStream = mStreamPool.acquire(0x04);
+		outStream->Write(PacketID::ObjectCreate);
 
 		// set object id to 1?
-		Write<uint32_t>(outStream, id);
+		Write<uint32_t>(*outStream, id);
 
 		// reflection
 		cGameObjectCreateData data;
@@ -1794,160 +1851,160 @@ namespace RakNet {
 			data.team = 0;
 			data.hasCollision = true;
 			data.playerControlled = true;
-		data.WriteReflection(outStream);
+		data.WriteReflection(*outStream);
 
 		sporelabsObject sporeObject(data);
 			sporeObject.mPlayerIdx = 0x01;
-		sporeObject.WriteReflection(outStream);
+		sporeObject.WriteReflection(*outStream);
 
-		mSelf->Send(&outStream, HIGH_PRIORITY, UNRELIABLE_WITH_ACK_RECEIPT, 0, packet->systemAddress, false);
+		mSelf->Send(outStream.get(), HIGH_PRIORITY, UNRELIABLE_WITH_ACK_RECEIPT, 0, packet->systemAddress, false);
 	}
 
 	void Server::SendObjectUpdate(Packet* packet) {
 		// Packet size: 0x04
-		BitStream outStream(8);
-		outStream.Write(PacketID::ObjectUpdate);
+		auto outStream = mStreamPool.acquire(0x04);
+		outStream->Write(PacketID::ObjectUpdate);
 
-		mSelf->Send(&outStream, HIGH_PRIORITY, UNRELIABLE_WITH_ACK_RECEIPT, 0, packet->systemAddress, false);
+		mSelf->Send(outStream.get(), HIGH_PRIORITY, UNRELIABLE_WITH_ACK_RECEIPT, 0, packet->systemAddress, false);
 	}
 
 	void Server::SendObjectDelete(Packet* packet) {
 		// Packet size: 0x04
-		BitStream outStream(8);
-		outStream.Write(PacketID::ObjectDelete);
+		auto outStream = mStreamPool.acquire(0x04);
+		outStream->Write(PacketID::ObjectDelete);
 
-		mSelf->Send(&outStream, HIGH_PRIORITY, UNRELIABLE_WITH_ACK_RECEIPT, 0, packet->systemAddress, false);
+		mSelf->Send(outStream.get(), HIGH_PRIORITY, UNRELIABLE_WITH_ACK_RECEIPT, 0, packet->systemAddress, false);
 	}
 
 	void Server::SendActionCommandResponse(Packet* packet) {
 		// Packet size: 0x2C
-		BitStream outStream(8);
-		outStream.Write(PacketID::ActionCommandResponse);
+		auto outStream = mStreamPool.acquire(0x2C);
+		outStream->Write(PacketID::ActionCommandResponse);
 
-		mSelf->Send(&outStream, HIGH_PRIORITY, UNRELIABLE_WITH_ACK_RECEIPT, 0, packet->systemAddress, false);
+		mSelf->Send(outStream.get(), HIGH_PRIORITY, UNRELIABLE_WITH_ACK_RECEIPT, 0, packet->systemAddress, false);
 	}
 
 	void Server::SendObjectPlayerMove(Packet* packet) {
 		// Packet size: 0x20
-		BitStream outStream(8);
-		outStream.Write(PacketID::ObjectPlayerMove);
+		auto outStream = mStreamPool.acquire(0x20);
+		outStream->Write(PacketID::ObjectPlayerMove);
 
-		mSelf->Send(&outStream, HIGH_PRIORITY, UNRELIABLE_WITH_ACK_RECEIPT, 0, packet->systemAddress, false);
+		mSelf->Send(outStream.get(), HIGH_PRIORITY, UNRELIABLE_WITH_ACK_RECEIPT, 0, packet->systemAddress, false);
 	}
 
 	void Server::SendObjectTeleport(Packet* packet) {
 		// Packet size: 0x50
-		BitStream outStream(8);
-		outStream.Write(PacketID::ObjectTeleport);
+		auto outStream = mStreamPool.acquire(0x50);
+		outStream->Write(PacketID::ObjectTeleport);
 
-		mSelf->Send(&outStream, HIGH_PRIORITY, UNRELIABLE_WITH_ACK_RECEIPT, 0, packet->systemAddress, false);
+		mSelf->Send(outStream.get(), HIGH_PRIORITY, UNRELIABLE_WITH_ACK_RECEIPT, 0, packet->systemAddress, false);
 	}
 
 	void Server::SendForcePhysicsUpdate(Packet* packet) {
 		// Packet size: 0x28
-		BitStream outStream(8);
-		outStream.Write(PacketID::ForcePhysicsUpdate);
+		auto outStream = mStreamPool.acquire(0x28);
+		outStream->Write(PacketID::ForcePhysicsUpdate);
 
-		mSelf->Send(&outStream, HIGH_PRIORITY, UNRELIABLE_WITH_ACK_RECEIPT, 0, packet->systemAddress, false);
+		mSelf->Send(outStream.get(), HIGH_PRIORITY, UNRELIABLE_WITH_ACK_RECEIPT, 0, packet->systemAddress, false);
 	}
 
 	void Server::SendPhysicsChanged(Packet* packet) {
 		// Packet size: 0x05
-		BitStream outStream(8);
-		outStream.Write(PacketID::PhysicsChanged);
+		auto outStream = mStreamPool.acquire(0x05);
+		outStream->Write(PacketID::PhysicsChanged);
 
-		mSelf->Send(&outStream, HIGH_PRIORITY, UNRELIABLE_WITH_ACK_RECEIPT, 0, packet->systemAddress, false);
+		mSelf->Send(outStream.get(), HIGH_PRIORITY, UNRELIABLE_WITH_ACK_RECEIPT, 0, packet->systemAddress, false);
 	}
 
 	void Server::SendLocomotionDataUpdate(Packet* packet) {
 		// Packet size: 0x04
-		BitStream outStream(8);
-		outStream.Write(PacketID::LocomotionDataUpdate);
+		auto outStream = mStreamPool.acquire(0x04);
+		outStream->Write(PacketID::LocomotionDataUpdate);
 
-		mSelf->Send(&outStream, HIGH_PRIORITY, UNRELIABLE_WITH_ACK_RECEIPT, 0, packet->systemAddress, false);
+		mSelf->Send(outStream.get(), HIGH_PRIORITY, UNRELIABLE_WITH_ACK_RECEIPT, 0, packet->systemAddress, false);
 	}
 
 	void Server::SendLocomotionDataUnreliableUpdate(Packet* packet) {
 		// Packet size: 0x10
-		BitStream outStream(8);
-		outStream.Write(PacketID::LocomotionDataUnreliableUpdate);
+		auto outStream = mStreamPool.acquire(0x10);
+		outStream->Write(PacketID::LocomotionDataUnreliableUpdate);
 
-		mSelf->Send(&outStream, HIGH_PRIORITY, UNRELIABLE_WITH_ACK_RECEIPT, 0, packet->systemAddress, false);
+		mSelf->Send(outStream.get(), HIGH_PRIORITY, UNRELIABLE_WITH_ACK_RECEIPT, 0, packet->systemAddress, false);
 	}
 
 	void Server::SendAttributeDataUpdate(Packet* packet) {
 		// Packet size: 0x04
-		BitStream outStream(8);
-		outStream.Write(PacketID::AttributeDataUpdate);
+		auto outStream = mStreamPool.acquire(0x04);
+		outStream->Write(PacketID::AttributeDataUpdate);
 
-		mSelf->Send(&outStream, HIGH_PRIORITY, UNRELIABLE_WITH_ACK_RECEIPT, 0, packet->systemAddress, false);
+		mSelf->Send(outStream.get(), HIGH_PRIORITY, UNRELIABLE_WITH_ACK_RECEIPT, 0, packet->systemAddress, false);
 	}
 
 	void Server::SendCombatantDataUpdate(Packet* packet) {
 		// Packet size: 0x04
-		BitStream outStream(8);
-		outStream.Write(PacketID::CombatantDataUpdate);
+		auto outStream = mStreamPool.acquire(0x04);
+		outStream->Write(PacketID::CombatantDataUpdate);
 
-		mSelf->Send(&outStream, HIGH_PRIORITY, UNRELIABLE_WITH_ACK_RECEIPT, 0, packet->systemAddress, false);
+		mSelf->Send(outStream.get(), HIGH_PRIORITY, UNRELIABLE_WITH_ACK_RECEIPT, 0, packet->systemAddress, false);
 	}
 
 	void Server::SendInteractableDataUpdate(Packet* packet) {
 		// Packet size: 0x04
-		BitStream outStream(8);
-		outStream.Write(PacketID::InteractableDataUpdate);
+		auto outStream = mStreamPool.acquire(0x04);
+		outStream->Write(PacketID::InteractableDataUpdate);
 
-		mSelf->Send(&outStream, HIGH_PRIORITY, UNRELIABLE_WITH_ACK_RECEIPT, 0, packet->systemAddress, false);
+		mSelf->Send(outStream.get(), HIGH_PRIORITY, UNRELIABLE_WITH_ACK_RECEIPT, 0, packet->systemAddress, false);
 	}
 
 	void Server::SendAgentBlackboardUpdate(Packet* packet) {
 		// Packet size: 0x04
-		BitStream outStream(8);
-		outStream.Write(PacketID::AgentBlackboardUpdate);
+		auto outStream = mStreamPool.acquire(0x04);
+		outStream->Write(PacketID::AgentBlackboardUpdate);
 
-		mSelf->Send(&outStream, HIGH_PRIORITY, UNRELIABLE_WITH_ACK_RECEIPT, 0, packet->systemAddress, false);
+		mSelf->Send(outStream.get(), HIGH_PRIORITY, UNRELIABLE_WITH_ACK_RECEIPT, 0, packet->systemAddress, false);
 	}
 
 	void Server::SendLootDataUpdate(Packet* packet) {
 		// Packet size: 0x04
-		BitStream outStream(8);
-		outStream.Write(PacketID::LootDataUpdate);
+		auto outStream = mStreamPool.acquire(0x04);
+		outStream->Write(PacketID::LootDataUpdate);
 
-		mSelf->Send(&outStream, HIGH_PRIORITY, UNRELIABLE_WITH_ACK_RECEIPT, 0, packet->systemAddress, false);
+		mSelf->Send(outStream.get(), HIGH_PRIORITY, UNRELIABLE_WITH_ACK_RECEIPT, 0, packet->systemAddress, false);
 	}
 
 	void Server::SendServerEvent(Packet* packet) {
 		// Packet size: variable
-		BitStream outStream(8);
-		outStream.Write(PacketID::ServerEvent);
+		auto outStream = mStreamPool.acquire(0x00);
+		outStream->Write(PacketID::ServerEvent);
 
 		ServerEvent event;
-		event.WriteReflection(outStream);
+		event.WriteReflection(*outStream);
 
-		mSelf->Send(&outStream, HIGH_PRIORITY, UNRELIABLE_WITH_ACK_RECEIPT, 0, packet->systemAddress, false);
+		mSelf->Send(outStream.get(), HIGH_PRIORITY, UNRELIABLE_WITH_ACK_RECEIPT, 0, packet->systemAddress, false);
 	}
 
 	void Server::SendModifierCreated(Packet* packet) {
 		// Packet size: 0x15
-		BitStream outStream(8);
-		outStream.Write(PacketID::ModifierCreated);
+		auto outStream = mStreamPool.acquire(0x15);
+		outStream->Write(PacketID::ModifierCreated);
 
-		mSelf->Send(&outStream, HIGH_PRIORITY, UNRELIABLE_WITH_ACK_RECEIPT, 0, packet->systemAddress, false);
+		mSelf->Send(outStream.get(), HIGH_PRIORITY, UNRELIABLE_WITH_ACK_RECEIPT, 0, packet->systemAddress, false);
 	}
 
 	void Server::SendModifierUpdated(Packet* packet) {
 		// Packet size: 0x08
-		BitStream outStream(8);
-		outStream.Write(PacketID::ModifierUpdated);
+		auto outStream = mStreamPool.acquire(0x08);
+		outStream->Write(PacketID::ModifierUpdated);
 
-		mSelf->Send(&outStream, HIGH_PRIORITY, UNRELIABLE_WITH_ACK_RECEIPT, 0, packet->systemAddress, false);
+		mSelf->Send(outStream.get(), HIGH_PRIORITY, UNRELIABLE_WITH_ACK_RECEIPT, 0, packet->systemAddress, false);
 	}
 
 	void Server::SendModifierDeleted(Packet* packet) {
 		// Packet size: 0x19
-		BitStream outStream(8);
-		outStream.Write(PacketID::ModifierDeleted);
+		auto outStream = mStreamPool.acquire(0x19);
+		outStream->Write(PacketID::ModifierDeleted);
 
-		mSelf->Send(&outStream, HIGH_PRIORITY, UNRELIABLE_WITH_ACK_RECEIPT, 0, packet->systemAddress, false);
+		mSelf->Send(outStream.get(), HIGH_PRIORITY, UNRELIABLE_WITH_ACK_RECEIPT, 0, packet->systemAddress, false);
 	}
 
 	void Server::SendGamePrepareForStart(Packet* packet) {
@@ -1958,61 +2015,61 @@ namespace RakNet {
 		// 0x3ABA8857 = unk
 
 		// Packet size: 0x10
-		BitStream outStream(8);
-		outStream.Write(PacketID::GamePrepareForStart);
+		auto outStream = mStreamPool.acquire(0x10);
+		outStream->Write(PacketID::GamePrepareForStart);
 
-		Write<uint32_t>(outStream, utils::hash_id("Darkspore_Tutorial_cryos_1_v2.level"));
-		Write<uint32_t>(outStream, utils::hash_id("Darkspore_Tutorial_cryos_1_v2_default.Markerset"));
-		Write<uint32_t>(outStream, utils::hash_id("Darkspore_Tutorial_cryos_1_v2_default.Markerset"));
+		Write<uint32_t>(*outStream, utils::hash_id("Darkspore_Tutorial_cryos_1_v2.level"));
+		Write<uint32_t>(*outStream, utils::hash_id("Darkspore_Tutorial_cryos_1_v2_default.Markerset"));
+		Write<uint32_t>(*outStream, utils::hash_id("Darkspore_Tutorial_cryos_1_v2_default.Markerset"));
 
 		// marker set for tutorial: 0xe6335cf5
 
 		// level index? must be (>= 0 %% <= 72)
-		Write<uint32_t>(outStream, 0x00000001);
+		Write<uint32_t>(*outStream, 0x00000001);
 
-		mSelf->Send(&outStream, HIGH_PRIORITY, UNRELIABLE_WITH_ACK_RECEIPT, 0, packet->systemAddress, false);
+		mSelf->Send(outStream.get(), HIGH_PRIORITY, UNRELIABLE_WITH_ACK_RECEIPT, 0, packet->systemAddress, false);
 	}
 
 	void Server::SendGameStart(Packet* packet) {
 		// Packet size: 0x04
-		BitStream outStream(8);
-		outStream.Write(PacketID::GameStart);
+		auto outStream = mStreamPool.acquire(0x04);
+		outStream->Write(PacketID::GameStart);
 
-		Write<uint32_t>(outStream, 0x00000001);
+		Write<uint32_t>(*outStream, 0x00000001);
 
-		mSelf->Send(&outStream, HIGH_PRIORITY, UNRELIABLE_WITH_ACK_RECEIPT, 0, packet->systemAddress, false);
+		mSelf->Send(outStream.get(), HIGH_PRIORITY, UNRELIABLE_WITH_ACK_RECEIPT, 0, packet->systemAddress, false);
 	}
 
 	void Server::SendArenaGameMessages(Packet* packet) {
 		// Packet size: 0x04
-		BitStream outStream(8);
-		outStream.Write(PacketID::ArenaGameMsgs);
+		auto outStream = mStreamPool.acquire(0x04);
+		outStream->Write(PacketID::ArenaGameMsgs);
 
-		Write<uint8_t>(outStream, 0x09);
-		Write<float>(outStream, 1.25f);
-		Write<uint16_t>(outStream, 0x0001);
-		Write<uint16_t>(outStream, 0);
-		Write<uint16_t>(outStream, 0x0001);
-		Write<uint16_t>(outStream, 0);
+		Write<uint8_t>(*outStream, 0x09);
+		Write<float>(*outStream, 1.25f);
+		Write<uint16_t>(*outStream, 0x0001);
+		Write<uint16_t>(*outStream, 0);
+		Write<uint16_t>(*outStream, 0x0001);
+		Write<uint16_t>(*outStream, 0);
 
-		mSelf->Send(&outStream, HIGH_PRIORITY, UNRELIABLE_WITH_ACK_RECEIPT, 0, packet->systemAddress, false);
+		mSelf->Send(outStream.get(), HIGH_PRIORITY, UNRELIABLE_WITH_ACK_RECEIPT, 0, packet->systemAddress, false);
 	}
 
 	void Server::SendObjectivesInitForLevel(Packet* packet) {
 		// Packet size: variable
-		BitStream outStream(8);
-		outStream.Write(PacketID::ObjectivesInitForLevel);
+		auto outStream = mStreamPool.acquire(0x00);
+		outStream->Write(PacketID::ObjectivesInitForLevel);
 
 		uint8_t count = 0x01;
-		Write<uint8_t>(outStream, count);
+		Write<uint8_t>(*outStream, count);
 
 		for (uint8_t i = 0; i < count; ++i) {
-			Write<uint32_t>(outStream, utils::hash_id("DontUseHealthObelisks"));
+			Write<uint32_t>(*outStream, utils::hash_id("DontUseHealthObelisks"));
 
-			Write<uint8_t>(outStream, 0x01);
-			Write<uint8_t>(outStream, 0x01);
-			Write<uint8_t>(outStream, 0x01);
-			Write<uint8_t>(outStream, 0x01);
+			Write<uint8_t>(*outStream, 0x01);
+			Write<uint8_t>(*outStream, 0x01);
+			Write<uint8_t>(*outStream, 0x01);
+			Write<uint8_t>(*outStream, 0x01);
 
 			std::string description = "Do some stuff bruh";
 
@@ -2020,48 +2077,48 @@ namespace RakNet {
 			size_t padding = 0x30 - length;
 
 			for (size_t i = 0; i < length; ++i) {
-				Write<char>(outStream, description[i]);
+				Write<char>(*outStream, description[i]);
 			}
 
 			for (size_t i = 0; i < padding; ++i) {
-				Write<char>(outStream, 0x00);
+				Write<char>(*outStream, 0x00);
 			}
 		}
 
-		mSelf->Send(&outStream, HIGH_PRIORITY, UNRELIABLE_WITH_ACK_RECEIPT, 0, packet->systemAddress, false);
+		mSelf->Send(outStream.get(), HIGH_PRIORITY, UNRELIABLE_WITH_ACK_RECEIPT, 0, packet->systemAddress, false);
 	}
 
 	void Server::SendPartyMergeComplete(Packet* packet) {
 		// Packet size: 0x08
-		BitStream outStream(8);
-		outStream.Write(PacketID::PartyMergeComplete);
-		outStream.Write<uint64_t>(utils::get_unix_time());
+		auto outStream = mStreamPool.acquire(0x08);
+		outStream->Write(PacketID::PartyMergeComplete);
+		outStream->Write<uint64_t>(utils::get_unix_time());
 
-		mSelf->Send(&outStream, HIGH_PRIORITY, UNRELIABLE_WITH_ACK_RECEIPT, 0, packet->systemAddress, false);
+		mSelf->Send(outStream.get(), HIGH_PRIORITY, UNRELIABLE_WITH_ACK_RECEIPT, 0, packet->systemAddress, false);
 	}
 
 	void Server::SendDebugPing(Packet* packet) {
 		// Packet size: 0x08
-		BitStream outStream(8);
-		outStream.Write(PacketID::DebugPing);
-		outStream.Write<uint64_t>(utils::get_unix_time());
+		auto outStream = mStreamPool.acquire(0x08);
+		outStream->Write(PacketID::DebugPing);
+		outStream->Write<uint64_t>(utils::get_unix_time());
 
-		mSelf->Send(&outStream, HIGH_PRIORITY, UNRELIABLE_WITH_ACK_RECEIPT, 0, packet->systemAddress, false);
+		mSelf->Send(outStream.get(), HIGH_PRIORITY, UNRELIABLE_WITH_ACK_RECEIPT, 0, packet->systemAddress, false);
 	}
 
 	void Server::SendTutorial(Packet* packet) {
-		BitStream outStream(8);
-		outStream.Write(PacketID::TutorialGameMsgs);
+		auto outStream = mStreamPool.acquire(0x00);
+		outStream->Write(PacketID::TutorialGameMsgs);
 
-		mSelf->Send(&outStream, HIGH_PRIORITY, UNRELIABLE_WITH_ACK_RECEIPT, 0, packet->systemAddress, false);
+		mSelf->Send(outStream.get(), HIGH_PRIORITY, UNRELIABLE_WITH_ACK_RECEIPT, 0, packet->systemAddress, false);
 	}
 
 	void Server::SendTestPacket(Packet* packet, MessageID id, const std::vector<uint8_t>& data) {
-		BitStream outStream(8);
-		outStream.Write(id);
+		auto outStream = mStreamPool.acquire(data.size());
+		outStream->Write(id);
 		for (auto byte : data) {
-			outStream.Write(byte);
+			outStream->Write(byte);
 		}
-		mSelf->Send(&outStream, HIGH_PRIORITY, UNRELIABLE_WITH_ACK_RECEIPT, 0, packet->systemAddress, false);
+		mSelf->Send(outStream.get(), HIGH_PRIORITY, UNRELIABLE_WITH_ACK_RECEIPT, 0, packet->systemAddress, false);
 	}
 }
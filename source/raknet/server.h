@@ -2,112 +2,71 @@
 #ifndef _RAKNET_SERVER_HEADER
 #define _RAKNET_SERVER_HEADER
 
-#define PACKET_LOGGING
-
 // Include
 #include "blaze/types.h"
+#include "capture.h"
+#include "packetid.h"
+#include "recorder.h"
+#include "streampool.h"
 
 #include <RakPeerInterface.h>
 #include <BitStream.h>
-#ifdef PACKET_LOGGING
-#	include <PacketLogger.h>
-#endif
 
 #include <cstdint>
+#include <array>
 #include <thread>
 #include <mutex>
+#include <atomic>
+#include <chrono>
+#include <limits>
+#include <string>
 #include <vector>
+#include <functional>
+#include <future>
+#include <span>
+
+// Game
+namespace Game {
+	struct CreatureStats;
+	struct CrystalBonus;
+}
 
 // RakNet
 namespace RakNet {
-	// Packet
-	namespace PacketID {
-		constexpr MessageID HelloPlayer = 0x80;
-		constexpr MessageID ReconnectPlayer = 0x81;
-		constexpr MessageID Connected = 0x82;
-		constexpr MessageID Goodbye = 0x83;
-		constexpr MessageID PlayerJoined = 0x84;
-		constexpr MessageID PartyMergeComplete = 0x85;
-		constexpr MessageID PlayerDeparted = 0x86;
-		constexpr MessageID VoteKickStarted = 0x87;
-		constexpr MessageID PlayerStatusUpdate = 0x88;
-		constexpr MessageID GameAborted = 0x89;
-		constexpr MessageID GameState = 0x8A;
-		constexpr MessageID DirectorState = 0x8B;
-		constexpr MessageID ObjectCreate = 0x8C;
-		constexpr MessageID ObjectUpdate = 0x8D;
-		constexpr MessageID ObjectDelete = 0x8E;
-		constexpr MessageID ObjectTeleport = 0x8F;
-		constexpr MessageID ObjectJump = 0x90;
-		constexpr MessageID ObjectPlayerMove = 0x91;
-		constexpr MessageID ForcePhysicsUpdate = 0x92;
-		constexpr MessageID PhysicsChanged = 0x93;
-		constexpr MessageID LocomotionDataUpdate = 0x94;
-		constexpr MessageID LocomotionDataUnreliableUpdate = 0x95;
-		constexpr MessageID AttributeDataUpdate = 0x96;
-		constexpr MessageID CombatantDataUpdate = 0x97;
-		constexpr MessageID InteractableDataUpdate = 0x98;
-		constexpr MessageID AgentBlackboardUpdate = 0x99;
-		constexpr MessageID LootDataUpdate = 0x9A;
-		constexpr MessageID ServerEvent = 0x9B;
-		constexpr MessageID ActionCommandMsgs = 0x9C;
-		constexpr MessageID PlayerDamage = 0x9E;
-		constexpr MessageID LootSpawned = 0x9F;
-		constexpr MessageID LootAcquired = 0xA0;
-		constexpr MessageID LabsPlayerUpdate = 0xA1;
-		constexpr MessageID ModifierCreated = 0xA2;
-		constexpr MessageID ModifierUpdated = 0xA3;
-		constexpr MessageID ModifierDeleted = 0xA4;
-		constexpr MessageID SetAnimationState = 0xA5;
-		constexpr MessageID SetObjectGfxState = 0xA6;
-		constexpr MessageID PlayerCharacterDeploy = 0xA7;
-		constexpr MessageID ActionCommandResponse = 0xA8;
-		constexpr MessageID ChainPlayerMsgs = 0xA9;
-		constexpr MessageID ChainVoteMsgs = 0xAA;
-		constexpr MessageID ChainLevelResultsMsgs = 0xAB;
-		constexpr MessageID ChainCashOutMsgs = 0xAC;
-		constexpr MessageID ChainGameMsgs = 0xAD;
-		constexpr MessageID ChainGameOverMsgs = 0xAE;
-		constexpr MessageID QuickGameMsgs = 0xAF;
-		constexpr MessageID GamePrepareForStart = 0xB0;
-		constexpr MessageID GameStart = 0xB1;
-		constexpr MessageID CheatMessageDontUseInReleaseButDontChangeTheIndexOfTheMessagesBelowInCaseWeAreRunningOnADevServer = 0xB2;
-		constexpr MessageID ArenaPlayerMsgs = 0xB3;
-		constexpr MessageID ArenaLobbyMsgs = 0xB4;
-		constexpr MessageID ArenaGameMsgs = 0xB5;
-		constexpr MessageID ArenaResultsMsgs = 0xB6;
-		constexpr MessageID ObjectivesInitForLevel = 0xB7;
-		constexpr MessageID ObjectiveUpdated = 0xB8;
-		constexpr MessageID ObjectivesComplete = 0xB9;
-		constexpr MessageID JuggernautPlayerMsgs = 0xBA;
-		constexpr MessageID JuggernautLobbyMsgs = 0xBB;
-		constexpr MessageID JuggernautGameMsgs = 0xBC;
-		constexpr MessageID JuggernautResultsMsgs = 0xBD;
-		constexpr MessageID CombatEvent = 0xBE;
-		constexpr MessageID ReloadLevel = 0xBF;
-		constexpr MessageID GravityForceUpdate = 0xC0;
-		constexpr MessageID CooldownUpdate = 0xC1;
-		constexpr MessageID CrystalDragMessage = 0xC2;
-		constexpr MessageID CrystalMessage = 0xC3;
-		constexpr MessageID KillRacePlayerMsgs = 0xC4;
-		constexpr MessageID KillRaceLobbyMsgs = 0xC5;
-		constexpr MessageID KillRaceGameMsgs = 0xC6;
-		constexpr MessageID KillRaceResultsMsgs = 0xC7;
-		constexpr MessageID TutorialGameMsgs = 0xC8;
-		constexpr MessageID CinematicMsgs = 0xC9;
-		constexpr MessageID ObjectiveAdd = 0xCA;
-		constexpr MessageID LootDropMessage = 0xCB;
-		constexpr MessageID DebugPing = 0xCC;
-	}
-
 	struct ObjectCreateData {
 
 	};
 
+	// MessageStats
+	struct MessageStats {
+		uint64_t count = 0;
+		uint64_t totalNanoseconds = 0;
+		uint64_t maxNanoseconds = 0;
+	};
+
+	// TickStats
+	struct TickStats {
+		uint64_t ticks = 0;
+		uint64_t overruns = 0;
+		uint64_t maxMicroseconds = 0;
+	};
+
+	// Fills in the stats of a character deployed from a creature template. False if the template is unknown.
+	// Only template and crystals count, equipped parts are not applied until the server knows which user's creature it deploys.
+	using CharacterStatsProvider = std::function<bool(uint32_t templateId, std::span<const Game::CrystalBonus> crystals, Game::CreatureStats& stats)>;
+
 	// Server
 	class Server {
 		public:
-			Server(uint16_t port, uint32_t gameId);
+			static constexpr uint32_t InvalidGameId = std::numeric_limits<uint32_t>::max();
+			static constexpr std::chrono::milliseconds TickInterval { 30 };
+
+			// Set by the game before any server starts, the server itself does not read the repositories.
+			// Without a provider characters keep their default stats.
+			static void SetCharacterStatsProvider(CharacterStatsProvider provider);
+
+			// Returns once the socket is bound. Port 0 lets the OS pick a free one, get_port is 0 if the server could not start.
+			Server(uint16_t port, uint32_t gameId = InvalidGameId);
 			~Server();
 
 			void run_one();
@@ -115,7 +74,37 @@ namespace RakNet {
 			void stop();
 			bool is_running();
 
+			// Pooling
+			void assign(uint32_t gameId);
+			void release();
+
+			bool is_assigned() const;
+
+			uint16_t get_port() const { return mPort; }
+			uint32_t get_game_id() const { return mGameId; }
+
+			// Trace id of the session that started the game, its spans show up next to the Blaze and HTTP ones.
+			uint64_t get_trace_id() const { return mTraceId; }
+			void set_trace_id(uint64_t traceId) { mTraceId = traceId; }
+
+			// Capture
+			void set_capture(bool enabled);
+			bool is_capturing() const;
+
+			bool dump_capture(const std::string& path) const;
+
+			// Recording
+			void start_recording(const std::string& path);
+			void stop_recording();
+
+			// Only stable once the server thread has stopped.
+			const std::array<MessageStats, 256>& get_message_stats() const { return mMessageStats; }
+
+			// A tick overruns when handling its packets takes longer than TickInterval.
+			TickStats get_tick_stats() const;
+
 		private:
+			void BindInStream(Packet* packet);
 			void ParsePacket(Packet* packet, MessageID packetType);
 
 			void OnNewIncomingConnection(Packet* packet);
@@ -162,18 +151,36 @@ namespace RakNet {
 
 			void SendTestPacket(Packet* packet, MessageID id, const std::vector<uint8_t>& data);
 
+			void ResetConnections();
+			void ApplyRecordingChange();
+
 		private:
+			static CharacterStatsProvider sCharacterStatsProvider;
+
 			std::thread mThread;
 			std::mutex mMutex;
-#ifdef PACKET_LOGGING
-			PacketLogger mLogger;
-#endif
+			PacketCapture mCapture;
+			SessionRecorder mRecorder;
+
+			std::array<MessageStats, 256> mMessageStats {};
+
+			std::atomic<uint64_t> mTicks = 0;
+			std::atomic<uint64_t> mTickOverruns = 0;
+			std::atomic<uint64_t> mMaxTickMicroseconds = 0;
 
 			BitStream mInStream;
+			BitStreamPool mStreamPool;
 
 			RakPeerInterface* mSelf;
 
-			uint32_t mGameId;
+			std::atomic<uint64_t> mTraceId = 0;
+			std::atomic<uint32_t> mGameId;
+			std::atomic<bool> mResetPending = false;
+			std::atomic<bool> mRecordingPending = false;
+
+			std::string mRecordingPath;
+
+			uint16_t mPort;
 
 			bool mRunning = true;
 	};
@@ -0,0 +1,62 @@
+
+// Include
+#include "streampool.h"
+
+#include <algorithm>
+
+// RakNet
+namespace RakNet {
+	// PooledBitStream
+	PooledBitStream::PooledBitStream(BitStreamPool& pool, std::unique_ptr<BitStream>&& stream) :
+		mPool(&pool), mStream(std::move(stream)) {}
+
+	PooledBitStream::~PooledBitStream() {
+		if (mStream) {
+			mPool->release(std::move(mStream));
+		}
+	}
+
+	// BitStreamPool
+	BitStreamPool::BitStreamPool(size_t count, size_t maxRetained) : mMaxRetained(std::max(count, maxRetained)) {
+		mStreams.reserve(count);
+		for (size_t i = 0; i < count; ++i) {
+			mStreams.push_back(std::make_unique<BitStream>(BITSTREAM_STACK_ALLOCATION_SIZE));
+		}
+	}
+
+	PooledBitStream BitStreamPool::acquire(size_t bytes) {
+		// Packet id + payload, streams keep whatever capacity they grew to while they were out.
+		const BitSize_t bits = static_cast<BitSize_t>((bytes + sizeof(MessageID)) << 3);
+
+		auto it = std::find_if(mStreams.rbegin(), mStreams.rend(), [bits](const auto& stream) {
+			return stream->GetNumberOfBitsAllocated() >= bits;
+		});
+
+		std::unique_ptr<BitStream> stream;
+		if (it != mStreams.rend()) {
+			stream = std::move(*it);
+			mStreams.erase(std::next(it).base());
+		} else {
+			stream = std::make_unique<BitStream>(static_cast<unsigned int>(bits >> 3));
+		}
+
+		stream->Reset();
+		return PooledBitStream(*this, std::move(stream));
+	}
+
+	void BitStreamPool::release(std::unique_ptr<BitStream>&& stream) {
+		if (mStreams.size() < mMaxRetained) {
+			mStreams.push_back(std::move(stream));
+			return;
+		}
+
+		// Full after a burst, keep the smaller of the two so the peak allocation is eventually freed.
+		auto largest = std::max_element(mStreams.begin(), mStreams.end(), [](const auto& lhs, const auto& rhs) {
+			return lhs->GetNumberOfBitsAllocated() < rhs->GetNumberOfBitsAllocated();
+		});
+
+		if ((*largest)->GetNumberOfBitsAllocated() > stream->GetNumberOfBitsAllocated()) {
+			*largest = std::move(stream);
+		}
+	}
+}
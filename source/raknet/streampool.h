@@ -0,0 +1,55 @@
+
+#ifndef _RAKNET_STREAMPOOL_HEADER
+#define _RAKNET_STREAMPOOL_HEADER
+
+// Include
+#include <BitStream.h>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// RakNet
+namespace RakNet {
+	class BitStreamPool;
+
+	// PooledBitStream
+	class PooledBitStream {
+		public:
+			PooledBitStream(BitStreamPool& pool, std::unique_ptr<BitStream>&& stream);
+			PooledBitStream(PooledBitStream&& other) noexcept = default;
+			~PooledBitStream();
+
+			PooledBitStream(const PooledBitStream&) = delete;
+			PooledBitStream& operator=(const PooledBitStream&) = delete;
+
+			BitStream* get() const { return mStream.get(); }
+
+			BitStream& operator*() const { return *mStream; }
+			BitStream* operator->() const { return mStream.get(); }
+
+		private:
+			BitStreamPool* mPool;
+			std::unique_ptr<BitStream> mStream;
+	};
+
+	// BitStreamPool
+	class BitStreamPool {
+		public:
+			// count streams are allocated up front, at most maxRetained are kept once they are given back.
+			BitStreamPool(size_t count = 4, size_t maxRetained = 16);
+
+			PooledBitStream acquire(size_t bytes);
+
+		private:
+			void release(std::unique_ptr<BitStream>&& stream);
+
+		private:
+			std::vector<std::unique_ptr<BitStream>> mStreams;
+			size_t mMaxRetained;
+
+			friend class PooledBitStream;
+	};
+}
+
+#endif
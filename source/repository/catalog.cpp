@@ -0,0 +1,277 @@
+
+// Include
+#include "catalog.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <unordered_map>
+#include "../utils/logger.h"
+
+// Repository
+namespace Repository {
+
+	namespace {
+		class StringPool {
+			public:
+				CatalogFormat::StringRef Add(const std::string& value) {
+					auto it = mRefs.find(value);
+					if (it != mRefs.end()) {
+						return it->second;
+					}
+
+					CatalogFormat::StringRef ref;
+					ref.offset = static_cast<uint32_t>(mData.size());
+					ref.length = static_cast<uint32_t>(value.size());
+					mData += value;
+
+					mRefs.emplace(value, ref);
+					return ref;
+				}
+
+				const std::string& data() const { return mData; }
+
+			private:
+				std::unordered_map<std::string, CatalogFormat::StringRef> mRefs;
+				std::string mData;
+		};
+
+		template<typename T>
+		bool ReadJsonArray(const std::string& path, std::vector<T>& items) {
+			if (!std::filesystem::exists(path)) {
+				return false;
+			}
+
+			auto document = utils::json::FromFile(path);
+			if (!document.IsArray()) {
+				return false;
+			}
+
+			for (auto& node : document.GetArray()) {
+				if (node.IsObject()) {
+					items.emplace_back().ReadJson(node);
+				}
+			}
+			return true;
+		}
+	}
+
+	bool Catalog::Compile(const std::string& partsPath, const std::string& templatesPath, const std::string& outputPath) {
+		using namespace CatalogFormat;
+
+		std::vector<Game::Part> parts;
+		if (!ReadJsonArray(partsPath, parts)) {
+			logger::error("Catalog: could not read " + partsPath);
+			return false;
+		}
+
+		std::vector<Game::CreatureTemplate> templates;
+		if (!ReadJsonArray(templatesPath, templates)) {
+			logger::error("Catalog: could not read " + templatesPath);
+			return false;
+		}
+
+		// Sorted and unique, the first entry wins like it did for the json maps.
+		std::stable_sort(parts.begin(), parts.end(), [](const auto& lhs, const auto& rhs) { return lhs.rigblock_asset_id < rhs.rigblock_asset_id; });
+		parts.erase(std::unique(parts.begin(), parts.end(), [](const auto& lhs, const auto& rhs) { return lhs.rigblock_asset_id == rhs.rigblock_asset_id; }), parts.end());
+
+		std::stable_sort(templates.begin(), templates.end(), [](const auto& lhs, const auto& rhs) { return lhs.id < rhs.id; });
+		templates.erase(std::unique(templates.begin(), templates.end(), [](const auto& lhs, const auto& rhs) { return lhs.id == rhs.id; }), templates.end());
+
+		StringPool strings;
+
+		std::vector<PartRecord> partRecords;
+		partRecords.reserve(parts.size());
+		for (const auto& part : parts) {
+			auto& record = partRecords.emplace_back();
+			record.rigblock_asset_id = part.rigblock_asset_id;
+			record.prefix_asset_id = part.prefix_asset_id;
+			record.prefix_secondary_asset_id = part.prefix_secondary_asset_id;
+			record.suffix_asset_id = part.suffix_asset_id;
+			record.level = part.level;
+			record.rarity = part.rarity;
+			record.market_status = part.market_status;
+			record.usage = part.usage;
+			record.cost = part.cost;
+			record.rigblock_asset_hash = part.rigblock_asset_hash;
+			record.prefix_asset_hash = part.prefix_asset_hash;
+			record.prefix_secondary_asset_hash = part.prefix_secondary_asset_hash;
+			record.suffix_asset_hash = part.suffix_asset_hash;
+			record.stats = strings.Add(part.stats.ToString());
+			record.type_full = strings.Add(part.type_full);
+			record.class_types_full = strings.Add(part.class_types_full);
+			record.science_types_full = strings.Add(part.science_types_full);
+			record.rarity_full = strings.Add(part.rarity_full);
+			record.png_key = strings.Add(part.png_key);
+			record.weapon_damage_modifier = strings.Add(part.weapon_damage_modifier.ToString());
+			record.modifiers = strings.Add(part.modifiers.ToString());
+			record.rand_seed = strings.Add(part.rand_seed);
+		}
+
+		std::vector<TemplateRecord> templateRecords;
+		templateRecords.reserve(templates.size());
+		for (const auto& creatureTemplate : templates) {
+			auto& record = templateRecords.emplace_back();
+			record.id = creatureTemplate.id;
+			record.hasFeet = creatureTemplate.hasFeet;
+			record.hasHands = creatureTemplate.hasHands;
+			record.nameLocaleId = creatureTemplate.nameLocaleId;
+			record.descLocaleId = creatureTemplate.descLocaleId;
+			record.weaponMinDamage = creatureTemplate.weaponMinDamage;
+			record.weaponMaxDamage = creatureTemplate.weaponMaxDamage;
+			record.gearScore = creatureTemplate.gearScore;
+			record.abilityPassive = creatureTemplate.abilityPassive;
+			record.abilityBasic = creatureTemplate.abilityBasic;
+			record.abilityRandom = creatureTemplate.abilityRandom;
+			record.abilitySpecial1 = creatureTemplate.abilitySpecial1;
+			record.abilitySpecial2 = creatureTemplate.abilitySpecial2;
+			record.name = strings.Add(creatureTemplate.name);
+			record.elementType = strings.Add(creatureTemplate.elementType);
+			record.classType = strings.Add(creatureTemplate.classType);
+			record.statsTemplate = strings.Add(creatureTemplate.statsTemplate.ToString());
+			record.statsTemplateAbilityKeyvalues = strings.Add(creatureTemplate.statsTemplateAbilityKeyvalues.ToString());
+		}
+
+		Header header;
+		header.partCount = static_cast<uint32_t>(partRecords.size());
+		header.templateCount = static_cast<uint32_t>(templateRecords.size());
+		header.partOffset = sizeof(Header);
+		header.templateOffset = header.partOffset + header.partCount * sizeof(PartRecord);
+		header.stringOffset = header.templateOffset + header.templateCount * sizeof(TemplateRecord);
+		header.stringSize = static_cast<uint32_t>(strings.data().size());
+
+		std::ofstream file(outputPath, std::ios::binary | std::ios::trunc);
+		if (!file.is_open()) {
+			logger::error("Catalog: could not write " + outputPath);
+			return false;
+		}
+
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(reinterpret_cast<const char*>(partRecords.data()), partRecords.size() * sizeof(PartRecord));
+		file.write(reinterpret_cast<const char*>(templateRecords.data()), templateRecords.size() * sizeof(TemplateRecord));
+		file.write(strings.data().data(), strings.data().size());
+		return file.good();
+	}
+
+	bool Catalog::Open(const std::string& path, const std::string& sourcePath) {
+		using namespace CatalogFormat;
+
+		std::error_code error;
+		if (!std::filesystem::exists(path, error)) {
+			return false;
+		}
+
+		if (std::filesystem::exists(sourcePath, error) && std::filesystem::last_write_time(sourcePath, error) > std::filesystem::last_write_time(path, error)) {
+			logger::warn("Catalog: " + sourcePath + " is newer than " + path + ", recompile it with catalogc");
+			return false;
+		}
+
+		try {
+			mFile = boost::interprocess::file_mapping(path.c_str(), boost::interprocess::read_only);
+			mRegion = boost::interprocess::mapped_region(mFile, boost::interprocess::read_only);
+		} catch (const boost::interprocess::interprocess_exception& e) {
+			logger::error("Catalog: could not map " + path + ": " + e.what());
+			return false;
+		}
+
+		const size_t size = mRegion.get_size();
+		const auto* header = static_cast<const Header*>(mRegion.get_address());
+		if (size < sizeof(Header) || header->magic != Magic || header->version != Version) {
+			logger::warn("Catalog: " + path + " is not a version " + std::to_string(Version) + " catalog");
+			return false;
+		}
+
+		const uint64_t partEnd = uint64_t(header->partOffset) + uint64_t(header->partCount) * sizeof(PartRecord);
+		const uint64_t templateEnd = uint64_t(header->templateOffset) + uint64_t(header->templateCount) * sizeof(TemplateRecord);
+		const uint64_t stringEnd = uint64_t(header->stringOffset) + header->stringSize;
+		if (partEnd > size || templateEnd > size || stringEnd > size) {
+			logger::error("Catalog: " + path + " is truncated");
+			return false;
+		}
+
+		mHeader = header;
+		return true;
+	}
+
+	void Catalog::ReadParts(std::vector<Game::Part>& parts) const {
+		using namespace CatalogFormat;
+		if (!mHeader) {
+			return;
+		}
+
+		const auto* base = static_cast<const char*>(mRegion.get_address());
+		const auto* records = reinterpret_cast<const PartRecord*>(base + mHeader->partOffset);
+
+		parts.reserve(parts.size() + mHeader->partCount);
+		for (uint32_t i = 0; i < mHeader->partCount; ++i) {
+			const auto& record = records[i];
+
+			auto& part = parts.emplace_back();
+			part.rigblock_asset_id = record.rigblock_asset_id;
+			part.prefix_asset_id = record.prefix_asset_id;
+			part.prefix_secondary_asset_id = record.prefix_secondary_asset_id;
+			part.suffix_asset_id = record.suffix_asset_id;
+			part.level = record.level;
+			part.rarity = record.rarity;
+			part.market_status = record.market_status;
+			part.usage = record.usage;
+			part.cost = record.cost;
+			part.rigblock_asset_hash = record.rigblock_asset_hash;
+			part.prefix_asset_hash = record.prefix_asset_hash;
+			part.prefix_secondary_asset_hash = record.prefix_secondary_asset_hash;
+			part.suffix_asset_hash = record.suffix_asset_hash;
+			part.stats.Parse(GetString(record.stats));
+			part.type_full = GetString(record.type_full);
+			part.class_types_full = GetString(record.class_types_full);
+			part.science_types_full = GetString(record.science_types_full);
+			part.rarity_full = GetString(record.rarity_full);
+			part.png_key = GetString(record.png_key);
+			part.weapon_damage_modifier.Parse(GetString(record.weapon_damage_modifier));
+			part.modifiers.Parse(GetString(record.modifiers));
+			part.rand_seed = GetString(record.rand_seed);
+		}
+	}
+
+	void Catalog::ReadTemplates(std::vector<Game::CreatureTemplate>& templates) const {
+		using namespace CatalogFormat;
+		if (!mHeader) {
+			return;
+		}
+
+		const auto* base = static_cast<const char*>(mRegion.get_address());
+		const auto* records = reinterpret_cast<const TemplateRecord*>(base + mHeader->templateOffset);
+
+		templates.reserve(templates.size() + mHeader->templateCount);
+		for (uint32_t i = 0; i < mHeader->templateCount; ++i) {
+			const auto& record = records[i];
+
+			auto& creatureTemplate = templates.emplace_back();
+			creatureTemplate.id = record.id;
+			creatureTemplate.hasFeet = record.hasFeet != 0;
+			creatureTemplate.hasHands = record.hasHands != 0;
+			creatureTemplate.nameLocaleId = record.nameLocaleId;
+			creatureTemplate.descLocaleId = record.descLocaleId;
+			creatureTemplate.weaponMinDamage = record.weaponMinDamage;
+			creatureTemplate.weaponMaxDamage = record.weaponMaxDamage;
+			creatureTemplate.gearScore = record.gearScore;
+			creatureTemplate.abilityPassive = record.abilityPassive;
+			creatureTemplate.abilityBasic = record.abilityBasic;
+			creatureTemplate.abilityRandom = record.abilityRandom;
+			creatureTemplate.abilitySpecial1 = record.abilitySpecial1;
+			creatureTemplate.abilitySpecial2 = record.abilitySpecial2;
+			creatureTemplate.name = GetString(record.name);
+			creatureTemplate.elementType = GetString(record.elementType);
+			creatureTemplate.classType = GetString(record.classType);
+			creatureTemplate.statsTemplate.Parse(GetString(record.statsTemplate));
+			creatureTemplate.statsTemplateAbilityKeyvalues.Parse(GetString(record.statsTemplateAbilityKeyvalues));
+		}
+	}
+
+	std::string Catalog::GetString(const CatalogFormat::StringRef& ref) const {
+		if (ref.length == 0 || uint64_t(ref.offset) + ref.length > mHeader->stringSize) {
+			return {};
+		}
+
+		const auto* pool = static_cast<const char*>(mRegion.get_address()) + mHeader->stringOffset;
+		return std::string(pool + ref.offset, ref.length);
+	}
+}
@@ -0,0 +1,123 @@
+
+#ifndef _GAME_REPO_CATALOG_HEADER
+#define _GAME_REPO_CATALOG_HEADER
+
+// Include
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include "../game/part.h"
+#include "../game/template.h"
+
+// Game
+namespace Repository {
+
+	// Catalog file: Header, PartRecords sorted by rigblock_asset_id, TemplateRecords sorted by id, then the string pool.
+	namespace CatalogFormat {
+		constexpr uint32_t Magic = 0x54414352; // RCAT
+		constexpr uint16_t Version = 1;
+
+#pragma pack(push, 1)
+		struct StringRef {
+			uint32_t offset = 0;
+			uint32_t length = 0;
+		};
+
+		struct Header {
+			uint32_t magic = Magic;
+			uint16_t version = Version;
+			uint16_t reserved = 0;
+			uint32_t partCount = 0;
+			uint32_t templateCount = 0;
+			uint32_t partOffset = 0;
+			uint32_t templateOffset = 0;
+			uint32_t stringOffset = 0;
+			uint32_t stringSize = 0;
+		};
+
+		struct PartRecord {
+			uint16_t rigblock_asset_id = 0;
+			uint16_t prefix_asset_id = 0;
+			uint16_t prefix_secondary_asset_id = 0;
+			uint16_t suffix_asset_id = 0;
+			uint16_t level = 0;
+
+			uint8_t rarity = 0;
+			uint8_t market_status = 0;
+			uint8_t usage = 0;
+			uint8_t reserved = 0;
+
+			uint32_t cost = 0;
+
+			uint32_t rigblock_asset_hash = 0;
+			uint32_t prefix_asset_hash = 0;
+			uint32_t prefix_secondary_asset_hash = 0;
+			uint32_t suffix_asset_hash = 0;
+
+			StringRef stats;
+			StringRef type_full;
+			StringRef class_types_full;
+			StringRef science_types_full;
+			StringRef rarity_full;
+			StringRef png_key;
+			StringRef weapon_damage_modifier;
+			StringRef modifiers;
+			StringRef rand_seed;
+		};
+
+		struct TemplateRecord {
+			uint32_t id = 0;
+
+			uint8_t hasFeet = 0;
+			uint8_t hasHands = 0;
+			uint16_t reserved = 0;
+
+			uint64_t nameLocaleId = 0;
+			uint64_t descLocaleId = 0;
+
+			double weaponMinDamage = 0;
+			double weaponMaxDamage = 0;
+			double gearScore = 0;
+
+			uint64_t abilityPassive = 0;
+			uint64_t abilityBasic = 0;
+			uint64_t abilityRandom = 0;
+			uint64_t abilitySpecial1 = 0;
+			uint64_t abilitySpecial2 = 0;
+
+			StringRef name;
+			StringRef elementType;
+			StringRef classType;
+			StringRef statsTemplate;
+			StringRef statsTemplateAbilityKeyvalues;
+		};
+#pragma pack(pop)
+	}
+
+	// Catalog
+	class Catalog {
+		public:
+			// Offline step, see tools/catalogc.
+			static bool Compile(const std::string& partsPath, const std::string& templatesPath, const std::string& outputPath);
+
+			// False if the file is missing, of another version or older than the json it was compiled from.
+			bool Open(const std::string& path, const std::string& sourcePath);
+
+			void ReadParts(std::vector<Game::Part>& parts) const;
+			void ReadTemplates(std::vector<Game::CreatureTemplate>& templates) const;
+
+		private:
+			std::string GetString(const CatalogFormat::StringRef& ref) const;
+
+		private:
+			boost::interprocess::file_mapping mFile;
+			boost::interprocess::mapped_region mRegion;
+
+			const CatalogFormat::Header* mHeader = nullptr;
+	};
+}
+
+#endif
@@ -1,47 +1,94 @@
 
 // Include
 #include "part.h"
+#include "catalog.h"
 #include <algorithm>
+#include <limits>
 #include "../game/config.h"
+#include "../utils/logger.h"
+#include "../utils/metrics.h"
 
 // Repository
 namespace Repository {
 
-	PartPtr Parts::getById(uint16_t id) {
-		Load();
+	namespace {
+		constexpr uint16_t NoPart = std::numeric_limits<uint16_t>::max();
+	}
 
-		PartPtr part;
+	PartPtr Parts::getById(uint16_t id) {
+		const auto& snapshot = Get();
 
-		auto it = mParts.find(id);
-		if (it != mParts.end()) {
-			part = it->second;
+		if (id < snapshot.indexById.size()) {
+			auto index = snapshot.indexById[id];
+			if (index != NoPart) {
+				return &snapshot.parts[index];
+			}
 		}
 
-		return part;
+		return nullptr;
+	}
+
+	const Parts::Snapshot& Parts::Get() {
+		auto snapshot = mSnapshot.load(std::memory_order_acquire);
+		if (!snapshot) {
+			Load();
+			snapshot = mSnapshot.load(std::memory_order_acquire);
+		}
+		return *snapshot;
 	}
 
 	void Parts::Load() {
-		if (!mParts.empty()) return;
+		std::call_once(mLoadFlag, [] {
+			metrics::scoped_timer timer(metrics::registry::get_histogram("repository_load_duration_seconds", "Time spent loading stored data.", { { "store", "parts" } }));
 
-		std::string jsonFilePath = Game::Config::Get(Game::CONFIG_STORAGE_PATH) + "/parts.json";
-		auto templatesList = utils::json::FromFile(jsonFilePath);
+			auto snapshot = std::make_unique<Snapshot>();
+			auto& parts = snapshot->parts;
 
-		for (auto& creatureNode : templatesList.GetArray()) {
-			PartPtr creature = std::make_shared<Game::Part>();
-			creature->ReadJson(creatureNode);
-			mParts.emplace(creature->rigblock_asset_id, creature);
-		}
+			const std::string& storagePath = Game::Config::Get(Game::CONFIG_STORAGE_PATH);
+			std::string jsonFilePath = storagePath + "/parts.json";
+
+			Catalog catalog;
+			if (catalog.Open(storagePath + "/catalog.bin", jsonFilePath)) {
+				catalog.ReadParts(parts);
+			} else {
+				auto partsList = utils::json::FromFile(jsonFilePath);
+				if (partsList.IsArray()) {
+					for (auto& partNode : partsList.GetArray()) {
+						parts.emplace_back().ReadJson(partNode);
+					}
+				}
+
+				std::stable_sort(parts.begin(), parts.end(), [](const auto& lhs, const auto& rhs) { return lhs.rigblock_asset_id < rhs.rigblock_asset_id; });
+				parts.erase(std::unique(parts.begin(), parts.end(), [](const auto& lhs, const auto& rhs) { return lhs.rigblock_asset_id == rhs.rigblock_asset_id; }), parts.end());
+			}
+
+			BuildIndex(*snapshot);
+			logger::info("Parts: loaded " + std::to_string(parts.size()) + " parts");
+
+			// Published once and never replaced, so handed out pointers stay valid.
+			mSnapshotStorage = std::move(snapshot);
+			mSnapshot.store(mSnapshotStorage.get(), std::memory_order_release);
+		});
 	}
 
-	std::map<uint32_t, PartPtr> Parts::mParts;
+	void Parts::BuildIndex(Snapshot& snapshot) {
+		// Rigblock ids are small and dense, a flat table beats any map here.
+		const auto& parts = snapshot.parts;
+		if (parts.empty()) {
+			return;
+		}
 
-	std::vector<PartPtr> Parts::ListAll() {
-		Load();
+		snapshot.indexById.assign(size_t(parts.back().rigblock_asset_id) + 1, NoPart);
+		for (size_t i = 0; i < parts.size() && i < NoPart; ++i) {
+			snapshot.indexById[parts[i].rigblock_asset_id] = static_cast<uint16_t>(i);
+		}
+	}
 
-		std::vector<PartPtr> l;
-		for (const auto& t : mParts)
-			l.push_back(t.second);
+	std::unique_ptr<const Parts::Snapshot> Parts::mSnapshotStorage;
+	std::atomic<const Parts::Snapshot*> Parts::mSnapshot = nullptr;
+	std::once_flag Parts::mLoadFlag;
 
-		return l;
+	std::span<const Game::Part> Parts::ListAll() {
+		return Get().parts;
 	}
 }
@@ -3,8 +3,11 @@
 #define _GAME_REPO_PART_HEADER
 
 // Include
+#include <atomic>
+#include <memory>
+#include <mutex>
 #include <string>
-#include <map>
+#include <span>
 #include <vector>
 #include "../utils/functions.h"
 #include "../game/part.h"
@@ -12,16 +15,29 @@
 // Game
 namespace Repository {
 
-	using PartPtr = std::shared_ptr<Game::Part>;
+	// Parts are read-only after Load, pointers stay valid for the lifetime of the process.
+	using PartPtr = const Game::Part*;
 
+	// Loaded once into an immutable snapshot, readers only do an atomic load and never lock.
 	class Parts {
 	public:
 		static PartPtr getById(uint16_t id);
 		static void Load();
-		static std::vector<PartPtr> ListAll();
+		static std::span<const Game::Part> ListAll();
 
 	private:
-		static std::map<uint32_t, PartPtr> mParts;
+		struct Snapshot {
+			std::vector<Game::Part> parts;
+			std::vector<uint16_t> indexById;
+		};
+
+		static const Snapshot& Get();
+		static void BuildIndex(Snapshot& snapshot);
+
+	private:
+		static std::unique_ptr<const Snapshot> mSnapshotStorage;
+		static std::atomic<const Snapshot*> mSnapshot;
+		static std::once_flag mLoadFlag;
 		friend class Game::Part;
 	};
 }
@@ -0,0 +1,304 @@
+
+// Include
+#include "persistence.h"
+#include "user.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include "../game/config.h"
+#include "../utils/logger.h"
+#include "../utils/metrics.h"
+
+#ifdef _WIN32
+#	include <windows.h>
+#else
+#	include <cerrno>
+#	include <fcntl.h>
+#	include <unistd.h>
+#endif
+
+// Repository
+namespace Repository {
+	namespace {
+		// Writes data to path and waits until it is on disk, a rename over the original is only atomic after a power loss
+		// if the new contents got there first.
+		bool write_synced(const std::string& path, const std::string& data) {
+#ifdef _WIN32
+			HANDLE file = CreateFileA(path.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+			if (file == INVALID_HANDLE_VALUE) {
+				return false;
+			}
+
+			bool ok = true;
+			for (size_t offset = 0; ok && offset < data.size();) {
+				const DWORD length = static_cast<DWORD>(std::min<size_t>(data.size() - offset, 0x4000'0000));
+				DWORD written = 0;
+				ok = WriteFile(file, data.data() + offset, length, &written, nullptr) && written > 0;
+				offset += written;
+			}
+
+			ok = ok && FlushFileBuffers(file);
+			return CloseHandle(file) && ok;
+#else
+			int file = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+			if (file < 0) {
+				return false;
+			}
+
+			bool ok = true;
+			for (size_t offset = 0; ok && offset < data.size();) {
+				const auto written = ::write(file, data.data() + offset, data.size() - offset);
+				if (written > 0) {
+					offset += static_cast<size_t>(written);
+				} else {
+					ok = written < 0 && errno == EINTR;
+				}
+			}
+
+			ok = ok && ::fsync(file) == 0;
+			return ::close(file) == 0 && ok;
+#endif
+		}
+
+		bool replace_synced(const std::string& from, const std::string& to) {
+#ifdef _WIN32
+			// Write-through so the rename itself is on disk when this returns.
+			return MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH);
+#else
+			if (::rename(from.c_str(), to.c_str()) != 0) {
+				return false;
+			}
+
+			// The new directory entry only survives a power loss once the directory is synced as well.
+			auto directory = std::filesystem::path(to).parent_path();
+			if (directory.empty()) {
+				directory = ".";
+			}
+
+			int handle = ::open(directory.c_str(), O_RDONLY);
+			if (handle >= 0) {
+				::fsync(handle);
+				::close(handle);
+			}
+			return true;
+#endif
+		}
+	}
+
+	std::unordered_map<std::string, Persistence::Entry> Persistence::sEntries;
+	std::deque<Persistence::Job> Persistence::sJobs;
+
+	std::mutex Persistence::sMutex;
+	std::condition_variable Persistence::sCondition;
+	std::thread Persistence::sThread;
+
+	std::unique_ptr<boost::asio::steady_timer> Persistence::sTimer;
+	Persistence::Clock::duration Persistence::sInterval;
+
+	bool Persistence::sRunning = false;
+
+	void Persistence::Start(boost::asio::io_context& io) {
+		if (sRunning) {
+			return;
+		}
+
+		sInterval = std::chrono::seconds(utils::to_number<uint32_t>(Game::Config::Get(Game::CONFIG_USER_SAVE_INTERVAL)));
+		sRunning = true;
+		sThread = std::thread(&Persistence::RunWriter);
+
+		sTimer = std::make_unique<boost::asio::steady_timer>(io);
+		ScheduleFlush();
+	}
+
+	void Persistence::Stop() {
+		if (!sRunning) {
+			return;
+		}
+
+		if (sTimer) {
+			sTimer->cancel();
+			sTimer.reset();
+		}
+
+		// Everything still dirty is written before the writer thread exits.
+		Flush(true);
+		{
+			std::lock_guard<std::mutex> lock(sMutex);
+			sRunning = false;
+		}
+		sCondition.notify_one();
+		sThread.join();
+
+		sEntries.clear();
+	}
+
+	void Persistence::MarkDirty(const Game::UserPtr& user) {
+		if (!user) {
+			return;
+		}
+
+		user->Touch();
+		if (!sRunning) {
+			Users::SaveUser(user);
+			return;
+		}
+
+		std::lock_guard<std::mutex> lock(sMutex);
+
+		auto& entry = sEntries[user->get_email()];
+		entry.user = user;
+		entry.version++;
+	}
+
+	Game::UserPtr Persistence::GetPendingUser(const std::string& email) {
+		std::lock_guard<std::mutex> lock(sMutex);
+
+		auto it = sEntries.find(email);
+		return (it != sEntries.end()) ? it->second.user : nullptr;
+	}
+
+	bool Persistence::WriteFile(const std::string& path, const std::string& data) {
+		static auto& writeDuration = metrics::registry::get_histogram("repository_write_duration_seconds", "Time spent writing storage files.");
+		static auto& writeBytes = metrics::registry::get_counter("repository_write_bytes_total", "Bytes written to storage files.");
+		metrics::scoped_timer timer(writeDuration);
+		writeBytes.add(data.size());
+
+		const std::string temporaryPath = path + ".tmp";
+
+		std::error_code error;
+		if (!write_synced(temporaryPath, data) || !replace_synced(temporaryPath, path)) {
+			std::filesystem::remove(temporaryPath, error);
+			return false;
+		}
+
+		return true;
+	}
+
+	void Persistence::QueueWrite(const std::string& path, std::string data) {
+		if (!sRunning) {
+			if (!WriteFile(path, data)) {
+				logger::error("Persistence: could not write " + path);
+			}
+			return;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(sMutex);
+
+			Job job;
+			job.path = path;
+			job.data = std::move(data);
+			sJobs.push_back(std::move(job));
+		}
+		sCondition.notify_one();
+	}
+
+	void Persistence::ScheduleFlush() {
+		const auto tick = std::clamp<Clock::duration>(sInterval, std::chrono::milliseconds(100), std::chrono::seconds(1));
+
+		sTimer->expires_after(tick);
+		sTimer->async_wait([](const boost::system::error_code& error) {
+			if (!error && sTimer) {
+				Flush(false);
+				ScheduleFlush();
+			}
+		});
+	}
+
+	void Persistence::Flush(bool force) {
+		const auto now = Clock::now();
+
+		std::vector<Game::UserPtr> users;
+		{
+			std::lock_guard<std::mutex> lock(sMutex);
+			for (auto it = sEntries.begin(); it != sEntries.end();) {
+				auto& entry = it->second;
+				if (entry.queuedVersion != entry.version) {
+					if (force || now - entry.lastWrite >= sInterval) {
+						users.push_back(entry.user);
+					}
+				} else if (entry.writtenVersion == entry.version && now - entry.lastWrite >= sInterval) {
+					// Written and untouched for a whole interval, the file is the source of truth again.
+					it = sEntries.erase(it);
+					continue;
+				}
+				++it;
+			}
+		}
+
+		for (const auto& user : users) {
+			QueueUser(user, now);
+		}
+		sCondition.notify_one();
+	}
+
+	void Persistence::QueueUser(const Game::UserPtr& user, Clock::time_point now) {
+		// Serialized here on the io thread, the writer thread only ever sees the finished bytes. The user lock is
+		// taken before sMutex, the same order as a request calling MarkDirty.
+		auto userLock = user->Lock();
+
+		static auto& serializeDuration = metrics::registry::get_histogram("repository_serialize_duration_seconds", "Time spent serializing stored data.", { { "store", "user" } });
+		std::ostringstream stream;
+		{
+			metrics::scoped_timer timer(serializeDuration);
+			user->ToXml().save(stream, "\t", 1U, pugi::encoding_latin1);
+		}
+
+		std::lock_guard<std::mutex> lock(sMutex);
+
+		auto it = sEntries.find(user->get_email());
+		if (it == sEntries.end()) {
+			return;
+		}
+
+		auto& entry = it->second;
+
+		Job job;
+		job.path = Game::Config::Get(Game::CONFIG_STORAGE_PATH) + "users/" + user->get_email() + ".xml";
+		job.data = stream.str();
+		job.email = user->get_email();
+		job.version = entry.version;
+		sJobs.push_back(std::move(job));
+
+		entry.queuedVersion = entry.version;
+		entry.lastWrite = now;
+	}
+
+	void Persistence::RunWriter() {
+		std::unique_lock<std::mutex> lock(sMutex);
+		while (true) {
+			sCondition.wait(lock, [] { return !sJobs.empty() || !sRunning; });
+			if (sJobs.empty()) {
+				break;
+			}
+
+			Job job = std::move(sJobs.front());
+			sJobs.pop_front();
+
+			lock.unlock();
+			bool written = WriteFile(job.path, job.data);
+			if (!written) {
+				logger::error("Persistence: could not write " + job.path);
+			}
+			lock.lock();
+
+			if (job.email.empty()) {
+				continue;
+			}
+
+			auto it = sEntries.find(job.email);
+			if (it == sEntries.end()) {
+				continue;
+			}
+
+			auto& entry = it->second;
+			if (written) {
+				entry.writtenVersion = std::max(entry.writtenVersion, job.version);
+			} else if (entry.queuedVersion == job.version) {
+				// Retried on the next flush.
+				entry.queuedVersion = job.version - 1;
+			}
+		}
+	}
+}
@@ -0,0 +1,75 @@
+
+#ifndef _GAME_REPO_PERSISTENCE_HEADER
+#define _GAME_REPO_PERSISTENCE_HEADER
+
+// Include
+#include <string>
+#include <unordered_map>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <memory>
+#include <boost/asio.hpp>
+#include "../game/user.h"
+
+// Game
+namespace Repository {
+
+	// Write-behind storage for users. Mutations only mark a user dirty, the user is serialized on the io thread
+	// at most once per USER_SAVE_INTERVAL seconds and the file is written by a background thread.
+	class Persistence {
+		public:
+			static void Start(boost::asio::io_context& io);
+			static void Stop();
+
+			static void MarkDirty(const Game::UserPtr& user);
+
+			// Users that are dirty or still being written, so a fresh login never reads an outdated file.
+			static Game::UserPtr GetPendingUser(const std::string& email);
+
+			// Writes to a temporary file next to path and renames it over path.
+			static bool WriteFile(const std::string& path, const std::string& data);
+			static void QueueWrite(const std::string& path, std::string data);
+
+		private:
+			using Clock = std::chrono::steady_clock;
+
+			struct Entry {
+				Game::UserPtr user;
+				Clock::time_point lastWrite;
+				uint64_t version = 0;
+				uint64_t queuedVersion = 0;
+				uint64_t writtenVersion = 0;
+			};
+
+			struct Job {
+				std::string path;
+				std::string data;
+				std::string email;
+				uint64_t version = 0;
+			};
+
+			static void ScheduleFlush();
+			static void Flush(bool force);
+
+			static void QueueUser(const Game::UserPtr& user, Clock::time_point now);
+			static void RunWriter();
+
+		private:
+			static std::unordered_map<std::string, Entry> sEntries;
+			static std::deque<Job> sJobs;
+
+			static std::mutex sMutex;
+			static std::condition_variable sCondition;
+			static std::thread sThread;
+
+			static std::unique_ptr<boost::asio::steady_timer> sTimer;
+			static Clock::duration sInterval;
+
+			static bool sRunning;
+	};
+}
+
+#endif
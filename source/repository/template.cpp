@@ -1,48 +1,75 @@
 
 // Include
 #include "template.h"
+#include "catalog.h"
 #include <algorithm>
 #include "../game/config.h"
+#include "../utils/logger.h"
+#include "../utils/metrics.h"
 
 // Repository
 namespace Repository {
 	
 	CreatureTemplatePtr CreatureTemplates::getById(uint32_t id) {
-		Load();
-		
-		CreatureTemplatePtr creatureTemplate;
+		const auto& templates = Get();
 
-		auto it = mTemplates.find(id);
-		if (it != mTemplates.end()) {
-			creatureTemplate = it->second;
+		auto it = std::lower_bound(templates.begin(), templates.end(), id, [](const auto& creatureTemplate, uint32_t value) {
+			return creatureTemplate.id < value;
+		});
+
+		if (it != templates.end() && it->id == id) {
+			return &*it;
 		}
 
-		return creatureTemplate;
+		return nullptr;
+	}
+
+	const CreatureTemplates::Snapshot& CreatureTemplates::Get() {
+		auto snapshot = mSnapshot.load(std::memory_order_acquire);
+		if (!snapshot) {
+			Load();
+			snapshot = mSnapshot.load(std::memory_order_acquire);
+		}
+		return *snapshot;
 	}
 
 	void CreatureTemplates::Load() {
-		if (!mTemplates.empty()) return;
+		std::call_once(mLoadFlag, [] {
+			metrics::scoped_timer timer(metrics::registry::get_histogram("repository_load_duration_seconds", "Time spent loading stored data.", { { "store", "templates" } }));
 
-		std::string jsonFilePath = Game::Config::Get(Game::CONFIG_STORAGE_PATH) + "/templates.json";
-		auto templatesList = utils::json::FromFile(jsonFilePath);
+			auto templates = std::make_unique<Snapshot>();
 
-		for (auto& creatureNode : templatesList.GetArray()) {
-			CreatureTemplatePtr creature = std::make_shared<Game::CreatureTemplate>();
-			creature->ReadJson(creatureNode);
-			mTemplates.emplace(creature->id, creature);
-		}
-	}
+			const std::string& storagePath = Game::Config::Get(Game::CONFIG_STORAGE_PATH);
+			std::string jsonFilePath = storagePath + "/templates.json";
+
+			Catalog catalog;
+			if (catalog.Open(storagePath + "/catalog.bin", jsonFilePath)) {
+				catalog.ReadTemplates(*templates);
+			} else {
+				auto templatesList = utils::json::FromFile(jsonFilePath);
+				if (templatesList.IsArray()) {
+					for (auto& creatureNode : templatesList.GetArray()) {
+						templates->emplace_back().ReadJson(creatureNode);
+					}
+				}
 
-	std::map<uint32_t, CreatureTemplatePtr> CreatureTemplates::mTemplates;
+				std::stable_sort(templates->begin(), templates->end(), [](const auto& lhs, const auto& rhs) { return lhs.id < rhs.id; });
+				templates->erase(std::unique(templates->begin(), templates->end(), [](const auto& lhs, const auto& rhs) { return lhs.id == rhs.id; }), templates->end());
+			}
 
-	std::vector<CreatureTemplatePtr> CreatureTemplates::ListAll() {
-		Load();
+			logger::info("CreatureTemplates: loaded " + std::to_string(templates->size()) + " templates");
+
+			// Published once and never replaced, so handed out pointers stay valid.
+			mSnapshotStorage = std::move(templates);
+			mSnapshot.store(mSnapshotStorage.get(), std::memory_order_release);
+		});
+	}
 
-		std::vector<CreatureTemplatePtr> l;
+	std::unique_ptr<const CreatureTemplates::Snapshot> CreatureTemplates::mSnapshotStorage;
+	std::atomic<const CreatureTemplates::Snapshot*> CreatureTemplates::mSnapshot = nullptr;
+	std::once_flag CreatureTemplates::mLoadFlag;
 
-		for (const auto& t : mTemplates)
-			l.push_back(t.second);
-		
-		return l;
+	std::span<const Game::CreatureTemplate> CreatureTemplates::ListAll() {
+		return Get();
 	}
 }
@@ -3,8 +3,11 @@
 #define _GAME_REPO_TEMPLATE_HEADER
 
 // Include
+#include <atomic>
+#include <memory>
+#include <mutex>
 #include <string>
-#include <map>
+#include <span>
 #include <vector>
 #include "../utils/functions.h"
 #include "../game/template.h"
@@ -12,16 +15,25 @@
 // Game
 namespace Repository {
 
-	using CreatureTemplatePtr = std::shared_ptr<Game::CreatureTemplate>;
+	// Templates are read-only after Load, pointers stay valid for the lifetime of the process.
+	using CreatureTemplatePtr = const Game::CreatureTemplate*;
 
+	// Loaded once into an immutable snapshot, readers only do an atomic load and never lock.
 	class CreatureTemplates {
 		public:
 			static CreatureTemplatePtr getById(uint32_t id);
 			static void Load();
-			static std::vector<CreatureTemplatePtr> ListAll();
+			static std::span<const Game::CreatureTemplate> ListAll();
 
 		private:
-			static std::map<uint32_t, CreatureTemplatePtr> mTemplates;
+			using Snapshot = std::vector<Game::CreatureTemplate>;
+
+			static const Snapshot& Get();
+
+		private:
+			static std::unique_ptr<const Snapshot> mSnapshotStorage;
+			static std::atomic<const Snapshot*> mSnapshot;
+			static std::once_flag mLoadFlag;
 			friend class Game::CreatureTemplate;
 	};
 }
@@ -1,15 +1,22 @@
 
 // Include
 #include "user.h"
+#include "persistence.h"
 #include <algorithm>
 #include <filesystem>
+#include <sstream>
 #include "../game/config.h"
 #include "../repository/userpart.h"
+#include "../utils/logger.h"
+#include "../utils/metrics.h"
+#include "../utils/trace.h"
 
 // Repository
 namespace Repository {
 
-	std::map<std::string, Game::UserPtr> Users::sUsersByEmail;
+	utils::sharded_map<std::string, Game::UserPtr> Users::sUsersByEmail;
+	utils::sharded_map<std::string, Game::UserPtr> Users::sUsersByAuthToken;
+	utils::sharded_map<std::string, Game::UserPtr> Users::sPreloadedUsers;
 
 	std::vector<std::string> Users::GetAllUserNames() {
 		std::vector<std::string> users;
@@ -27,14 +34,17 @@ namespace Repository {
 	std::vector<std::string> Users::GetLoggedUserNames() {
 		std::vector<std::string> users;
 
-		for (const auto& pair : sUsersByEmail) {
-			users.push_back(pair.first);
-		}
+		sUsersByEmail.for_each([&users](const std::string& email, const Game::UserPtr&) {
+			users.push_back(email);
+		});
 
 		return users;
 	}
 
 	bool Users::LoadUserFromFile(Game::UserPtr userPtr) {
+		static auto& loadDuration = metrics::registry::get_histogram("repository_load_duration_seconds", "Time spent loading stored data.", { { "store", "user" } });
+		metrics::scoped_timer timer(loadDuration);
+
 		std::string filepath = Game::Config::Get(Game::CONFIG_STORAGE_PATH) + "users/" + userPtr->get_email() + ".xml";
 
 		pugi::xml_document document;
@@ -51,43 +61,55 @@ namespace Repository {
 			userPtr->get_creatures().ReadXml(user);
 			userPtr->get_squads().ReadXml(user, userPtr->get_creatures());
 			userPtr->get_feed().ReadXml(user);
+			userPtr->Touch();
 		}
 
 		return true;
 	}
 
 	Game::UserPtr Users::GetUserByEmail(const std::string& email, const bool shouldLogin) {
-		Game::UserPtr user;
+		Game::UserPtr user = sUsersByEmail.find(email);
+		if (user) {
+			return user;
+		}
 
-		auto it = sUsersByEmail.find(email);
-		if (it != sUsersByEmail.end()) {
-			user = it->second;
+		if (auto pendingUser = Persistence::GetPendingUser(email)) {
+			// Logged out recently and not written yet, the file would be outdated.
+			user = pendingUser;
+		}
+		else if ((user = sPreloadedUsers.find(email))) {
+			// Read at startup, the first login takes it over and everything after that goes through Persistence.
+			if (shouldLogin) {
+				sPreloadedUsers.erase(email);
+			}
 		}
 		else {
 			user = std::make_shared<Game::User>(email);
-			if (LoadUserFromFile(user)) {
-				if (shouldLogin) sUsersByEmail.emplace(email, user);
-			}
-			else {
-				user.reset();
+			if (!LoadUserFromFile(user)) {
+				return nullptr;
 			}
 		}
 
+		if (shouldLogin) {
+			// Another thread may have logged the same user in meanwhile, everyone has to share its instance.
+			user = LoginUser(user);
+		}
+
 		return user;
 	}
 
 	bool Users::SaveUser(Game::UserPtr userPtr) {
-		pugi::xml_document document = userPtr->ToXml();
+		std::ostringstream stream;
+		userPtr->ToXml().save(stream, "\t", 1U, pugi::encoding_latin1);
+
 		std::string filepath = Game::Config::Get(Game::CONFIG_STORAGE_PATH) + "users/" + userPtr->get_email() + ".xml";
-		return document.save_file(filepath.c_str(), "\t", 1U, pugi::encoding_latin1);
+		return Persistence::WriteFile(filepath, stream.str());
 	}
 
 
 	Game::UserPtr Users::CreateUserWithNameMailAndPassword(const std::string& name, const std::string& email, const std::string& password) {
 		Game::UserPtr user;
-
-		auto it = sUsersByEmail.find(email);
-		if (it != sUsersByEmail.end()) {
+		if (sUsersByEmail.contains(email)) {
 			return NULL;
 		}
 		else {
@@ -96,10 +118,7 @@ namespace Repository {
 			srand(time(NULL));
 			user->get_account().id = rand();
 
-			if (SaveUser(user)) {
-				sUsersByEmail.emplace(email, user);
-			}
-			else {
+			if (!SaveUser(user) || LoginUser(user) != user) {
 				user.reset();
 			}
 		}
@@ -108,19 +127,77 @@ namespace Repository {
 	}
 
 	Game::UserPtr Users::GetUserByAuthToken(const std::string& authToken) {
-		for (const auto& [_, user] : sUsersByEmail) {
-			if (user->get_auth_token() == authToken) {
-				return user;
+		return sUsersByAuthToken.find(authToken);
+	}
+
+	size_t Users::Preload(size_t count) {
+		std::vector<std::pair<std::filesystem::file_time_type, std::string>> files;
+
+		std::error_code error;
+		std::string folderPath = Game::Config::Get(Game::CONFIG_STORAGE_PATH) + "users/";
+		for (const auto& entry : std::filesystem::directory_iterator(folderPath, error)) {
+			if (entry.path().extension() == ".xml") {
+				files.emplace_back(entry.last_write_time(error), entry.path().stem().string());
 			}
 		}
-		return nullptr;
+
+		// Whoever played last is the most likely to come back first.
+		count = std::min(count, files.size());
+		std::partial_sort(files.begin(), files.begin() + count, files.end(), std::greater<>());
+
+		size_t loaded = 0;
+		for (size_t i = 0; i < count; ++i) {
+			auto user = std::make_shared<Game::User>(files[i].second);
+			if (LoadUserFromFile(user)) {
+				sPreloadedUsers.emplace(user->get_email(), user);
+				loaded++;
+			}
+		}
+
+		logger::info("Users: preloaded " + std::to_string(loaded) + " users");
+		return loaded;
+	}
+
+	Game::UserPtr Users::LoginUser(Game::UserPtr userPtr) {
+		static auto& loggedUsers = metrics::registry::get_gauge("repository_logged_in_users", "Users that are logged in.");
+
+		auto user = sUsersByEmail.emplace(userPtr->get_email(), userPtr);
+		if (user == userPtr) {
+			loggedUsers.add();
+
+			const auto traceId = trace::new_id();
+			userPtr->set_trace_id(traceId);
+			if (trace::enabled()) {
+				// Trace files get passed around, they name sessions by account id and never by email.
+				trace::name(traceId, "user " + std::to_string(userPtr->get_id()));
+			}
+
+			const auto& authToken = userPtr->get_auth_token();
+			if (!authToken.empty()) {
+				sUsersByAuthToken.insert_or_assign(authToken, userPtr);
+			}
+		}
+		return user;
 	}
 
 	void Users::LogoutUser(Game::UserPtr userPtr) {
-		auto it = sUsersByEmail.find(userPtr->get_email());
-		if (it != sUsersByEmail.end()) {
-			sUsersByEmail.erase(it);
+		static auto& loggedUsers = metrics::registry::get_gauge("repository_logged_in_users", "Users that are logged in.");
+		if (sUsersByEmail.erase_if(userPtr->get_email(), [&userPtr](const Game::UserPtr& user) { return user == userPtr; })) {
+			loggedUsers.sub();
+			trace::instant(userPtr->get_trace_id(), trace::track::blaze, "Logout");
+			userPtr->set_trace_id(0);
+		}
+		sUsersByAuthToken.erase_if(userPtr->get_auth_token(), [&userPtr](const Game::UserPtr& user) { return user == userPtr; });
+		Persistence::MarkDirty(userPtr);
+	}
+
+	void Users::OnAuthTokenChanged(const Game::User& user, const std::string& oldAuthToken) {
+		sUsersByAuthToken.erase_if(oldAuthToken, [&user](const Game::UserPtr& tokenUser) { return tokenUser.get() == &user; });
+
+		// Only logged in users can be found by their token.
+		auto loggedUser = sUsersByEmail.find(user.get_email());
+		if (loggedUser.get() == &user && !user.get_auth_token().empty()) {
+			sUsersByAuthToken.insert_or_assign(user.get_auth_token(), loggedUser);
 		}
-		SaveUser(userPtr);
 	}
 }
@@ -4,31 +4,45 @@
 
 // Include
 #include <string>
-#include <map>
+#include <unordered_map>
 #include <vector>
 #include "../utils/functions.h"
+#include "../utils/shardedmap.h"
 #include "../game/user.h"
 
 // Game
 namespace Repository {
 
+	// Logged in users, safe to use from any thread. Changing a user itself needs Game::User::Lock.
 	class Users {
 		public:
 			static std::vector<std::string> GetAllUserNames();
 			static std::vector<std::string> GetLoggedUserNames();
 			static Game::UserPtr GetUserByEmail(const std::string& email, const bool shouldLogin);
 			
+			// Writes the user right away, request handlers use Persistence::MarkDirty instead.
 			static bool SaveUser(Game::UserPtr userPtr);
 			static void LogoutUser(Game::UserPtr userPtr);
 			
 			static Game::UserPtr CreateUserWithNameMailAndPassword(const std::string& name, const std::string& email, const std::string& password);
 			static Game::UserPtr GetUserByAuthToken(const std::string& authToken);
 
+			// Reads the most recently saved users ahead of their login, returns how many were read.
+			static size_t Preload(size_t count);
+
 		private:
 			static bool LoadUserFromFile(Game::UserPtr user);
 
+			// Returns the user that ends up logged in, an earlier instance with the same email wins.
+			static Game::UserPtr LoginUser(Game::UserPtr userPtr);
+			static void OnAuthTokenChanged(const Game::User& user, const std::string& oldAuthToken);
+
 		private:
-			static std::map<std::string, Game::UserPtr> sUsersByEmail;
+			static utils::sharded_map<std::string, Game::UserPtr> sUsersByEmail;
+			static utils::sharded_map<std::string, Game::UserPtr> sUsersByAuthToken;
+
+			// Read by Preload and not logged in yet.
+			static utils::sharded_map<std::string, Game::UserPtr> sPreloadedUsers;
 
 			friend class Game::User;
 	};
@@ -1,83 +1,331 @@
 
 // Include
 #include "userpart.h"
+#include "persistence.h"
 #include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <unordered_map>
 #include "../game/config.h"
 #include "../utils/logger.h"
+#include "../utils/metrics.h"
 
 // Repository
 namespace Repository {
 
+	namespace {
+		// The log is folded into the snapshot once it has more lines than this or than there are parts.
+		constexpr size_t MinCompactEntries = 1024;
+
+		std::string GetSnapshotPath() {
+			return Game::Config::Get(Game::CONFIG_STORAGE_PATH) + "user_parts.xml";
+		}
+
+		std::string GetLogPath() {
+			return Game::Config::Get(Game::CONFIG_STORAGE_PATH) + "user_parts.log";
+		}
+
+		template<typename Index, typename Key>
+		void AddToIndex(Index& index, Key key, const Game::UserPartPtr& part) {
+			index.update(key, [&part](UserPartList& parts) {
+				auto newParts = std::make_shared<std::vector<Game::UserPartPtr>>();
+				if (parts) {
+					newParts->reserve(parts->size() + 1);
+					newParts->assign(parts->begin(), parts->end());
+				}
+				newParts->push_back(part);
+				parts = std::move(newParts);
+				return true;
+			});
+		}
+
+		template<typename Index, typename Key>
+		void RemoveFromIndex(Index& index, Key key, const Game::UserPartPtr& part) {
+			index.update(key, [&part](UserPartList& parts) {
+				if (!parts) {
+					return false;
+				}
+
+				auto newParts = std::make_shared<std::vector<Game::UserPartPtr>>();
+				newParts->reserve(parts->size());
+				std::remove_copy(parts->begin(), parts->end(), std::back_inserter(*newParts), part);
+				if (newParts->empty()) {
+					return false;
+				}
+
+				parts = std::move(newParts);
+				return true;
+			});
+		}
+	}
+
 	void UserParts::Add(Game::UserPartPtr part) {
-		mPartsById.emplace(part->id, part);
+		Load();
+		if (mPartsById.emplace(part->id, part) == part) {
+			Index(part);
+			LogUpdate(*part);
+		}
 	}
 	void UserParts::Remove(Game::UserPartPtr part) {
-		mPartsById.erase(part->id);
+		Remove(part->id);
 	}
 	void UserParts::Remove(uint64_t id) {
-		mPartsById.erase(id);
-	}
-
-	Game::UserPartPtr UserParts::getById(uint64_t id) {
 		Load();
 
 		Game::UserPartPtr part;
+		mPartsById.erase_if(id, [&part](const Game::UserPartPtr& value) {
+			part = value;
+			return true;
+		});
+
+		if (part) {
+			Unindex(part);
+			LogRemove(id);
+		}
+	}
 
-		auto it = mPartsById.find(id);
-		if (it != mPartsById.end()) {
-			part = it->second;
+	void UserParts::Update(Game::UserPartPtr part) {
+		if (part) {
+			// Only the creature a part is equipped to can change, so the user bucket stays as it is. The part joins
+			// its new creature before it leaves the old one, a concurrent ListByCreature never misses it.
+			uint32_t indexedCreatureId = mIndexedCreatureIds.find(part->id);
+			if (indexedCreatureId != part->equipped_to_creature_id) {
+				if (part->equipped_to_creature_id != 0) {
+					AddToIndex(mPartsByCreature, part->equipped_to_creature_id, part);
+					mIndexedCreatureIds.insert_or_assign(part->id, part->equipped_to_creature_id);
+				} else {
+					mIndexedCreatureIds.erase(part->id);
+				}
+
+				if (indexedCreatureId != 0) {
+					RemoveFromIndex(mPartsByCreature, indexedCreatureId, part);
+				}
+			}
+			LogUpdate(*part);
 		}
+	}
 
-		return part;
+	Game::UserPartPtr UserParts::getById(uint64_t id) {
+		Load();
+		return mPartsById.find(id);
 	}
 
 	void UserParts::Load() {
-		if (!mPartsById.empty()) return;
+		std::call_once(mLoadFlag, [] {
+			static auto& loadDuration = metrics::registry::get_histogram("repository_load_duration_seconds", "Time spent loading stored data.", { { "store", "user_parts" } });
+			metrics::scoped_timer timer(loadDuration);
 
-		std::string filepath = Game::Config::Get(Game::CONFIG_STORAGE_PATH) + "user_parts.xml";
+			std::string filepath = GetSnapshotPath();
 
-		pugi::xml_document document;
-		if (!document.load_file(filepath.c_str())) {
 			pugi::xml_document document;
-			document.append_child("parts");
-			document.save_file(filepath.c_str(), "\t", 1U, pugi::encoding_latin1);
+			if (!document.load_file(filepath.c_str())) {
+				pugi::xml_document document;
+				document.append_child("parts");
+				document.save_file(filepath.c_str(), "\t", 1U, pugi::encoding_latin1);
+			} else {
+				auto parts = document.child("parts");
+				if (!parts) {
+					parts = document.append_child("parts");
+				}
+
+				for (const auto& partNode : parts) {
+					auto part = std::make_shared<Game::UserPart>(partNode);
+					mPartsById.emplace(part->id, part);
+				}
+			}
+
+			LoadLog(GetLogPath());
+			IndexAll();
+		});
+	}
+
+	void UserParts::LoadLog(const std::string& filepath) {
+		std::ifstream log(filepath);
+		if (!log.is_open()) {
 			return;
 		}
 
-		auto parts = document.child("parts");
-		if (!parts) {
-			parts = document.append_child("parts");
-		}
+		std::string line;
+		while (std::getline(log, line)) {
+			std::istringstream stream(line);
+
+			char type;
+			uint64_t id;
+			if (!(stream >> type >> id)) {
+				continue;
+			}
+
+			if (type == 'R') {
+				mPartsById.erase(id);
+			} else if (type == 'U') {
+				auto part = std::make_shared<Game::UserPart>();
+				part->id = id;
 
-		for (const auto& partNode : parts) {
-			Add(std::make_shared<Game::UserPart>(partNode));
+				uint32_t status, flair, rigblock;
+				if (!(stream >> part->user_id >> part->equipped_to_creature_id >> status >> flair >> part->timestamp >> rigblock)) {
+					// Only the last line can be cut short, by a crash while appending.
+					logger::warn("UserParts: skipping incomplete log entry for part " + std::to_string(id));
+					continue;
+				}
+
+				part->status = static_cast<uint8_t>(status);
+				part->flair = flair != 0;
+				part->rigblock_asset_id = static_cast<uint16_t>(rigblock);
+				mPartsById.insert_or_assign(id, part);
+			}
+			mLogEntries++;
 		}
 	}
 
 	bool UserParts::Save() {
-		pugi::xml_document document;
+		static auto& saveDuration = metrics::registry::get_histogram("repository_save_duration_seconds", "Time spent saving stored data.", { { "store", "user_parts" } });
+		metrics::scoped_timer timer(saveDuration);
+
+		std::lock_guard<std::mutex> lock(mLogMutex);
+		if (mPendingLog.empty()) {
+			return true;
+		}
 
-		auto allParts = Repository::UserParts::ListAll();
+		const auto pendingEntries = static_cast<size_t>(std::count(mPendingLog.begin(), mPendingLog.end(), '\n'));
+		if (mLogEntries + pendingEntries > std::max(MinCompactEntries, mPartsById.size())) {
+			return Compact();
+		}
+
+		std::string filepath = GetLogPath();
+
+		std::ofstream log(filepath, std::ios::binary | std::ios::app);
+		log << mPendingLog;
+		log.flush();
+		if (!log) {
+			logger::error("UserParts: could not append to " + filepath);
+			return false;
+		}
+
+		mLogEntries += pendingEntries;
+		mPendingLog.clear();
+		return true;
+	}
+
+	bool UserParts::Compact() {
+		pugi::xml_document document;
 		if (auto parts = document.append_child("parts")) {
-			uint32_t index = 0;
-			for (const auto& part : allParts) {
+			for (const auto& part : ListAll()) {
 				part->WriteSmallXml(parts);
 			}
 		}
 
-		std::string filepath = Game::Config::Get(Game::CONFIG_STORAGE_PATH) + "user_parts.xml";
-		return document.save_file(filepath.c_str(), "\t", 1U, pugi::encoding_latin1);
+		std::ostringstream stream;
+		document.save(stream, "\t", 1U, pugi::encoding_latin1);
+
+		// Replaying an old log over the new snapshot is harmless, so a crash between these two steps loses nothing.
+		if (!Persistence::WriteFile(GetSnapshotPath(), stream.str())) {
+			logger::error("UserParts: could not write " + GetSnapshotPath());
+			return false;
+		}
+
+		std::ofstream log(GetLogPath(), std::ios::binary | std::ios::trunc);
+
+		mLogEntries = 0;
+		mPendingLog.clear();
+		return true;
+	}
+
+	void UserParts::LogUpdate(const Game::UserPart& part) {
+		std::lock_guard<std::mutex> lock(mLogMutex);
+		mPendingLog += "U " + std::to_string(part.id) +
+			" " + std::to_string(part.user_id) +
+			" " + std::to_string(part.equipped_to_creature_id) +
+			" " + std::to_string(part.status) +
+			" " + std::to_string(part.flair ? 1 : 0) +
+			" " + std::to_string(part.timestamp) +
+			" " + std::to_string(part.rigblock_asset_id) + "\n";
+	}
+
+	void UserParts::LogRemove(uint64_t id) {
+		std::lock_guard<std::mutex> lock(mLogMutex);
+		mPendingLog += "R " + std::to_string(id) + "\n";
+	}
+
+	void UserParts::Index(const Game::UserPartPtr& part) {
+		AddToIndex(mPartsByUser, part->user_id, part);
+		if (part->equipped_to_creature_id != 0) {
+			AddToIndex(mPartsByCreature, part->equipped_to_creature_id, part);
+			mIndexedCreatureIds.insert_or_assign(part->id, part->equipped_to_creature_id);
+		}
+	}
+
+	void UserParts::IndexAll() {
+		// Buckets are built in one pass and published once each, adding parts one by one would copy a user's bucket per part.
+		std::unordered_map<uint64_t, std::vector<Game::UserPartPtr>> byUser;
+		std::unordered_map<uint32_t, std::vector<Game::UserPartPtr>> byCreature;
+		mPartsById.for_each([&](uint64_t, const Game::UserPartPtr& part) {
+			byUser[part->user_id].push_back(part);
+			if (part->equipped_to_creature_id != 0) {
+				byCreature[part->equipped_to_creature_id].push_back(part);
+				mIndexedCreatureIds.insert_or_assign(part->id, part->equipped_to_creature_id);
+			}
+		});
+
+		const auto publish = [](auto& index, auto& buckets) {
+			for (auto& [key, parts] : buckets) {
+				std::sort(parts.begin(), parts.end(), [](const auto& lhs, const auto& rhs) { return lhs->id < rhs->id; });
+				index.insert_or_assign(key, std::make_shared<const std::vector<Game::UserPartPtr>>(std::move(parts)));
+			}
+		};
+
+		publish(mPartsByUser, byUser);
+		publish(mPartsByCreature, byCreature);
 	}
 
-	std::map<uint64_t, Game::UserPartPtr> UserParts::mPartsById;
+	void UserParts::Unindex(const Game::UserPartPtr& part) {
+		RemoveFromIndex(mPartsByUser, part->user_id, part);
+
+		uint32_t creatureId = mIndexedCreatureIds.find(part->id);
+		if (creatureId != 0) {
+			RemoveFromIndex(mPartsByCreature, creatureId, part);
+			mIndexedCreatureIds.erase(part->id);
+		}
+	}
+
+	utils::sharded_map<uint64_t, Game::UserPartPtr> UserParts::mPartsById;
+	utils::sharded_map<uint64_t, UserPartList> UserParts::mPartsByUser;
+	utils::sharded_map<uint32_t, UserPartList> UserParts::mPartsByCreature;
+	utils::sharded_map<uint64_t, uint32_t> UserParts::mIndexedCreatureIds;
+
+	std::string UserParts::mPendingLog;
+	size_t UserParts::mLogEntries = 0;
+	std::mutex UserParts::mLogMutex;
+	std::once_flag UserParts::mLoadFlag;
 
 	std::vector<Game::UserPartPtr> UserParts::ListAll() {
 		Load();
 
 		std::vector<Game::UserPartPtr> l;
-		for (const auto& t : mPartsById)
-			l.push_back(t.second);
+		mPartsById.for_each([&l](uint64_t, const Game::UserPartPtr& part) {
+			l.push_back(part);
+		});
 
+		// Sharded maps have no order, keep the id order the std::map used to give.
+		std::sort(l.begin(), l.end(), [](const auto& lhs, const auto& rhs) { return lhs->id < rhs->id; });
 		return l;
 	}
+
+	UserPartList UserParts::ListByUser(uint64_t userId) {
+		static const UserPartList empty = std::make_shared<const std::vector<Game::UserPartPtr>>();
+
+		Load();
+
+		auto parts = mPartsByUser.find(userId);
+		return parts ? parts : empty;
+	}
+
+	UserPartList UserParts::ListByCreature(uint32_t creatureId) {
+		static const UserPartList empty = std::make_shared<const std::vector<Game::UserPartPtr>>();
+
+		Load();
+
+		auto parts = mPartsByCreature.find(creatureId);
+		return parts ? parts : empty;
+	}
 }
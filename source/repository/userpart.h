@@ -3,28 +3,63 @@
 #define _GAME_REPO_CREATUREPART_HEADER
 
 // Include
+#include <memory>
+#include <mutex>
 #include <string>
-#include <map>
 #include <vector>
 #include "../utils/functions.h"
+#include "../utils/shardedmap.h"
 #include "../game/userpart.h"
 
 // Game
 namespace Repository {
 
+	// Index lists are copied on write, a list handed out never changes and stays valid while it is held.
+	using UserPartList = std::shared_ptr<const std::vector<Game::UserPartPtr>>;
+
+	// Stored as a user_parts.xml snapshot plus user_parts.log, one line per mutation since the snapshot.
+	// Safe to use from any thread, changes to the parts of one user are serialized by Game::User::Lock.
 	class UserParts {
 	public:
 		static void Add(Game::UserPartPtr part);
 		static void Remove(Game::UserPartPtr part);
 		static void Remove(uint64_t id);
 
+		// Call after changing a part in place so the change is logged.
+		static void Update(Game::UserPartPtr part);
+
 		static Game::UserPartPtr getById(uint64_t id);
 		static void Load();
 		static bool Save();
 		static std::vector<Game::UserPartPtr> ListAll();
 
+		// Indexed, no copy. Parts that are not equipped are not in the creature index.
+		// Keep the returned list in a local while iterating it, it owns the vector.
+		static UserPartList ListByUser(uint64_t userId);
+		static UserPartList ListByCreature(uint32_t creatureId);
+
 	private:
-		static std::map<uint64_t, Game::UserPartPtr> mPartsById;
+		static void Index(const Game::UserPartPtr& part);
+		static void IndexAll();
+		static void Unindex(const Game::UserPartPtr& part);
+
+		static void LoadLog(const std::string& filepath);
+		static bool Compact();
+
+		static void LogUpdate(const Game::UserPart& part);
+		static void LogRemove(uint64_t id);
+
+	private:
+		static utils::sharded_map<uint64_t, Game::UserPartPtr> mPartsById;
+		static utils::sharded_map<uint64_t, UserPartList> mPartsByUser;
+		static utils::sharded_map<uint32_t, UserPartList> mPartsByCreature;
+		static utils::sharded_map<uint64_t, uint32_t> mIndexedCreatureIds;
+
+		static std::string mPendingLog;
+		static size_t mLogEntries;
+		static std::mutex mLogMutex;
+		static std::once_flag mLoadFlag;
+
 		friend class Game::UserPart;
 	};
 }
@@ -0,0 +1,137 @@
+
+// Include
+#include "compression.h"
+#include <algorithm>
+#include <array>
+#include <boost/beast/zlib/deflate_stream.hpp>
+
+// compression
+namespace compression {
+	namespace {
+		// RFC 1952: no name, no mtime, unknown OS.
+		constexpr char GzipHeader[] { '\x1F', '\x8B', '\x08', '\x00', '\x00', '\x00', '\x00', '\x00', '\x00', '\xFF' };
+
+		// RFC 1950: 32K window, default level.
+		constexpr char ZlibHeader[] { '\x78', '\x9C' };
+
+		constexpr auto CrcTable = [] {
+			std::array<uint32_t, 256> table {};
+			for (uint32_t i = 0; i < 256; ++i) {
+				uint32_t value = i;
+				for (int bit = 0; bit < 8; ++bit) {
+					value = (value & 1) ? (0xEDB88320 ^ (value >> 1)) : (value >> 1);
+				}
+				table[i] = value;
+			}
+			return table;
+		}();
+
+		void write_u32_le(std::string& out, uint32_t value) {
+			for (int i = 0; i < 4; ++i) {
+				out += static_cast<char>((value >> (i * 8)) & 0xFF);
+			}
+		}
+
+		void write_u32_be(std::string& out, uint32_t value) {
+			for (int i = 3; i >= 0; --i) {
+				out += static_cast<char>((value >> (i * 8)) & 0xFF);
+			}
+		}
+
+		// Raw deflate of data appended to out. Without finish the blocks end on a byte boundary but not as
+		// the last block, so more blocks can follow.
+		void deflate_into(std::string& out, std::string_view data, int level, bool finish) {
+			boost::beast::zlib::deflate_stream stream;
+			stream.reset(level, 15, 8, boost::beast::zlib::Strategy::normal);
+
+			const size_t offset = out.size();
+			out.resize(offset + stream.upper_bound(data.size()) + 16);
+
+			boost::beast::zlib::z_params params;
+			params.next_in = data.data();
+			params.avail_in = data.size();
+			params.next_out = &out[offset];
+			params.avail_out = out.size() - offset;
+
+			// upper_bound leaves room for everything, so a single call always gets all of it out.
+			boost::beast::error_code error;
+			stream.write(params, finish ? boost::beast::zlib::Flush::finish : boost::beast::zlib::Flush::sync, error);
+
+			out.resize(offset + params.total_out);
+		}
+	}
+
+	std::string gzip(std::string_view data, int level) {
+		std::string out(std::begin(GzipHeader), std::end(GzipHeader));
+		deflate_into(out, data, level, true);
+		write_u32_le(out, crc32(0, data));
+		write_u32_le(out, static_cast<uint32_t>(data.size()));
+		return out;
+	}
+
+	std::string zlib(std::string_view data, int level) {
+		std::string out(std::begin(ZlibHeader), std::end(ZlibHeader));
+		deflate_into(out, data, level, true);
+		write_u32_be(out, adler32(1, data));
+		return out;
+	}
+
+	uint32_t crc32(uint32_t crc, std::string_view data) {
+		crc = ~crc;
+		for (unsigned char c : data) {
+			crc = CrcTable[(crc ^ c) & 0xFF] ^ (crc >> 8);
+		}
+		return ~crc;
+	}
+
+	uint32_t adler32(uint32_t adler, std::string_view data) {
+		constexpr uint32_t Base = 65521;
+
+		// 5552 bytes is the most that can be summed before the 32 bit sums could overflow.
+		uint32_t a = adler & 0xFFFF;
+		uint32_t b = adler >> 16;
+		while (!data.empty()) {
+			const size_t length = std::min<size_t>(data.size(), 5552);
+			for (size_t i = 0; i < length; ++i) {
+				a += static_cast<unsigned char>(data[i]);
+				b += a;
+			}
+			a %= Base;
+			b %= Base;
+			data.remove_prefix(length);
+		}
+		return (b << 16) | a;
+	}
+
+	// prefix
+	prefix::prefix(std::string_view data, int level) :
+		mCrc(crc32(0, data)), mAdler(adler32(1, data)), mSize(data.size())
+	{
+		deflate_into(mDeflated, data, level, false);
+	}
+
+	bool prefix::matches(std::string_view body) const {
+		return body.size() >= mSize && crc32(0, body.substr(0, mSize)) == mCrc;
+	}
+
+	std::string prefix::gzip(std::string_view rest, int level) const {
+		std::string out;
+		out.reserve(sizeof(GzipHeader) + mDeflated.size() + rest.size() / 2 + 64);
+		out.append(std::begin(GzipHeader), std::end(GzipHeader));
+		out += mDeflated;
+		deflate_into(out, rest, level, true);
+		write_u32_le(out, crc32(mCrc, rest));
+		write_u32_le(out, static_cast<uint32_t>(mSize + rest.size()));
+		return out;
+	}
+
+	std::string prefix::zlib(std::string_view rest, int level) const {
+		std::string out;
+		out.reserve(sizeof(ZlibHeader) + mDeflated.size() + rest.size() / 2 + 64);
+		out.append(std::begin(ZlibHeader), std::end(ZlibHeader));
+		out += mDeflated;
+		deflate_into(out, rest, level, true);
+		write_u32_be(out, adler32(mAdler, rest));
+		return out;
+	}
+}
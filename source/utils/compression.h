@@ -0,0 +1,45 @@
+
+#ifndef _UTILS_COMPRESSION_HEADER
+#define _UTILS_COMPRESSION_HEADER
+
+// Include
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// compression, gzip and zlib on top of the deflate implementation that ships with beast so no zlib is needed.
+namespace compression {
+	// Levels are the usual 1 (fastest) to 9 (smallest).
+	std::string gzip(std::string_view data, int level = 6);
+
+	// What HTTP calls the deflate content coding.
+	std::string zlib(std::string_view data, int level = 6);
+
+	uint32_t crc32(uint32_t crc, std::string_view data);
+	uint32_t adler32(uint32_t adler, std::string_view data);
+
+	// prefix, the start of many bodies compressed once. Each body then only compresses what follows it,
+	// the deflate blocks of both parts are simply written one after the other.
+	class prefix {
+		public:
+			prefix(std::string_view data, int level = 9);
+
+			// For a body that is the data given to the constructor followed by rest.
+			std::string gzip(std::string_view rest, int level = 6) const;
+			std::string zlib(std::string_view rest, int level = 6) const;
+
+			// True when body starts with the data given to the constructor.
+			bool matches(std::string_view body) const;
+
+			size_t size() const { return mSize; }
+			size_t compressed_size() const { return mDeflated.size(); }
+
+		private:
+			std::string mDeflated;
+			uint32_t mCrc;
+			uint32_t mAdler;
+			size_t mSize;
+	};
+}
+
+#endif
@@ -6,18 +6,232 @@
 #include "../game/config.h"
 #include "logger.h"
 
+#include <algorithm>
+#include <array>
+#include <string_view>
+
 // utils
 namespace utils {
 
-	std::string EAWebKit::loadFile(std::string file) {
-		std::string contentsFolder = Game::Config::Get(Game::CONFIG_STORAGE_PATH);
-		std::string file_data = utils::get_file_text(contentsFolder + file);
+	namespace {
+		constexpr std::chrono::seconds CheckInterval { 1 };
+
+		constexpr std::array<std::string_view, 5> PlaceholderNames {
+			"", "isDev", "recap-version", "host", "game-mode"
+		};
+	}
+
+	EAWebKit::PageList EAWebKit::sPages;
+	std::unordered_map<std::string, EAWebKit::PageList::iterator> EAWebKit::sIndex;
+	size_t EAWebKit::sBytes = 0;
+
+	std::mutex EAWebKit::sMutex;
+
+	std::string EAWebKit::loadFile(std::string file, std::shared_ptr<const compression::prefix>* compressed) {
+		if (compressed) {
+			compressed->reset();
+		}
+
+		// Keyed on the resolved path, "a//b.html" and "a/./b.html" are the same page.
+		const std::string path = resolvePath(file);
+		if (path.empty()) {
+			logger::warn("EAWebKit: " + file + " is outside of the storage folder");
+			return std::string();
+		}
+
+		if (!isTemplate(path)) {
+			return utils::get_file_text(path);
+		}
+
+		const uint64_t configVersion = Game::Config::GetVersion();
+		const auto now = Clock::now();
+
+		Page page;
+		{
+			std::lock_guard<std::mutex> lock(sMutex);
+
+			auto it = sIndex.find(path);
+			if (it != sIndex.end()) {
+				auto entry = it->second;
+				sPages.splice(sPages.begin(), sPages, entry);
+				if (entry->configVersion == configVersion && now < entry->checked + CheckInterval) {
+					if (compressed) {
+						*compressed = entry->compressed;
+					}
+					return *entry->rendered;
+				}
+				page = *entry;
+			}
+		}
+
+		std::error_code error;
+		const auto writeTime = std::filesystem::last_write_time(path, error);
+		const auto size = error ? 0 : std::filesystem::file_size(path, error);
+		if (error) {
+			Remove(path);
+			return utils::get_file_text(path);
+		}
+
+		if (!page.compiled || page.writeTime != writeTime || page.size != size) {
+			page.compiled = Compile(utils::get_file_text(path));
+			page.writeTime = writeTime;
+			page.size = size;
+			page.rendered.reset();
+		}
+
+		if (!page.rendered || page.configVersion != configVersion) {
+			static const size_t minCompressSize = utils::to_number<size_t>(Game::Config::Get(Game::CONFIG_COMPRESSION_MIN_SIZE));
+
+			page.rendered = std::make_shared<const std::string>(Render(*page.compiled));
+			page.compressed = page.rendered->size() >= minCompressSize ? std::make_shared<const compression::prefix>(*page.rendered) : nullptr;
+			page.configVersion = configVersion;
+		}
+		page.path = path;
+		page.checked = now;
+
+		if (compressed) {
+			*compressed = page.compressed;
+		}
+
+		auto rendered = page.rendered;
+		Put(std::move(page));
+		return *rendered;
+	}
+
+	bool EAWebKit::isTemplate(std::string_view file) {
+		return file.ends_with(".html") || file.ends_with(".htm");
+	}
+
+	std::string EAWebKit::resolvePath(const std::string& file) {
+		std::error_code error;
+
+		auto root = std::filesystem::weakly_canonical(Game::Config::Get(Game::CONFIG_STORAGE_PATH), error);
+		if (!error && !root.has_filename()) {
+			root = root.parent_path();
+		}
+
+		const auto path = std::filesystem::weakly_canonical(Game::Config::Get(Game::CONFIG_STORAGE_PATH) + file, error);
+		if (error) {
+			return std::string();
+		}
+
+		const auto [rootEnd, pathIt] = std::mismatch(root.begin(), root.end(), path.begin(), path.end());
+		if (rootEnd != root.end()) {
+			return std::string();
+		}
+
+		return path.string();
+	}
+
+	void EAWebKit::Put(Page page) {
+		const size_t budget = GetBudget();
+		const size_t cost = GetCost(page);
+
+		std::lock_guard<std::mutex> lock(sMutex);
+
+		auto it = sIndex.find(page.path);
+		if (it != sIndex.end()) {
+			sBytes -= GetCost(*it->second);
+			sPages.erase(it->second);
+			sIndex.erase(it);
+		}
+
+		while (!sPages.empty() && sBytes + cost > budget) {
+			const auto& last = sPages.back();
+			sBytes -= GetCost(last);
+			sIndex.erase(last.path);
+			sPages.pop_back();
+		}
+
+		sPages.push_front(std::move(page));
+		sIndex.emplace(sPages.front().path, sPages.begin());
+		sBytes += cost;
+	}
+
+	void EAWebKit::Remove(const std::string& path) {
+		std::lock_guard<std::mutex> lock(sMutex);
+
+		auto it = sIndex.find(path);
+		if (it != sIndex.end()) {
+			sBytes -= GetCost(*it->second);
+			sPages.erase(it->second);
+			sIndex.erase(it);
+		}
+	}
+
+	size_t EAWebKit::GetBudget() {
+		static const size_t budget = utils::to_number<size_t>(Game::Config::Get(Game::CONFIG_ASSET_CACHE_SIZE));
+		return budget;
+	}
+
+	size_t EAWebKit::GetCost(const Page& page) {
+		return page.path.size() +
+			(page.compiled ? page.compiled->source.size() : 0) +
+			(page.rendered ? page.rendered->size() : 0) +
+			(page.compressed ? page.compressed->compressed_size() : 0);
+	}
+
+	std::shared_ptr<const EAWebKit::Template> EAWebKit::Compile(std::string source) {
+		auto compiled = std::make_shared<Template>();
+		compiled->source = std::move(source);
+
+		const std::string_view text = compiled->source;
+		const auto addLiteral = [&compiled](size_t offset, size_t length) {
+			if (length > 0) {
+				compiled->segments.push_back({ offset, length, Placeholder::None });
+				compiled->literalSize += length;
+			}
+		};
+
+		size_t literalStart = 0;
+		size_t position = text.find("{{");
+		while (position != std::string_view::npos) {
+			const size_t end = text.find("}}", position + 2);
+			if (end == std::string_view::npos) {
+				break;
+			}
+
+			const auto name = text.substr(position + 2, end - position - 2);
+			const auto it = std::find(PlaceholderNames.begin() + 1, PlaceholderNames.end(), name);
+			if (it != PlaceholderNames.end()) {
+				addLiteral(literalStart, position - literalStart);
+				compiled->segments.push_back({ position, end + 2 - position, static_cast<Placeholder>(it - PlaceholderNames.begin()) });
+				literalStart = end + 2;
+				position = text.find("{{", literalStart);
+			} else {
+				// Unknown names stay in the page as they are, like any other text.
+				position = text.find("{{", position + 2);
+			}
+		}
+		addLiteral(literalStart, text.size() - literalStart);
+
+		return compiled;
+	}
+
+	std::string EAWebKit::Render(const Template& compiled) {
+		std::array<std::string, static_cast<size_t>(Placeholder::Count)> values;
+		values[static_cast<size_t>(Placeholder::IsDev)] = "true";
+		values[static_cast<size_t>(Placeholder::RecapVersion)] = Game::Config::recapVersion();
+		values[static_cast<size_t>(Placeholder::Host)] = Game::Config::Get(Game::CONFIG_SERVER_HOST);
+		values[static_cast<size_t>(Placeholder::GameMode)] = Game::Config::GetBool(Game::CONFIG_SINGLEPLAYER_ONLY) ? "singleplayer" : "multiplayer";
+
+		size_t size = compiled.literalSize;
+		for (const auto& segment : compiled.segments) {
+			if (segment.placeholder != Placeholder::None) {
+				size += values[static_cast<size_t>(segment.placeholder)].size();
+			}
+		}
 
-		utils::string_replace(file_data, "{{isDev}}", "true");
-		utils::string_replace(file_data, "{{recap-version}}", Game::Config::recapVersion());
-		utils::string_replace(file_data, "{{host}}", Game::Config::Get(Game::CONFIG_SERVER_HOST));
-		utils::string_replace(file_data, "{{game-mode}}", Game::Config::GetBool(Game::CONFIG_SINGLEPLAYER_ONLY) ? "singleplayer" : "multiplayer");
+		std::string rendered;
+		rendered.reserve(size);
+		for (const auto& segment : compiled.segments) {
+			if (segment.placeholder == Placeholder::None) {
+				rendered.append(compiled.source, segment.offset, segment.length);
+			} else {
+				rendered += values[static_cast<size_t>(segment.placeholder)];
+			}
+		}
 
-		return file_data;
+		return rendered;
 	}
 }
@@ -3,14 +3,87 @@
 #define _UTILS_EAWEBKIT_HEADER
 
 // Include
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <list>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "compression.h"
 
 // utils
 namespace utils {
 	
+	// EAWebKit, pages for the launcher and the ingame browser with {{placeholders}} filled in from the config.
+	// Every page is split into segments once and the rendered page is kept until the file or the config changes.
+	// Only .html files are templates, anything else is read as it is and never kept.
 	class EAWebKit {
 		public:
-			static std::string loadFile(std::string file);
+			// compressed is set to the page compressed once, when it is big enough to be worth it.
+			static std::string loadFile(std::string file, std::shared_ptr<const compression::prefix>* compressed = nullptr);
+
+			static bool isTemplate(std::string_view file);
+
+			// Absolute path of a file in the storage folder, empty if it points outside of it.
+			static std::string resolvePath(const std::string& file);
+
+		private:
+			using Clock = std::chrono::steady_clock;
+
+			enum class Placeholder : uint8_t {
+				None = 0,
+				IsDev,
+				RecapVersion,
+				Host,
+				GameMode,
+				Count
+			};
+
+			struct Segment {
+				size_t offset;
+				size_t length;
+				Placeholder placeholder;
+			};
+
+			struct Template {
+				std::string source;
+				std::vector<Segment> segments;
+				size_t literalSize = 0;
+			};
+
+			struct Page {
+				std::string path;
+				std::shared_ptr<const Template> compiled;
+				std::shared_ptr<const std::string> rendered;
+				std::shared_ptr<const compression::prefix> compressed;
+				std::filesystem::file_time_type writeTime;
+				uint64_t size = 0;
+				uint64_t configVersion = 0;
+				Clock::time_point checked;
+			};
+
+			using PageList = std::list<Page>;
+
+			static std::shared_ptr<const Template> Compile(std::string source);
+			static std::string Render(const Template& compiled);
+
+			static void Put(Page page);
+			static void Remove(const std::string& path);
+
+			static size_t GetBudget();
+			static size_t GetCost(const Page& page);
+
+		private:
+			// Most recently used first, bounded by ASSET_CACHE_SIZE like the asset cache.
+			static PageList sPages;
+			static std::unordered_map<std::string, PageList::iterator> sIndex;
+			static size_t sBytes;
+
+			static std::mutex sMutex;
 	};
 }
 
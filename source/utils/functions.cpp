@@ -36,9 +36,14 @@ namespace utils {
 
 	// Strings
 	void string_replace(std::string& str, const std::string& old_str, const std::string& new_str) {
+		if (old_str.empty()) {
+			return;
+		}
+
 		auto position = str.find(old_str);
-		if (position != std::string::npos) {
+		while (position != std::string::npos) {
 			str.replace(position, old_str.length(), new_str);
+			position = str.find(old_str, position + new_str.length());
 		}
 	}
 
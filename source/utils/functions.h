@@ -7,8 +7,6 @@
 #include <vector>
 #include <string>
 #include <pugixml.hpp>
-#include "json.h"
-#include "xml.h"
 
 // utils
 namespace utils {
@@ -116,4 +114,8 @@ namespace utils {
 	}
 }
 
+// Last, xml.h uses to_number.
+#include "json.h"
+#include "xml.h"
+
 #endif
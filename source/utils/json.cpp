@@ -20,11 +20,17 @@ namespace utils {
         return document;
     }
 	rapidjson::Document json::FromFile(const std::string& fileName) {
+		rapidjson::Document document;
+
 		FILE* pFile = fopen(fileName.c_str(), "rb");
+		if (!pFile) {
+			return document;
+		}
+
 		char buffer[65536];
 		rapidjson::FileReadStream is(pFile, buffer, sizeof(buffer));
-		rapidjson::Document document;
 		document.ParseStream<0, rapidjson::UTF8<>, rapidjson::FileReadStream>(is);
+		fclose(pFile);
 		return document;
 	}
 
@@ -0,0 +1,406 @@
+
+// Include
+#include "logger.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#	include <windows.h>
+#endif
+
+// logger
+namespace {
+	using Clock = std::chrono::system_clock;
+
+	struct Record {
+		Clock::time_point time;
+		logger::level lvl = logger::level::info;
+		std::string text;
+	};
+
+	// Single producer (the owning thread), single consumer (whoever holds the backend mutex).
+	class Ring {
+		public:
+			static constexpr size_t Capacity = 1024;
+
+			bool push(Record&& record) {
+				const size_t head = mHead.load(std::memory_order_relaxed);
+				if (head - mTail.load(std::memory_order_acquire) == Capacity) {
+					mDropped.fetch_add(1, std::memory_order_relaxed);
+					return false;
+				}
+
+				mRecords[head & (Capacity - 1)] = std::move(record);
+				mHead.store(head + 1, std::memory_order_release);
+				return true;
+			}
+
+			template<typename Function>
+			void drain(Function&& function) {
+				size_t tail = mTail.load(std::memory_order_relaxed);
+				const size_t head = mHead.load(std::memory_order_acquire);
+				for (; tail != head; ++tail) {
+					function(std::move(mRecords[tail & (Capacity - 1)]));
+				}
+				mTail.store(tail, std::memory_order_release);
+			}
+
+			uint64_t take_dropped() {
+				return mDropped.exchange(0, std::memory_order_relaxed);
+			}
+
+			bool empty() const {
+				return mHead.load(std::memory_order_acquire) == mTail.load(std::memory_order_acquire);
+			}
+
+			// Set by the owning thread when it exits, nothing is pushed after it.
+			void close() { mClosed.store(true, std::memory_order_release); }
+			bool closed() const { return mClosed.load(std::memory_order_acquire); }
+
+		private:
+			static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+			std::array<Record, Capacity> mRecords;
+			alignas(64) std::atomic<size_t> mHead = 0;
+			alignas(64) std::atomic<size_t> mTail = 0;
+			std::atomic<uint64_t> mDropped = 0;
+			std::atomic<bool> mClosed = false;
+	};
+
+	// Closes the ring of a thread when the thread exits, the backend drops it once it has drained it.
+	struct RingOwner {
+		~RingOwner() {
+			if (ring) {
+				ring->close();
+			}
+		}
+
+		std::shared_ptr<Ring> ring;
+	};
+
+	class Backend {
+		public:
+			void start(const logger::options& opts) {
+				std::lock_guard<std::mutex> lock(mMutex);
+				if (mRunning) {
+					return;
+				}
+
+				mOptions = opts;
+				open_file();
+
+				mRunning = true;
+				mThread = std::thread(&Backend::run, this);
+			}
+
+			void stop() {
+				{
+					std::lock_guard<std::mutex> lock(mMutex);
+					if (!mRunning) {
+						return;
+					}
+					mRunning = false;
+				}
+
+				// Pushes that saw mRunning before it changed finish first, every later one writes directly.
+				while (mPushing.load() != 0) {
+					std::this_thread::yield();
+				}
+
+				mCondition.notify_one();
+				mThread.join();
+
+				// Anything pushed while the writer was finishing, nothing else touches the rings now.
+				std::lock_guard<std::mutex> lock(mMutex);
+
+				std::vector<Record> batch;
+				collect(batch);
+				output(batch);
+				mFile.close();
+			}
+
+			void push(Record&& record) {
+				// Errors are written before the call returns, they are often the last thing logged before a crash.
+				if (record.lvl < logger::level::error) {
+					mPushing.fetch_add(1);
+					if (mRunning) {
+						const auto lvl = record.lvl;
+						get_ring().push(std::move(record));
+						mPushing.fetch_sub(1);
+
+						if (lvl >= logger::level::warn) {
+							mCondition.notify_one();
+						}
+						return;
+					}
+					mPushing.fetch_sub(1);
+				}
+
+				write_now(std::move(record));
+			}
+
+		private:
+			Ring& get_ring() {
+				thread_local RingOwner owner;
+				if (!owner.ring) {
+					owner.ring = std::make_shared<Ring>();
+
+					std::lock_guard<std::mutex> lock(mRingsMutex);
+					mRings.push_back(owner.ring);
+				}
+				return *owner.ring;
+			}
+
+			// Writes everything still in the rings and then record, so it does not overtake earlier messages.
+			void write_now(Record&& record) {
+				std::lock_guard<std::mutex> lock(mMutex);
+
+				std::vector<Record> batch;
+				collect(batch);
+				batch.push_back(std::move(record));
+				output(batch);
+			}
+
+			void run() {
+				std::vector<Record> batch;
+				while (true) {
+					std::unique_lock<std::mutex> lock(mMutex);
+					mCondition.wait_for(lock, std::chrono::milliseconds(10));
+
+					collect(batch);
+					if (!batch.empty()) {
+						output(batch);
+						batch.clear();
+					}
+
+					if (!mRunning) {
+						break;
+					}
+				}
+			}
+
+			// Called with mMutex held, which makes whoever holds it the single consumer of every ring.
+			void collect(std::vector<Record>& batch) {
+				std::vector<std::shared_ptr<Ring>> rings;
+				{
+					std::lock_guard<std::mutex> lock(mRingsMutex);
+					rings = mRings;
+				}
+
+				uint64_t dropped = 0;
+				bool anyClosed = false;
+				for (const auto& ring : rings) {
+					// Checked before draining, a closed ring is empty once this drain is done.
+					const bool closed = ring->closed();
+					ring->drain([&batch](Record&& record) { batch.push_back(std::move(record)); });
+					dropped += ring->take_dropped();
+					anyClosed = anyClosed || closed;
+				}
+
+				// Threads come and go (game servers started once the pool ran out), their rings must not pile up.
+				if (anyClosed) {
+					std::lock_guard<std::mutex> lock(mRingsMutex);
+					std::erase_if(mRings, [](const auto& ring) { return ring->closed() && ring->empty(); });
+				}
+
+				if (dropped > 0) {
+					Record record;
+					record.time = Clock::now();
+					record.lvl = logger::level::warn;
+					record.text = "logger: dropped " + std::to_string(dropped) + " messages, ring buffer full";
+					batch.push_back(std::move(record));
+				}
+
+				// Each ring is in order, merge them by time.
+				std::stable_sort(batch.begin(), batch.end(), [](const auto& lhs, const auto& rhs) { return lhs.time < rhs.time; });
+			}
+
+			// Called with mMutex held.
+			void output(const std::vector<Record>& batch) {
+				std::string console;
+				auto consoleLevel = logger::level::none;
+
+				for (const auto& record : batch) {
+					std::string line = "[" + format_time(record.time) + "] " + record.text + "\n";
+					if (record.lvl != consoleLevel && !console.empty()) {
+						flush_console(console, consoleLevel);
+					}
+					consoleLevel = record.lvl;
+					console += line;
+
+					if (mFile.is_open()) {
+						if (mFileSize + line.size() > mOptions.max_file_size) {
+							rotate();
+						}
+						mFile << line;
+						mFileSize += line.size();
+					}
+				}
+
+				flush_console(console, consoleLevel);
+				if (mFile.is_open()) {
+					mFile.flush();
+				}
+			}
+
+			void flush_console(std::string& text, [[maybe_unused]] logger::level lvl) {
+				if (text.empty()) {
+					return;
+				}
+
+#ifdef _WIN32
+				HANDLE console = GetStdHandle(STD_OUTPUT_HANDLE);
+				switch (lvl) {
+					case logger::level::debug: SetConsoleTextAttribute(console, 8); break;
+					case logger::level::info:  SetConsoleTextAttribute(console, 11); break;
+					case logger::level::warn:  SetConsoleTextAttribute(console, 14); break;
+					case logger::level::error: SetConsoleTextAttribute(console, 12); break;
+					default: break;
+				}
+#endif
+
+				std::fwrite(text.data(), 1, text.size(), stdout);
+				std::fflush(stdout);
+#ifdef _WIN32
+				SetConsoleTextAttribute(console, 15);
+#endif
+				text.clear();
+			}
+
+			std::string format_time(Clock::time_point time) {
+				// Formatting once per second is enough, most lines share it with the one before.
+				const auto seconds = Clock::to_time_t(time);
+				if (seconds != mCachedSecond) {
+					std::tm tstruct {};
+#ifdef _WIN32
+					localtime_s(&tstruct, &seconds);
+#else
+					localtime_r(&seconds, &tstruct);
+#endif
+					char buf[32];
+					std::strftime(buf, sizeof(buf), "%Y-%m-%d %X", &tstruct);
+
+					mCachedSecond = seconds;
+					mCachedTime = buf;
+				}
+				return mCachedTime;
+			}
+
+			void open_file() {
+				if (mOptions.path.empty()) {
+					return;
+				}
+
+				std::error_code error;
+				const auto path = std::filesystem::path(mOptions.path);
+				if (path.has_parent_path()) {
+					std::filesystem::create_directories(path.parent_path(), error);
+				}
+
+				mFile.open(path, std::ios::binary | std::ios::app);
+				mFileSize = std::filesystem::exists(path, error) ? std::filesystem::file_size(path, error) : 0;
+			}
+
+			// server.log becomes server.log.1, server.log.1 becomes server.log.2 and so on.
+			void rotate() {
+				mFile.close();
+
+				std::error_code error;
+				if (mOptions.max_files > 1) {
+					for (uint32_t i = mOptions.max_files - 1; i > 0; --i) {
+						const auto from = (i == 1) ? mOptions.path : mOptions.path + "." + std::to_string(i - 1);
+						const auto to = mOptions.path + "." + std::to_string(i);
+						if (std::filesystem::exists(from, error)) {
+							std::filesystem::rename(from, to, error);
+						}
+					}
+				} else {
+					std::filesystem::remove(mOptions.path, error);
+				}
+
+				mFile.open(mOptions.path, std::ios::binary | std::ios::trunc);
+				mFileSize = 0;
+			}
+
+		private:
+			logger::options mOptions;
+
+			std::vector<std::shared_ptr<Ring>> mRings;
+			std::mutex mRingsMutex;
+
+			std::ofstream mFile;
+			uint64_t mFileSize = 0;
+
+			std::time_t mCachedSecond = 0;
+			std::string mCachedTime;
+
+			std::mutex mMutex;
+			std::condition_variable mCondition;
+			std::thread mThread;
+			std::atomic<bool> mRunning = false;
+			std::atomic<uint32_t> mPushing = 0;
+	};
+
+	Backend& get_backend() {
+		static Backend backend;
+		return backend;
+	}
+}
+
+std::atomic<logger::level> logger::sLevel = logger::level::info;
+
+void logger::start(const options& opts) {
+	set_level(opts.minimum);
+	get_backend().start(opts);
+}
+
+void logger::stop() {
+	get_backend().stop();
+}
+
+logger::level logger::parse_level(std::string_view name) {
+	if (name == "debug") return level::debug;
+	if (name == "info")  return level::info;
+	if (name == "warn")  return level::warn;
+	if (name == "error") return level::error;
+	if (name == "none")  return level::none;
+	return level::info;
+}
+
+void logger::write(level lvl, std::string_view message, std::initializer_list<field> fields) {
+	Record record;
+	record.time = Clock::now();
+	record.lvl = lvl;
+	record.text = message;
+
+	for (const auto& f : fields) {
+		record.text += ' ';
+		record.text += f.key;
+		record.text += '=';
+		if (f.value.empty() || f.value.find_first_of(" \t\"=") != std::string::npos) {
+			record.text += '"';
+			for (char c : f.value) {
+				if (c == '"' || c == '\\') {
+					record.text += '\\';
+				}
+				record.text += c;
+			}
+			record.text += '"';
+		} else {
+			record.text += f.value;
+		}
+	}
+
+	get_backend().push(std::move(record));
+}
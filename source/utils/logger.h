@@ -1,63 +1,85 @@
 #ifndef _UTILS_LOGGER_HEADER
 #define _UTILS_LOGGER_HEADER
 
+#include <atomic>
+#include <cstdint>
+#include <initializer_list>
 #include <string>
-#include <iostream>
-#include <chrono>
-#include <ctime>  
-#include <windows.h>
-#include <stdio.h>
-#include <time.h>
+#include <string_view>
+#include <type_traits>
 
+// windows.h, pulled in by asio on Windows, turns rapidjson's GetObject into GetObjectA.
 #ifdef GetObject
 #	undef GetObject
 #endif
 
+// Levels below this are compiled out of the LOG_* macros, 0 = debug, 1 = info, 2 = warn, 3 = error.
+#ifndef LOGGER_COMPILE_LEVEL
+#	define LOGGER_COMPILE_LEVEL 0
+#endif
 
+// Messages go into a lock-free ring buffer of the calling thread and are written to the console and the log file
+// by a background thread. Errors, and anything logged before start or after stop, are written directly.
 class logger {
-	private:
-		static const int priority = 2;
+	public:
+		enum class level : uint8_t {
+			debug = 0,
+			info,
+			warn,
+			error,
+			none
+		};
 
-		static void setConsoleTextColor(int k) {
-			HANDLE hConsole = GetStdHandle(STD_OUTPUT_HANDLE);
-			SetConsoleTextAttribute(hConsole, k);
-		}
-		static std::string time() {
-			std::time_t now = std::time(0);
-			struct tm  tstruct;
-			char buf[80];
-			tstruct = *localtime(&now);
-			strftime(buf, sizeof(buf), "%Y-%m-%d %X", &tstruct);
-			return buf;
-		}
+		// A structured key=value pair appended to the message.
+		struct field {
+			field(std::string_view key, std::string_view value) : key(key), value(value) {}
+			field(std::string_view key, const std::string& value) : key(key), value(value) {}
+			field(std::string_view key, const char* value) : key(key), value(value) {}
 
-	public:
-		static void info(const std::string& msg) {
-			if (priority >= 2) {
-				setConsoleTextColor(11);
-				log(msg);
-				setConsoleTextColor(15);
-			}
-		}
-		static void warn(const std::string& msg) {
-			if (priority >= 1) {
-				setConsoleTextColor(14);
-				log(msg);
-				setConsoleTextColor(15);
-			}
-		}
-		static void error(const std::string& msg) {
-			if (priority >= 0) {
-				setConsoleTextColor(12);
-				log(msg);
-				setConsoleTextColor(15);
-			}
-		}
-		static void log(const std::string& msg) {
-			if (priority >= -1) {
-				std::cout << "[" + time() + "] " + msg << std::endl;
-			}
+			template<typename T, typename = std::enable_if_t<std::is_arithmetic_v<T>>>
+			field(std::string_view key, T value) : key(key), value(std::is_same_v<T, bool> ? (value ? "true" : "false") : std::to_string(value)) {}
+
+			std::string_view key;
+			std::string value;
+		};
+
+		struct options {
+			level minimum = level::info;
+
+			// Empty writes to the console only.
+			std::string path;
+			uint64_t max_file_size = 10 * 1024 * 1024;
+			uint32_t max_files = 5;
+		};
+
+		static constexpr level compile_level = static_cast<level>(LOGGER_COMPILE_LEVEL);
+
+		static bool enabled(level lvl) {
+			return lvl >= compile_level && lvl >= sLevel.load(std::memory_order_relaxed);
 		}
+
+		static void start(const options& opts);
+		static void stop();
+
+		static void set_level(level lvl) { sLevel.store(lvl, std::memory_order_relaxed); }
+		static level parse_level(std::string_view name);
+
+		static void write(level lvl, std::string_view message, std::initializer_list<field> fields = {});
+
+		static void debug(std::string_view msg, std::initializer_list<field> fields = {}) { if (enabled(level::debug)) write(level::debug, msg, fields); }
+		static void info(std::string_view msg, std::initializer_list<field> fields = {}) { if (enabled(level::info)) write(level::info, msg, fields); }
+		static void warn(std::string_view msg, std::initializer_list<field> fields = {}) { if (enabled(level::warn)) write(level::warn, msg, fields); }
+		static void error(std::string_view msg, std::initializer_list<field> fields = {}) { if (enabled(level::error)) write(level::error, msg, fields); }
+		static void log(std::string_view msg) { info(msg); }
+
+	private:
+		static std::atomic<level> sLevel;
 };
 
-#endif
\ No newline at end of file
+// Unlike the functions these skip building the message and fields when the level is filtered out.
+#define LOG_DEBUG(...) do { if (logger::enabled(logger::level::debug)) { logger::write(logger::level::debug, __VA_ARGS__); } } while (0)
+#define LOG_INFO(...)  do { if (logger::enabled(logger::level::info))  { logger::write(logger::level::info,  __VA_ARGS__); } } while (0)
+#define LOG_WARN(...)  do { if (logger::enabled(logger::level::warn))  { logger::write(logger::level::warn,  __VA_ARGS__); } } while (0)
+#define LOG_ERROR(...) do { if (logger::enabled(logger::level::error)) { logger::write(logger::level::error, __VA_ARGS__); } } while (0)
+
+#endif
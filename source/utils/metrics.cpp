@@ -0,0 +1,218 @@
+
+// Include
+#include "metrics.h"
+#include <bit>
+#include <cstdio>
+
+// metrics
+namespace metrics {
+	namespace detail {
+		size_t cell_index() {
+			static std::atomic<size_t> nextIndex = 0;
+			thread_local const size_t index = nextIndex.fetch_add(1, std::memory_order_relaxed) % Cells;
+			return index;
+		}
+	}
+
+	// counter
+	uint64_t counter::value() const {
+		uint64_t total = 0;
+		for (const auto& cell : mCells) {
+			total += cell.value.load(std::memory_order_relaxed);
+		}
+		return total;
+	}
+
+	// histogram
+	uint32_t histogram::bucket_index(uint64_t nanoseconds) {
+		if (nanoseconds < (uint64_t(1) << MinExponent)) {
+			return 0;
+		}
+
+		const uint32_t exponent = static_cast<uint32_t>(std::bit_width(nanoseconds)) - 1;
+		if (exponent > MaxExponent) {
+			return Buckets - 1;
+		}
+
+		const uint32_t subBucket = static_cast<uint32_t>(nanoseconds >> (exponent - SubBucketBits)) & (SubBuckets - 1);
+		return 1 + (exponent - MinExponent) * SubBuckets + subBucket;
+	}
+
+	uint64_t histogram::bucket_upper_bound(uint32_t index) {
+		if (index == 0) {
+			return uint64_t(1) << MinExponent;
+		}
+
+		const uint32_t exponent = MinExponent + (index - 1) / SubBuckets;
+		const uint32_t subBucket = (index - 1) % SubBuckets;
+		return (uint64_t(SubBuckets + subBucket + 1)) << (exponent - SubBucketBits);
+	}
+
+	void histogram::observe(uint64_t nanoseconds) {
+		auto& cell = mCells[detail::cell_index()];
+		cell.buckets[bucket_index(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+		cell.count.fetch_add(1, std::memory_order_relaxed);
+		cell.sum.fetch_add(nanoseconds, std::memory_order_relaxed);
+	}
+
+	histogram::snapshot histogram::read() const {
+		snapshot result;
+		for (const auto& cell : mCells) {
+			for (uint32_t i = 0; i < Buckets; ++i) {
+				result.buckets[i] += cell.buckets[i].load(std::memory_order_relaxed);
+			}
+			result.count += cell.count.load(std::memory_order_relaxed);
+			result.sum += cell.sum.load(std::memory_order_relaxed);
+		}
+		return result;
+	}
+
+	uint64_t histogram::snapshot::quantile(double q) const {
+		uint64_t total = 0;
+		for (auto bucket : buckets) {
+			total += bucket;
+		}
+
+		if (total == 0) {
+			return 0;
+		}
+
+		const auto target = static_cast<uint64_t>(q * static_cast<double>(total - 1)) + 1;
+
+		uint64_t seen = 0;
+		for (uint32_t i = 0; i < Buckets; ++i) {
+			seen += buckets[i];
+			if (seen >= target) {
+				return bucket_upper_bound(i);
+			}
+		}
+		return bucket_upper_bound(Buckets - 1);
+	}
+
+	// registry
+	std::map<std::string, registry::family, std::less<>> registry::sFamilies;
+	std::mutex registry::sMutex;
+
+	registry::family& registry::get_family(std::string_view name, std::string_view help, type kind) {
+		auto it = sFamilies.find(name);
+		if (it == sFamilies.end()) {
+			it = sFamilies.emplace(std::string(name), family {}).first;
+			it->second.help = help;
+			it->second.kind = kind;
+		}
+		return it->second;
+	}
+
+	std::string registry::format_labels(std::initializer_list<label> labels) {
+		if (labels.size() == 0) {
+			return {};
+		}
+
+		std::string result = "{";
+		for (const auto& [key, value] : labels) {
+			if (result.size() > 1) {
+				result += ',';
+			}
+
+			result += key;
+			result += "=\"";
+			for (char c : value) {
+				switch (c) {
+					case '\\': result += "\\\\"; break;
+					case '"':  result += "\\\""; break;
+					case '\n': result += "\\n"; break;
+					default:   result += c; break;
+				}
+			}
+			result += '"';
+		}
+		result += '}';
+		return result;
+	}
+
+	counter& registry::get_counter(std::string_view name, std::string_view help, std::initializer_list<label> labels) {
+		auto key = format_labels(labels);
+
+		std::lock_guard<std::mutex> lock(sMutex);
+		auto& metric = get_family(name, help, type::counter).counters[std::move(key)];
+		if (!metric) {
+			metric = std::make_unique<counter>();
+		}
+		return *metric;
+	}
+
+	gauge& registry::get_gauge(std::string_view name, std::string_view help, std::initializer_list<label> labels) {
+		auto key = format_labels(labels);
+
+		std::lock_guard<std::mutex> lock(sMutex);
+		auto& metric = get_family(name, help, type::gauge).gauges[std::move(key)];
+		if (!metric) {
+			metric = std::make_unique<gauge>();
+		}
+		return *metric;
+	}
+
+	histogram& registry::get_histogram(std::string_view name, std::string_view help, std::initializer_list<label> labels) {
+		auto key = format_labels(labels);
+
+		std::lock_guard<std::mutex> lock(sMutex);
+		auto& metric = get_family(name, help, type::summary).histograms[std::move(key)];
+		if (!metric) {
+			metric = std::make_unique<histogram>();
+		}
+		return *metric;
+	}
+
+	std::string registry::render() {
+		constexpr std::array<double, 4> Quantiles { 0.5, 0.9, 0.99, 0.999 };
+
+		const auto seconds = [](uint64_t nanoseconds) {
+			char buf[32];
+			std::snprintf(buf, sizeof(buf), "%.9g", static_cast<double>(nanoseconds) / 1e9);
+			return std::string(buf);
+		};
+
+		// Adds a label to an already formatted label set.
+		const auto with_label = [](const std::string& labels, const std::string& extra) {
+			return labels.empty() ? "{" + extra + "}" : labels.substr(0, labels.size() - 1) + "," + extra + "}";
+		};
+
+		std::string result;
+
+		std::lock_guard<std::mutex> lock(sMutex);
+		for (const auto& [name, metricFamily] : sFamilies) {
+			result += "# HELP " + name + " " + metricFamily.help + "\n";
+			switch (metricFamily.kind) {
+				case type::counter:
+					result += "# TYPE " + name + " counter\n";
+					for (const auto& [labels, metric] : metricFamily.counters) {
+						result += name + labels + " " + std::to_string(metric->value()) + "\n";
+					}
+					break;
+
+				case type::gauge:
+					result += "# TYPE " + name + " gauge\n";
+					for (const auto& [labels, metric] : metricFamily.gauges) {
+						result += name + labels + " " + std::to_string(metric->value()) + "\n";
+					}
+					break;
+
+				case type::summary:
+					result += "# TYPE " + name + " summary\n";
+					for (const auto& [labels, metric] : metricFamily.histograms) {
+						const auto data = metric->read();
+						for (double q : Quantiles) {
+							char quantile[16];
+							std::snprintf(quantile, sizeof(quantile), "%g", q);
+							result += name + with_label(labels, "quantile=\"" + std::string(quantile) + "\"") + " " + seconds(data.quantile(q)) + "\n";
+						}
+						result += name + "_sum" + labels + " " + seconds(data.sum) + "\n";
+						result += name + "_count" + labels + " " + std::to_string(data.count) + "\n";
+					}
+					break;
+			}
+		}
+
+		return result;
+	}
+}
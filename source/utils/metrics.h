@@ -0,0 +1,146 @@
+
+#ifndef _UTILS_METRICS_HEADER
+#define _UTILS_METRICS_HEADER
+
+// Include
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <initializer_list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+
+// metrics
+namespace metrics {
+	using label = std::pair<std::string_view, std::string>;
+
+	namespace detail {
+		// Cells are spread over this many cache lines, each thread always updates the same one.
+		constexpr size_t Cells = 8;
+
+		size_t cell_index();
+	}
+
+	// counter
+	class counter {
+		public:
+			void add(uint64_t value = 1) {
+				mCells[detail::cell_index()].value.fetch_add(value, std::memory_order_relaxed);
+			}
+
+			uint64_t value() const;
+
+		private:
+			struct alignas(64) Cell {
+				std::atomic<uint64_t> value = 0;
+			};
+
+			std::array<Cell, detail::Cells> mCells;
+	};
+
+	// gauge
+	class gauge {
+		public:
+			void set(int64_t value) { mValue.store(value, std::memory_order_relaxed); }
+			void add(int64_t value = 1) { mValue.fetch_add(value, std::memory_order_relaxed); }
+			void sub(int64_t value = 1) { mValue.fetch_sub(value, std::memory_order_relaxed); }
+
+			int64_t value() const { return mValue.load(std::memory_order_relaxed); }
+
+		private:
+			std::atomic<int64_t> mValue = 0;
+	};
+
+	// histogram, log-linear buckets in nanoseconds like HdrHistogram: every power of two from 1us to ~68s is split into
+	// eight sub buckets, so any quantile is within 12.5% of the real value.
+	class histogram {
+		public:
+			static constexpr uint32_t SubBucketBits = 3;
+			static constexpr uint32_t SubBuckets = 1 << SubBucketBits;
+			static constexpr uint32_t MinExponent = 10;
+			static constexpr uint32_t MaxExponent = 36;
+			static constexpr uint32_t Buckets = (MaxExponent - MinExponent + 1) * SubBuckets + 1;
+
+			void observe(uint64_t nanoseconds);
+			void observe(std::chrono::steady_clock::duration duration) {
+				observe(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count()));
+			}
+
+			struct snapshot {
+				std::array<uint64_t, Buckets> buckets {};
+				uint64_t count = 0;
+				uint64_t sum = 0;
+
+				// In nanoseconds, the upper bound of the bucket holding the quantile.
+				uint64_t quantile(double q) const;
+			};
+
+			snapshot read() const;
+
+			static uint32_t bucket_index(uint64_t nanoseconds);
+			static uint64_t bucket_upper_bound(uint32_t index);
+
+		private:
+			struct alignas(64) Cell {
+				std::array<std::atomic<uint64_t>, Buckets> buckets {};
+				std::atomic<uint64_t> count = 0;
+				std::atomic<uint64_t> sum = 0;
+			};
+
+			std::array<Cell, detail::Cells> mCells;
+	};
+
+	// Records the time from construction to destruction.
+	class scoped_timer {
+		public:
+			explicit scoped_timer(histogram& target) : mHistogram(target), mStart(std::chrono::steady_clock::now()) {}
+			~scoped_timer() { mHistogram.observe(std::chrono::steady_clock::now() - mStart); }
+
+			scoped_timer(const scoped_timer&) = delete;
+			scoped_timer& operator=(const scoped_timer&) = delete;
+
+		private:
+			histogram& mHistogram;
+			std::chrono::steady_clock::time_point mStart;
+	};
+
+	// registry, metrics live as long as the process so callers keep the returned references around.
+	class registry {
+		public:
+			static counter& get_counter(std::string_view name, std::string_view help, std::initializer_list<label> labels = {});
+			static gauge& get_gauge(std::string_view name, std::string_view help, std::initializer_list<label> labels = {});
+			static histogram& get_histogram(std::string_view name, std::string_view help, std::initializer_list<label> labels = {});
+
+			// Prometheus text format, histograms are written as summaries with quantiles.
+			static std::string render();
+
+		private:
+			enum class type : uint8_t {
+				counter,
+				gauge,
+				summary
+			};
+
+			struct family {
+				std::string help;
+				type kind;
+				std::map<std::string, std::unique_ptr<counter>> counters;
+				std::map<std::string, std::unique_ptr<gauge>> gauges;
+				std::map<std::string, std::unique_ptr<histogram>> histograms;
+			};
+
+			static family& get_family(std::string_view name, std::string_view help, type kind);
+			static std::string format_labels(std::initializer_list<label> labels);
+
+		private:
+			static std::map<std::string, family, std::less<>> sFamilies;
+			static std::mutex sMutex;
+	};
+}
+
+#endif
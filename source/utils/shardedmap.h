@@ -0,0 +1,139 @@
+
+#ifndef _UTILS_SHARDEDMAP_HEADER
+#define _UTILS_SHARDEDMAP_HEADER
+
+// Include
+#include <array>
+#include <functional>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+
+// utils
+namespace utils {
+	// Hash map split into independently locked shards, so threads working on different keys rarely contend.
+	// Values are returned by copy, use it with cheap to copy values like shared_ptr.
+	template<typename Key, typename Value, size_t Shards = 16, typename Hash = std::hash<Key>>
+	class sharded_map {
+		static_assert((Shards & (Shards - 1)) == 0, "Shards must be a power of two");
+
+		public:
+			// Returns a default constructed Value when key is missing.
+			Value find(const Key& key) const {
+				const auto& shard = get_shard(key);
+				std::shared_lock lock(shard.mutex);
+
+				auto it = shard.map.find(key);
+				return (it != shard.map.end()) ? it->second : Value {};
+			}
+
+			bool contains(const Key& key) const {
+				const auto& shard = get_shard(key);
+				std::shared_lock lock(shard.mutex);
+				return shard.map.find(key) != shard.map.end();
+			}
+
+			// Returns the value now stored for key, which is not value if key was already there.
+			Value emplace(const Key& key, Value value) {
+				auto& shard = get_shard(key);
+				std::unique_lock lock(shard.mutex);
+				return shard.map.try_emplace(key, std::move(value)).first->second;
+			}
+
+			void insert_or_assign(const Key& key, Value value) {
+				auto& shard = get_shard(key);
+				std::unique_lock lock(shard.mutex);
+				shard.map.insert_or_assign(key, std::move(value));
+			}
+
+			bool erase(const Key& key) {
+				auto& shard = get_shard(key);
+				std::unique_lock lock(shard.mutex);
+				return shard.map.erase(key) > 0;
+			}
+
+			// Erases key only while predicate(value) holds, checked under the same lock.
+			template<typename Predicate>
+			bool erase_if(const Key& key, Predicate&& predicate) {
+				auto& shard = get_shard(key);
+				std::unique_lock lock(shard.mutex);
+
+				auto it = shard.map.find(key);
+				if (it == shard.map.end() || !predicate(it->second)) {
+					return false;
+				}
+
+				shard.map.erase(it);
+				return true;
+			}
+
+			// Calls function(Value&) for key under the shard lock, inserting a default value first if needed.
+			// The entry is erased again if function returns false.
+			template<typename Function>
+			void update(const Key& key, Function&& function) {
+				auto& shard = get_shard(key);
+				std::unique_lock lock(shard.mutex);
+
+				auto it = shard.map.try_emplace(key).first;
+				if (!function(it->second)) {
+					shard.map.erase(it);
+				}
+			}
+
+			// Calls function(const Key&, const Value&) for every entry, one shard locked at a time.
+			template<typename Function>
+			void for_each(Function&& function) const {
+				for (const auto& shard : mShards) {
+					std::shared_lock lock(shard.mutex);
+					for (const auto& [key, value] : shard.map) {
+						function(key, value);
+					}
+				}
+			}
+
+			size_t size() const {
+				size_t count = 0;
+				for (const auto& shard : mShards) {
+					std::shared_lock lock(shard.mutex);
+					count += shard.map.size();
+				}
+				return count;
+			}
+
+			void clear() {
+				for (auto& shard : mShards) {
+					std::unique_lock lock(shard.mutex);
+					shard.map.clear();
+				}
+			}
+
+		private:
+			struct Shard {
+				mutable std::shared_mutex mutex;
+				std::unordered_map<Key, Value, Hash> map;
+			};
+
+			Shard& get_shard(const Key& key) {
+				return mShards[shard_index(key)];
+			}
+
+			const Shard& get_shard(const Key& key) const {
+				return mShards[shard_index(key)];
+			}
+
+			static size_t shard_index(const Key& key) {
+				// Mix the hash, std::hash of an integer is the integer itself on most standard libraries.
+				size_t hash = Hash {}(key);
+				hash ^= hash >> 17;
+				hash *= 0x9E3779B9;
+				hash ^= hash >> 13;
+				return hash & (Shards - 1);
+			}
+
+		private:
+			std::array<Shard, Shards> mShards;
+	};
+}
+
+#endif
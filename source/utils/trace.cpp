@@ -0,0 +1,216 @@
+
+// Include
+#include "trace.h"
+#include <atomic>
+#include <fstream>
+#include <mutex>
+
+// trace
+namespace trace {
+	namespace {
+		// Buffered events are written out once they pass this size and when tracing stops.
+		constexpr size_t FlushSize = 64 * 1024;
+
+		std::atomic<bool> sEnabled = false;
+		std::atomic<uint64_t> sNextId = 1;
+
+		std::mutex sMutex;
+		std::ofstream sFile;
+		std::string sBuffer;
+		bool sFirstEvent = true;
+
+		const auto sEpoch = std::chrono::steady_clock::now();
+
+		uint64_t to_microseconds(std::chrono::steady_clock::time_point time) {
+			return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(time - sEpoch).count());
+		}
+
+		void append_string(std::string& out, std::string_view value) {
+			out += '"';
+			for (char c : value) {
+				switch (c) {
+					case '"':  out += "\\\""; break;
+					case '\\': out += "\\\\"; break;
+					case '\n': out += "\\n"; break;
+					case '\r': out += "\\r"; break;
+					case '\t': out += "\\t"; break;
+					default:
+						if (static_cast<unsigned char>(c) < 0x20) {
+							out += ' ';
+						} else {
+							out += c;
+						}
+						break;
+				}
+			}
+			out += '"';
+		}
+
+		template<typename Args>
+		void append_args(std::string& out, const Args& args) {
+			out += ",\"args\":{";
+
+			bool first = true;
+			for (const auto& [key, value] : args) {
+				if (!first) {
+					out += ',';
+				}
+				first = false;
+
+				append_string(out, key);
+				out += ':';
+				append_string(out, value);
+			}
+			out += '}';
+		}
+
+		std::string begin_event(std::string_view name, char phase, uint64_t id, track where, uint64_t timestamp) {
+			std::string event = "{\"name\":";
+			append_string(event, name);
+			event += ",\"ph\":\"";
+			event += phase;
+			event += "\",\"pid\":" + std::to_string(id);
+			event += ",\"tid\":" + std::to_string(static_cast<uint32_t>(where));
+			event += ",\"ts\":" + std::to_string(timestamp);
+			return event;
+		}
+
+		void write_event(std::string&& event) {
+			std::lock_guard<std::mutex> lock(sMutex);
+			if (!sFile.is_open()) {
+				return;
+			}
+
+			sBuffer += sFirstEvent ? "\n" : ",\n";
+			sBuffer += event;
+			sFirstEvent = false;
+
+			if (sBuffer.size() >= FlushSize) {
+				sFile << sBuffer;
+				sFile.flush();
+				sBuffer.clear();
+			}
+		}
+	}
+
+	void start(const std::string& path) {
+		if (path.empty()) {
+			return;
+		}
+
+		std::lock_guard<std::mutex> lock(sMutex);
+		sFile.open(path, std::ios::binary | std::ios::trunc);
+		if (!sFile.is_open()) {
+			return;
+		}
+
+		sFile << "[";
+		sFirstEvent = true;
+		sEnabled = true;
+	}
+
+	void stop() {
+		sEnabled = false;
+
+		std::lock_guard<std::mutex> lock(sMutex);
+		if (sFile.is_open()) {
+			sFile << sBuffer << "\n]\n";
+			sFile.close();
+			sBuffer.clear();
+		}
+	}
+
+	// arg
+	std::string arg::to_string() const {
+		return std::visit([](const auto& v) -> std::string {
+			if constexpr (std::is_same_v<std::decay_t<decltype(v)>, std::string_view>) {
+				return std::string(v);
+			} else {
+				return std::to_string(v);
+			}
+		}, value);
+	}
+
+	bool enabled() {
+		return sEnabled.load(std::memory_order_relaxed);
+	}
+
+	uint64_t new_id() {
+		return sNextId.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	void name(uint64_t id, std::string_view label) {
+		if (!enabled()) {
+			return;
+		}
+
+		std::string event = "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" + std::to_string(id);
+		append_args(event, std::initializer_list<std::pair<std::string_view, std::string_view>> { { "name", label } });
+		event += '}';
+		write_event(std::move(event));
+
+		constexpr std::pair<track, std::string_view> tracks[] {
+			{ track::redirector, "redirector" },
+			{ track::blaze, "blaze" },
+			{ track::http, "http" },
+			{ track::raknet, "raknet" }
+		};
+
+		for (const auto& [where, trackName] : tracks) {
+			event = "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" + std::to_string(id) + ",\"tid\":" + std::to_string(static_cast<uint32_t>(where));
+			append_args(event, std::initializer_list<std::pair<std::string_view, std::string_view>> { { "name", trackName } });
+			event += '}';
+			write_event(std::move(event));
+		}
+	}
+
+	void instant(uint64_t id, track where, std::string_view name, std::initializer_list<arg> args) {
+		if (!enabled()) {
+			return;
+		}
+
+		std::string event = begin_event(name, 'i', id, where, to_microseconds(std::chrono::steady_clock::now()));
+		event += ",\"s\":\"p\"";
+
+		std::vector<std::pair<std::string_view, std::string>> eventArgs;
+		for (const auto& a : args) {
+			eventArgs.emplace_back(a.key, a.to_string());
+		}
+		append_args(event, eventArgs);
+		event += '}';
+		write_event(std::move(event));
+	}
+
+	// span
+	span::span(uint64_t id, track where, std::string_view name, std::initializer_list<arg> args) : mId(id), mTrack(where), mEnabled(enabled()) {
+		if (!mEnabled) {
+			return;
+		}
+
+		mName = name;
+		for (const auto& a : args) {
+			mArgs.emplace_back(a.key, a.to_string());
+		}
+		mStart = std::chrono::steady_clock::now();
+	}
+
+	span::~span() {
+		if (!mEnabled) {
+			return;
+		}
+
+		const auto end = std::chrono::steady_clock::now();
+
+		std::string event = begin_event(mName, 'X', mId, mTrack, to_microseconds(mStart));
+		event += ",\"dur\":" + std::to_string(std::chrono::duration_cast<std::chrono::microseconds>(end - mStart).count());
+		append_args(event, mArgs);
+		event += '}';
+		write_event(std::move(event));
+	}
+
+	void span::add(std::string_view key, std::string value) {
+		if (mEnabled) {
+			mArgs.emplace_back(key, std::move(value));
+		}
+	}
+}
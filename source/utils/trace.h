@@ -0,0 +1,87 @@
+
+#ifndef _UTILS_TRACE_HEADER
+#define _UTILS_TRACE_HEADER
+
+// Include
+#include <chrono>
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+// trace, timed spans in the Chrome trace event format (open the file in chrome://tracing or Perfetto).
+// Every trace id shows up as its own process, every protocol as a thread inside it.
+namespace trace {
+	enum class track : uint32_t {
+		redirector = 1,
+		blaze,
+		http,
+		raknet
+	};
+
+	// Only refers to its value, numbers are formatted when the event is written and not at all while tracing is off.
+	struct arg {
+		arg(std::string_view key, std::string_view value) : key(key), value(value) {}
+		arg(std::string_view key, const std::string& value) : key(key), value(std::string_view(value)) {}
+		arg(std::string_view key, const char* value) : key(key), value(std::string_view(value)) {}
+
+		template<typename T, typename = std::enable_if_t<std::is_arithmetic_v<T>>>
+		arg(std::string_view key, T value) : key(key) {
+			if constexpr (std::is_floating_point_v<T>) {
+				this->value = static_cast<double>(value);
+			} else if constexpr (std::is_signed_v<T>) {
+				this->value = static_cast<int64_t>(value);
+			} else {
+				this->value = static_cast<uint64_t>(value);
+			}
+		}
+
+		std::string to_string() const;
+
+		std::string_view key;
+		std::variant<std::string_view, int64_t, uint64_t, double> value;
+	};
+
+	// Empty path keeps tracing off, spans then cost one branch. Callers that build strings for args or names
+	// should check enabled() first.
+	void start(const std::string& path);
+	void stop();
+
+	bool enabled();
+
+	// Never 0, 0 is used for work that belongs to no session yet.
+	uint64_t new_id();
+
+	// Shown as the process name of id.
+	void name(uint64_t id, std::string_view label);
+
+	void instant(uint64_t id, track where, std::string_view name, std::initializer_list<arg> args = {});
+
+	// span
+	class span {
+		public:
+			span(uint64_t id, track where, std::string_view name, std::initializer_list<arg> args = {});
+			~span();
+
+			span(const span&) = delete;
+			span& operator=(const span&) = delete;
+
+			// For spans that only learn which session they belong to halfway, like a login.
+			void set_id(uint64_t id) { mId = id; }
+			void add(std::string_view key, std::string value);
+
+		private:
+			std::vector<std::pair<std::string, std::string>> mArgs;
+			std::string mName;
+			std::chrono::steady_clock::time_point mStart;
+			uint64_t mId;
+			track mTrack;
+			bool mEnabled;
+	};
+}
+
+#endif
@@ -34,4 +34,28 @@ namespace utils {
 		document.save(writer, "\t", 1U, pugi::encoding_latin1);
 		return std::move(writer.result);
     }
-}
\ No newline at end of file
+
+	std::string xml::Splice(const std::string& head, const std::string& tail) {
+		auto headEnd = head.rfind("</");
+		auto tailStart = tail.find("?>");
+		tailStart = tail.find('<', tailStart == std::string::npos ? 0 : tailStart + 2);
+		if (tailStart != std::string::npos) {
+			tailStart = tail.find('>', tailStart);
+		}
+
+		if (headEnd == std::string::npos || tailStart == std::string::npos || tail[tailStart - 1] == '/') {
+			return head;
+		}
+
+		tailStart++;
+		if (tailStart < tail.size() && tail[tailStart] == '\n') {
+			tailStart++;
+		}
+
+		std::string result;
+		result.reserve(headEnd + tail.size() - tailStart);
+		result.append(head, 0, headEnd);
+		result.append(tail, tailStart);
+		return result;
+	}
+}
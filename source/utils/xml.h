@@ -7,6 +7,7 @@
 #include <vector>
 #include <string>
 #include <pugixml.hpp>
+#include "functions.h"
 
 // utils
 namespace utils {
@@ -25,6 +26,10 @@ namespace utils {
         }
 
         std::string ToString(pugi::xml_document& document);
+
+        // Appends the children of the root element in tail after the children of the root element in head,
+        // both serialized with ToString. Gives the same text as serializing the combined document.
+        std::string Splice(const std::string& head, const std::string& tail);
     }
 }
 
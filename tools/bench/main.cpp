@@ -0,0 +1,586 @@
+
+// Include
+#include "databuffer.h"
+#include "blaze/tdf.h"
+#include "game/api.h"
+#include "game/config.h"
+#include "game/user.h"
+#include "http/multipart.h"
+#include "http/router.h"
+#include "http/session.h"
+#include "http/uri.h"
+#include "repository/part.h"
+#include "repository/template.h"
+#include "utils/logger.h"
+#include "utils/xml.h"
+
+#include <boost/asio.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <iterator>
+#include <new>
+#include <string>
+#include <vector>
+
+/*
+	Micro benchmarks for the Blaze codecs, the HTTP parsing and routing and the account XML builders.
+
+	bench [--filter text] [--min-time-ms 250] [--payloads dir] [--json file]
+
+	Run it from the server directory, the route table and the XML builders use config.xml and the
+	part and creature data in storage. Benchmarks that need data which is not there are skipped.
+
+	--payloads adds every file in dir as a raw TDF body to the tdf_parse benchmarks, on top of the
+	built in login and game setup packets.
+
+	Results are printed as ns/op and allocs/op, --json also writes them to a file for diffing builds.
+
+	Built with bench.vcxproj on Windows and with the CMakeLists.txt next to this file on Linux.
+*/
+
+// Allocation counting
+namespace {
+	std::atomic<uint64_t> sAllocations = 0;
+	std::atomic<uint64_t> sAllocatedBytes = 0;
+
+	void* CountedAlloc(size_t size) {
+		sAllocations.fetch_add(1, std::memory_order_relaxed);
+		sAllocatedBytes.fetch_add(size, std::memory_order_relaxed);
+		if (void* ptr = std::malloc(size ? size : 1)) {
+			return ptr;
+		}
+		throw std::bad_alloc();
+	}
+}
+
+void* operator new(size_t size) { return CountedAlloc(size); }
+void* operator new[](size_t size) { return CountedAlloc(size); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept { try { return CountedAlloc(size); } catch (...) { return nullptr; } }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { try { return CountedAlloc(size); } catch (...) { return nullptr; } }
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { std::free(ptr); }
+
+namespace {
+	using Clock = std::chrono::steady_clock;
+
+	struct Result {
+		std::string name;
+		uint64_t iterations = 0;
+		double nanoseconds = 0;
+		double allocations = 0;
+		double bytes = 0;
+	};
+
+	// Keeps the optimizer from dropping work whose result is never read.
+	volatile uintptr_t sSink;
+
+	template<typename T>
+	void Keep(const T& value) {
+		sSink = reinterpret_cast<uintptr_t>(&value);
+	}
+
+	class Runner {
+		public:
+			std::string filter;
+			std::chrono::milliseconds minTime { 250 };
+			std::vector<Result> results;
+
+			// Runs fn in doubling batches until minTime has passed, one warm up call first.
+			void run(const std::string& name, const std::function<void()>& fn) {
+				if (!filter.empty() && name.find(filter) == std::string::npos) {
+					return;
+				}
+
+				fn();
+
+				Result result;
+				result.name = name;
+
+				uint64_t batch = 1;
+				Clock::duration elapsed {};
+				uint64_t allocations = 0;
+				uint64_t bytes = 0;
+				while (elapsed < minTime) {
+					const auto allocationsBefore = sAllocations.load(std::memory_order_relaxed);
+					const auto bytesBefore = sAllocatedBytes.load(std::memory_order_relaxed);
+					const auto start = Clock::now();
+					for (uint64_t i = 0; i < batch; ++i) {
+						fn();
+					}
+					elapsed += Clock::now() - start;
+					allocations += sAllocations.load(std::memory_order_relaxed) - allocationsBefore;
+					bytes += sAllocatedBytes.load(std::memory_order_relaxed) - bytesBefore;
+
+					result.iterations += batch;
+					batch *= 2;
+				}
+
+				const double iterations = static_cast<double>(result.iterations);
+				result.nanoseconds = std::chrono::duration<double, std::nano>(elapsed).count() / iterations;
+				result.allocations = allocations / iterations;
+				result.bytes = bytes / iterations;
+
+				std::printf("%-40s %14.1f ns/op %10.2f allocs/op %12.1f B/op %12llu ops\n",
+					name.c_str(), result.nanoseconds, result.allocations, result.bytes,
+					static_cast<unsigned long long>(result.iterations));
+
+				results.push_back(std::move(result));
+			}
+
+			void skip(const std::string& name, const std::string& reason) {
+				if (filter.empty() || name.find(filter) != std::string::npos) {
+					std::printf("%-40s skipped, %s\n", name.c_str(), reason.c_str());
+				}
+			}
+	};
+
+	bool WriteJson(const std::string& path, const std::vector<Result>& results) {
+		std::ofstream file(path, std::ios::binary);
+		if (!file.is_open()) {
+			return false;
+		}
+
+		char line[512];
+		file << "{\n\t\"benchmarks\": [\n";
+		for (size_t i = 0; i < results.size(); ++i) {
+			const auto& result = results[i];
+			std::snprintf(line, sizeof(line),
+				"\t\t{ \"name\": \"%s\", \"iterations\": %llu, \"ns_per_op\": %.3f, \"allocs_per_op\": %.3f, \"bytes_per_op\": %.1f }%s\n",
+				result.name.c_str(), static_cast<unsigned long long>(result.iterations),
+				result.nanoseconds, result.allocations, result.bytes, (i + 1 < results.size()) ? "," : "");
+			file << line;
+		}
+		file << "\t]\n}\n";
+		return true;
+	}
+
+	// Blaze
+	void BenchDataBuffer(Runner& runner) {
+		runner.run("databuffer_write_256b", [] {
+			DataBuffer buffer;
+			for (uint32_t i = 0; i < 16; ++i) {
+				buffer.write_u32_be(i);
+				buffer.write_u16_le(static_cast<uint16_t>(i));
+				buffer.write_u64_be(i * 0x0101010101ULL);
+				buffer.write<uint16_t>(static_cast<uint16_t>(i));
+			}
+			Keep(buffer);
+		});
+
+		DataBuffer source;
+		for (uint32_t i = 0; i < 16; ++i) {
+			source.write_u32_be(i);
+			source.write_u16_le(static_cast<uint16_t>(i));
+			source.write_u64_be(i * 0x0101010101ULL);
+			source.write<uint16_t>(static_cast<uint16_t>(i));
+		}
+
+		runner.run("databuffer_read_256b", [&source] {
+			source.set_position(0);
+
+			uint64_t sum = 0;
+			for (uint32_t i = 0; i < 16; ++i) {
+				sum += source.read_u32_be();
+				sum += source.read_u16_le();
+				sum += source.read_u64_be();
+				sum += source.read<uint16_t>();
+			}
+			Keep(sum);
+		});
+
+		// Values of increasing encoded length, one to nine bytes.
+		const std::vector<uint64_t> values {
+			0x12, 0x1234, 0x123456, 0x12345678, 0x123456789A, 0x123456789ABC, 0x123456789ABCDE, 0x123456789ABCDEF0
+		};
+
+		DataBuffer varints;
+		varints.reserve(256);
+		runner.run("varint_encode_x8", [&varints, &values] {
+			varints.set_position(0);
+			for (auto value : values) {
+				varints.encode_tdf_integer(value);
+			}
+			Keep(varints);
+		});
+
+		runner.run("varint_decode_x8", [&varints, &values] {
+			varints.set_position(0);
+
+			uint64_t sum = 0;
+			for (size_t i = 0; i < values.size(); ++i) {
+				sum += varints.decode_tdf_integer();
+			}
+			Keep(sum);
+		});
+	}
+
+	// Same layout as the SilentLogin and LoginPersona responses.
+	void BuildLoginPacket(Blaze::TDF::Packet& packet) {
+		packet.PutInteger(nullptr, "AGUP", 0);
+		packet.PutString(nullptr, "LDHT", "");
+		packet.PutInteger(nullptr, "NTOS", 0);
+		packet.PutString(nullptr, "PCTK", "PlayerTicket_1337");
+		packet.PutString(nullptr, "PRIV", "");
+		{
+			auto& sessStruct = packet.CreateStruct(nullptr, "SESS");
+			packet.PutInteger(&sessStruct, "BUID", 1);
+			packet.PutInteger(&sessStruct, "FRST", 0);
+			packet.PutString(&sessStruct, "KEY", "SessionKey_1337");
+			packet.PutInteger(&sessStruct, "LLOG", 0);
+			packet.PutString(&sessStruct, "MAIL", "bench@recap.local");
+			{
+				auto& pdtlStruct = packet.CreateStruct(nullptr, "PDTL");
+				packet.PutString(&pdtlStruct, "DSNM", "bench");
+				packet.PutInteger(&pdtlStruct, "LAST", 0);
+				packet.PutInteger(&pdtlStruct, "PID", 1);
+				packet.PutInteger(&pdtlStruct, "STAS", 0);
+				packet.PutInteger(&pdtlStruct, "XREF", 0);
+				packet.PutInteger(&pdtlStruct, "XTYP", 0);
+			}
+			packet.PutInteger(&sessStruct, "UID", 1);
+		}
+		packet.PutInteger(nullptr, "SPAM", 0);
+		packet.PutString(nullptr, "THST", "");
+		packet.PutString(nullptr, "TSUI", "");
+		packet.PutString(nullptr, "TURI", "");
+	}
+
+	// Same layout as the game part of NotifyGameSetup, with a realistic amount of attributes.
+	void BuildGamePacket(Blaze::TDF::Packet& packet) {
+		using Blaze::TDF::Type;
+
+		auto& gameStruct = packet.CreateStruct(nullptr, "GAME");
+		{
+			auto& admnList = packet.CreateList(&gameStruct, "ADMN", Type::Integer);
+			packet.PutInteger(&admnList, "", 1);
+		} {
+			auto& attrMap = packet.CreateMap(&gameStruct, "ATTR", Type::String, Type::String);
+			for (uint32_t i = 0; i < 16; ++i) {
+				packet.PutString(&attrMap, "attribute_" + std::to_string(i), "value_" + std::to_string(i * 7919));
+			}
+		} {
+			auto& capList = packet.CreateList(&gameStruct, "CAP", Type::Integer);
+			packet.PutInteger(&capList, "", 4);
+			packet.PutInteger(&capList, "", 0);
+		}
+		packet.PutInteger(&gameStruct, "GID", 1);
+		packet.PutString(&gameStruct, "GNAM", "Darkspore");
+		packet.PutInteger(&gameStruct, "GPVH", 1);
+		packet.PutInteger(&gameStruct, "GSET", 0x1F);
+		packet.PutInteger(&gameStruct, "GSID", 1);
+		packet.PutInteger(&gameStruct, "GSTA", 1);
+		packet.PutString(&gameStruct, "GTYP", "gameType0");
+		{
+			auto& hnetList = packet.CreateList(&gameStruct, "HNET", Type::Struct, true);
+			auto& valuStruct = packet.CreateStruct(&hnetList, "");
+			{
+				auto& exipStruct = packet.CreateStruct(&valuStruct, "EXIP");
+				packet.PutInteger(&exipStruct, "IP", 0x7F000001);
+				packet.PutInteger(&exipStruct, "PORT", 3659);
+			} {
+				auto& inipStruct = packet.CreateStruct(&valuStruct, "INIP");
+				packet.PutInteger(&inipStruct, "IP", 0x7F000001);
+				packet.PutInteger(&inipStruct, "PORT", 3659);
+			}
+		}
+		packet.PutInteger(&gameStruct, "MCAP", 4);
+		packet.PutString(&gameStruct, "VSTR", "5.3.0.127");
+	}
+
+	void BenchTdf(Runner& runner, const std::string& payloadPath) {
+		struct Payload {
+			std::string name;
+			DataBuffer buffer;
+		};
+
+		std::vector<Payload> payloads;
+
+		const auto addPacket = [&](const std::string& name, void (*build)(Blaze::TDF::Packet&)) {
+			Blaze::TDF::Packet packet;
+			build(packet);
+
+			runner.run("tdf_write_" + name, [&packet] {
+				DataBuffer buffer;
+				packet.Write(buffer);
+				Keep(buffer);
+			});
+
+			auto& payload = payloads.emplace_back();
+			payload.name = name;
+			packet.Write(payload.buffer);
+		};
+
+		addPacket("login", BuildLoginPacket);
+		addPacket("game_setup", BuildGamePacket);
+
+		if (!payloadPath.empty()) {
+			std::error_code error;
+			for (const auto& entry : std::filesystem::directory_iterator(payloadPath, error)) {
+				if (!entry.is_regular_file()) {
+					continue;
+				}
+
+				std::ifstream file(entry.path(), std::ios::binary);
+				std::vector<char> data { std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
+				if (data.empty()) {
+					continue;
+				}
+
+				auto& payload = payloads.emplace_back();
+				payload.name = entry.path().stem().string();
+				payload.buffer.write<char>(data.data(), data.size());
+			}
+
+			if (error) {
+				std::cerr << "Could not read payloads from " << payloadPath << std::endl;
+			}
+		}
+
+		for (auto& payload : payloads) {
+			const auto size = payload.buffer.size();
+			runner.run("tdf_parse_" + payload.name, [&payload, size] {
+				payload.buffer.set_position(0);
+
+				rapidjson::Document document;
+				document.SetObject();
+				while (payload.buffer.position() < size) {
+					Blaze::TDF::Parse(payload.buffer, document);
+				}
+				Keep(document);
+			});
+		}
+	}
+
+	// HTTP
+	constexpr auto AuthTarget =
+		"/game/api?version=1&token=cookie&method=api.account.auth&build=5.3.0.127&key=0123456789abcdef%3A%3A0"
+		"&include_creatures=true&include_decks=true&include_feed=true&include_server_tuning=true&include_settings=true"
+		"&new_player_progress=7";
+
+	void BenchHttp(Runner& runner) {
+		runner.run("uri_parse_account_auth", [] {
+			HTTP::URI uri;
+			uri.parse(AuthTarget);
+			Keep(uri);
+		});
+
+		std::string body;
+		for (const auto& [name, value] : {
+			std::pair { "method", "api.creature.updateCreature" }, { "id", "12" }, { "name", "Blitz" },
+			{ "stats", "STR,14,0;DEX,13,0;MIND,23,0;HLTH,100,70;MANA,125,23" }, { "large", "1" }, { "thumb", "1" }
+		}) {
+			body += "--EA_HTTP_REQUEST_SIMPLE_BOUNDARY\r\n";
+			body += "Content-Disposition: form-data; name=\"" + std::string(name) + "\"\r\n\r\n";
+			body += std::string(value) + "\r\n";
+		}
+		body += "--EA_HTTP_REQUEST_SIMPLE_BOUNDARY--\r\n";
+
+		runner.run("multipart_parse_6_fields", [&body] {
+			HTTP::Multipart multipart(body, "EA_HTTP_REQUEST_SIMPLE_BOUNDARY");
+			Keep(multipart);
+		});
+	}
+
+	void BenchRouter(Runner& runner) {
+		auto router = std::make_shared<HTTP::Router>();
+
+		Game::API api;
+		api.setup(router);
+
+		boost::asio::io_context io;
+		auto session = std::make_shared<HTTP::Session>(nullptr, boost::asio::ip::tcp::socket(io));
+
+		const auto route = [&](const std::string& name, const char* target) {
+			runner.run(name, [&session, &router, target] {
+				auto& request = session->get_request();
+				request.uri = HTTP::URI();
+				request.data.method(boost::beast::http::verb::get);
+				request.data.target(target);
+
+				HTTP::Response response;
+				router->run(*session, response);
+				Keep(response);
+			});
+		};
+
+		// First route in the table, last one and a miss that tries every route.
+		route("router_run_api", "/api");
+		route("router_run_qos", "/qos/qos?vers=1&qtyp=1&prpt=3659");
+		route("router_run_unmatched", "/does/not/exist");
+	}
+
+	// XML builders
+	// 24 creatures with ten equipped parts each, three squads and a feed.
+	Game::UserPtr CreateSyntheticUser() {
+		auto user = std::make_shared<Game::User>("bench", "bench@recap.local", "bench");
+
+		const auto templates = Repository::CreatureTemplates::ListAll();
+		const auto parts = Repository::Parts::ListAll();
+		if (templates.empty() || parts.empty()) {
+			return nullptr;
+		}
+
+		auto& creatures = user->get_creatures();
+		for (size_t i = 0; i < templates.size() && i < 24; ++i) {
+			Game::Creature creature;
+			creature.id = static_cast<uint32_t>(i + 1);
+			creature.nounId = templates[i].id;
+			creature.creator_id = 1;
+
+			// Fully equipped, ten parts each.
+			for (uint32_t p = 0; p < 10; ++p) {
+				Game::UserPart part(i * 10 + p + 1, parts[(i * 10 + p) % parts.size()].rigblock_asset_id, 1);
+				part.timestamp = 1600000000;
+				part.equipped_to_creature_id = creature.id;
+				part.status = 1;
+				part.flair = false;
+				creature.parts.Add(part);
+			}
+			creatures.Add(std::move(creature));
+		}
+
+		auto& squads = user->get_squads().data();
+		for (uint32_t i = 0; i < 3; ++i) {
+			auto& squad = squads.emplace_back();
+			squad.id = i + 1;
+			squad.slot = i + 1;
+			squad.name = "Squad " + std::to_string(i + 1);
+			squad.category = "pve";
+			squad.locked = false;
+			for (uint32_t c = 0; c < 3 && (i * 3 + c) < creatures.data().size(); ++c) {
+				squad.creatures.Add(creatures.data()[i * 3 + c]);
+			}
+		}
+
+		auto& feed = user->get_feed();
+		for (uint32_t i = 0; i < 20; ++i) {
+			Game::FeedItem item;
+			item.accountId = 1;
+			item.id = i + 1;
+			item.messageId = 3;
+			item.metadata = "bench;" + std::to_string(i);
+			item.name = "bench";
+			item.timestamp = 1600000000 + i;
+			feed.Add(std::move(item));
+		}
+
+		return user;
+	}
+
+	std::vector<Game::UserPartPtr> CreateSyntheticParts(size_t count) {
+		std::vector<Game::UserPartPtr> userParts;
+
+		const auto parts = Repository::Parts::ListAll();
+		if (parts.empty()) {
+			return userParts;
+		}
+
+		userParts.reserve(count);
+		for (size_t i = 0; i < count; ++i) {
+			auto part = std::make_shared<Game::UserPart>(i + 1, parts[i % parts.size()].rigblock_asset_id, 1);
+			part->timestamp = 1600000000 + i;
+			part->equipped_to_creature_id = (i % 4 == 0) ? static_cast<uint32_t>(i / 40 + 1) : 0;
+			part->status = 1;
+			part->flair = (i % 50) == 0;
+			userParts.push_back(std::move(part));
+		}
+		return userParts;
+	}
+
+	void BenchXml(Runner& runner) {
+		Repository::Parts::Load();
+		Repository::CreatureTemplates::Load();
+
+		// What game_account_auth builds when the account cache misses.
+		if (auto user = CreateSyntheticUser()) {
+			runner.run("xml_account_auth_240_parts", [&user] {
+				pugi::xml_document document;
+				if (auto docResponse = document.append_child("response")) {
+					user->get_account().WriteXml(docResponse);
+					user->get_creatures().WriteXml(docResponse);
+					user->get_squads().WriteXml(docResponse);
+					user->get_feed().WriteXml(docResponse);
+				}
+
+				auto body = utils::xml::ToString(document);
+				Keep(body);
+			});
+		} else {
+			runner.skip("xml_account_auth_240_parts", "no creature templates or parts in storage");
+		}
+
+		// What game_inventory_getPartList builds for the whole inventory.
+		for (size_t count : { 100, 500 }) {
+			const auto name = "xml_part_list_" + std::to_string(count);
+
+			auto userParts = CreateSyntheticParts(count);
+			if (userParts.empty()) {
+				runner.skip(name, "no parts in storage");
+				continue;
+			}
+
+			runner.run(name, [&userParts] {
+				pugi::xml_document document;
+				if (auto docResponse = document.append_child("response")) {
+					if (auto parts = docResponse.append_child("parts")) {
+						for (const auto& part : userParts) {
+							part->WriteXml(parts, true);
+						}
+					}
+				}
+
+				auto body = utils::xml::ToString(document);
+				Keep(body);
+			});
+		}
+	}
+}
+
+// main
+int main(int argc, char* argv[]) {
+	Runner runner;
+	std::string payloadPath;
+	std::string jsonPath;
+	for (int i = 1; i < argc; ++i) {
+		if (std::strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+			runner.filter = argv[++i];
+		} else if (std::strcmp(argv[i], "--min-time-ms") == 0 && i + 1 < argc) {
+			runner.minTime = std::chrono::milliseconds(std::stoul(argv[++i]));
+		} else if (std::strcmp(argv[i], "--payloads") == 0 && i + 1 < argc) {
+			payloadPath = argv[++i];
+		} else if (std::strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+			jsonPath = argv[++i];
+		} else {
+			std::cerr << "usage: bench [--filter text] [--min-time-ms 250] [--payloads dir] [--json file]" << std::endl;
+			return 1;
+		}
+	}
+
+	// Handlers log, keep that out of the numbers.
+	logger::set_level(logger::level::error);
+	Game::Config::Load("config.xml");
+
+	BenchDataBuffer(runner);
+	BenchTdf(runner, payloadPath);
+	BenchHttp(runner);
+	BenchRouter(runner);
+	BenchXml(runner);
+
+	if (!jsonPath.empty() && !WriteJson(jsonPath, runner.results)) {
+		std::cerr << "Could not write " << jsonPath << std::endl;
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,486 @@
+
+// Include
+#include "raknet/server.h"
+
+#include <MessageIdentifiers.h>
+#include <RakNetworkFactory.h>
+#include <RakPeerInterface.h>
+#include <RakSleep.h>
+
+#include <boost/asio/connect.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+
+#include <rapidjson/document.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+	Headless bots for load testing RakNet game servers.
+
+	bots [--host 127.0.0.1] [--http-port 80] [--games 25 | --ports 3659-3668] [--bots 100]
+	     [--action-rate 10] [--duration 60] [--threads 4]
+
+	Every bot connects, sends HelloPlayer, walks through the PlayerStatusUpdate transitions of a
+	dungeon start, answers DebugPing and sends ActionCommandMsgs at --action-rate per second.
+	--games asks the server for that many pooled games through the panel api, --ports targets games
+	that already run. Tick overruns are read from api.panel.listGames when the run is over.
+*/
+
+namespace {
+	using Clock = std::chrono::steady_clock;
+
+	constexpr uint32_t MaxBotsPerGame = 4;
+	constexpr size_t ActionCommandSize = 16 * sizeof(uint32_t);
+
+	struct Options {
+		std::string host = "127.0.0.1";
+		uint16_t httpPort = 80;
+		uint32_t games = 0;
+		std::vector<uint16_t> ports;
+		uint32_t bots = 100;
+		double actionRate = 10;
+		uint32_t duration = 60;
+		uint32_t threads = 4;
+	};
+
+	enum class State {
+		Connecting,
+		Joining,
+		Starting,
+		Playing,
+		Failed,
+		Disconnected
+	};
+
+	struct Bot {
+		RakPeerInterface* self = nullptr;
+		SystemAddress server;
+		uint16_t port = 0;
+		State state = State::Connecting;
+
+		// The status update currently waiting for its answer and the message that answers it.
+		uint8_t status = 0;
+		MessageID expected = 0;
+
+		Clock::time_point connectStart;
+		Clock::time_point statusSent;
+		Clock::time_point nextAction;
+		Clock::time_point nextPingSample;
+	};
+
+	struct Stats {
+		uint64_t connected = 0;
+		uint64_t failed = 0;
+		uint64_t disconnected = 0;
+		uint64_t playing = 0;
+		uint64_t actions = 0;
+		uint64_t debugPings = 0;
+		uint64_t bytesReceived = 0;
+
+		std::vector<double> connectTimes;
+		std::vector<double> statusTimes;
+		std::vector<double> pings;
+
+		void merge(const Stats& other) {
+			connected += other.connected;
+			failed += other.failed;
+			disconnected += other.disconnected;
+			playing += other.playing;
+			actions += other.actions;
+			debugPings += other.debugPings;
+			bytesReceived += other.bytesReceived;
+
+			connectTimes.insert(connectTimes.end(), other.connectTimes.begin(), other.connectTimes.end());
+			statusTimes.insert(statusTimes.end(), other.statusTimes.begin(), other.statusTimes.end());
+			pings.insert(pings.end(), other.pings.begin(), other.pings.end());
+		}
+	};
+
+	double Milliseconds(Clock::duration duration) {
+		return std::chrono::duration<double, std::milli>(duration).count();
+	}
+
+	double Percentile(std::vector<double>& values, double percentile) {
+		if (values.empty()) {
+			return 0;
+		}
+
+		size_t index = static_cast<size_t>(percentile * (values.size() - 1) + 0.5);
+		std::nth_element(values.begin(), values.begin() + index, values.end());
+		return values[index];
+	}
+
+	void PrintDistribution(const char* name, std::vector<double>& values) {
+		const double max = values.empty() ? 0.0 : *std::max_element(values.begin(), values.end());
+		std::printf("%-16s %8zu samples  p50 %8.2fms  p90 %8.2fms  p99 %8.2fms  max %8.2fms\n",
+			name, values.size(),
+			Percentile(values, 0.50), Percentile(values, 0.90), Percentile(values, 0.99), max);
+	}
+
+	bool ParsePorts(const std::string& text, std::vector<uint16_t>& ports) {
+		size_t start = 0;
+		while (start < text.size()) {
+			size_t end = text.find(',', start);
+			if (end == std::string::npos) {
+				end = text.size();
+			}
+
+			const std::string range = text.substr(start, end - start);
+			const size_t dash = range.find('-');
+			try {
+				uint16_t first = static_cast<uint16_t>(std::stoul(range.substr(0, dash)));
+				uint16_t last = dash == std::string::npos ? first : static_cast<uint16_t>(std::stoul(range.substr(dash + 1)));
+				for (uint32_t port = first; port <= last; ++port) {
+					ports.push_back(static_cast<uint16_t>(port));
+				}
+			} catch (const std::exception&) {
+				return false;
+			}
+			start = end + 1;
+		}
+		return !ports.empty();
+	}
+
+	// Calls a /recap/api method on the HTTP server.
+	bool CallApi(const Options& options, const std::string& query, rapidjson::Document& document) {
+		namespace http = boost::beast::http;
+		using tcp = boost::asio::ip::tcp;
+
+		try {
+			boost::asio::io_context context;
+			tcp::resolver resolver(context);
+			tcp::socket socket(context);
+			boost::asio::connect(socket, resolver.resolve(options.host, std::to_string(options.httpPort)));
+
+			http::request<http::empty_body> request(http::verb::get, "/recap/api?method=" + query, 11);
+			request.set(http::field::host, options.host);
+			http::write(socket, request);
+
+			boost::beast::flat_buffer buffer;
+			http::response<http::string_body> response;
+			http::read(socket, buffer, response);
+
+			boost::system::error_code error;
+			socket.shutdown(tcp::socket::shutdown_both, error);
+
+			document.Parse(response.body().c_str());
+			if (document.HasParseError() || !document.IsObject() || !document.HasMember("stat")) {
+				return false;
+			}
+			return std::strcmp(document["stat"].GetString(), "ok") == 0;
+		} catch (const std::exception& e) {
+			std::cerr << "api " << query << " failed: " << e.what() << std::endl;
+			return false;
+		}
+	}
+
+	void Send(Bot& bot, const char* data, size_t length, PacketReliability reliability = RELIABLE_ORDERED) {
+		bot.self->Send(data, static_cast<int>(length), HIGH_PRIORITY, reliability, 0, bot.server, false);
+	}
+
+	void SendStatus(Bot& bot, uint8_t status, MessageID expected) {
+		const char data[] = { static_cast<char>(RakNet::PacketID::PlayerStatusUpdate), static_cast<char>(status) };
+		Send(bot, data, sizeof(data));
+
+		bot.status = status;
+		bot.expected = expected;
+		bot.statusSent = Clock::now();
+	}
+
+	void SendActionCommand(Bot& bot, uint32_t sequence) {
+		char data[1 + ActionCommandSize] = { static_cast<char>(RakNet::PacketID::ActionCommandMsgs) };
+		std::memcpy(data + 1, &sequence, sizeof(sequence));
+		Send(bot, data, sizeof(data), RELIABLE);
+	}
+
+	void OnGameMessage(Bot& bot, Stats& stats, Packet* packet) {
+		const MessageID id = packet->data[0];
+		if (id == RakNet::PacketID::DebugPing) {
+			// Echo the server's timestamp back.
+			Send(bot, reinterpret_cast<const char*>(packet->data), packet->length, UNRELIABLE);
+			stats.debugPings++;
+			return;
+		}
+
+		if (bot.expected == 0 || id != bot.expected) {
+			return;
+		}
+
+		const auto now = Clock::now();
+		if (bot.status != 0) {
+			stats.statusTimes.push_back(Milliseconds(now - bot.statusSent));
+		}
+
+		// Status transitions the client goes through before it is in the dungeon.
+		switch (bot.status) {
+			case 0:
+				bot.state = State::Starting;
+				SendStatus(bot, 2, RakNet::PacketID::GameState);
+				break;
+
+			case 2:
+				SendStatus(bot, 4, RakNet::PacketID::ObjectivesInitForLevel);
+				break;
+
+			case 4:
+				SendStatus(bot, 8, RakNet::PacketID::PlayerCharacterDeploy);
+				break;
+
+			default:
+				bot.state = State::Playing;
+				bot.expected = 0;
+				bot.nextAction = now;
+				bot.nextPingSample = now + std::chrono::seconds(1);
+				stats.playing++;
+				break;
+		}
+	}
+
+	void Update(Bot& bot, Stats& stats, const Options& options, uint32_t& sequence) {
+		for (Packet* packet = bot.self->Receive(); packet; bot.self->DeallocatePacket(packet), packet = bot.self->Receive()) {
+			stats.bytesReceived += packet->length;
+			switch (packet->data[0]) {
+				case ID_CONNECTION_REQUEST_ACCEPTED: {
+					bot.server = packet->systemAddress;
+					bot.state = State::Joining;
+					stats.connected++;
+					stats.connectTimes.push_back(Milliseconds(Clock::now() - bot.connectStart));
+
+					const char data[] = { static_cast<char>(RakNet::PacketID::HelloPlayer) };
+					Send(bot, data, sizeof(data));
+
+					bot.status = 0;
+					bot.expected = RakNet::PacketID::GamePrepareForStart;
+					break;
+				}
+
+				case ID_CONNECTION_ATTEMPT_FAILED:
+				case ID_NO_FREE_INCOMING_CONNECTIONS:
+					bot.state = State::Failed;
+					stats.failed++;
+					break;
+
+				case ID_DISCONNECTION_NOTIFICATION:
+				case ID_CONNECTION_LOST:
+					bot.state = State::Disconnected;
+					stats.disconnected++;
+					break;
+
+				default:
+					if (packet->data[0] > ID_USER_PACKET_ENUM) {
+						OnGameMessage(bot, stats, packet);
+					}
+					break;
+			}
+		}
+
+		if (bot.state != State::Playing) {
+			return;
+		}
+
+		const auto now = Clock::now();
+		if (options.actionRate > 0 && now >= bot.nextAction) {
+			SendActionCommand(bot, sequence++);
+			stats.actions++;
+			bot.nextAction += std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / options.actionRate));
+		}
+
+		if (now >= bot.nextPingSample) {
+			int ping = bot.self->GetLastPing(bot.server);
+			if (ping >= 0) {
+				stats.pings.push_back(ping);
+			}
+			bot.nextPingSample += std::chrono::seconds(1);
+		}
+	}
+
+	void RunWorker(std::vector<Bot*> bots, const Options& options, Stats& stats, const std::atomic<bool>& running) {
+		for (auto* bot : bots) {
+			bot->self = RakNetworkFactory::GetRakPeerInterface();
+
+			SocketDescriptor descriptor(0, nullptr);
+			bot->connectStart = Clock::now();
+			if (!bot->self->Startup(1, 5, &descriptor, 1) || !bot->self->Connect(options.host.c_str(), bot->port, nullptr, 0)) {
+				bot->state = State::Failed;
+				stats.failed++;
+			}
+		}
+
+		uint32_t sequence = 0;
+		while (running) {
+			for (auto* bot : bots) {
+				if (bot->state != State::Failed && bot->state != State::Disconnected) {
+					Update(*bot, stats, options, sequence);
+				}
+			}
+			RakSleep(1);
+		}
+
+		for (auto* bot : bots) {
+			bot->self->Shutdown(100);
+			RakNetworkFactory::DestroyRakPeerInterface(bot->self);
+			bot->self = nullptr;
+		}
+	}
+
+	void PrintTickStats(const Options& options, const std::vector<uint32_t>& gameIds) {
+		rapidjson::Document document;
+		if (!CallApi(options, "api.panel.listGames", document) || !document.HasMember("games")) {
+			std::cout << "server tick stats unavailable" << std::endl;
+			return;
+		}
+
+		uint64_t totalTicks = 0;
+		uint64_t totalOverruns = 0;
+		uint64_t maxTick = 0;
+
+		std::printf("%-8s %6s %10s %10s %12s\n", "game", "port", "ticks", "overruns", "max tick");
+		for (const auto& game : document["games"].GetArray()) {
+			const uint32_t id = game["id"].GetUint();
+			if (!gameIds.empty() && std::find(gameIds.begin(), gameIds.end(), id) == gameIds.end()) {
+				continue;
+			}
+
+			const uint64_t ticks = game["ticks"].GetUint64();
+			const uint64_t overruns = game["overruns"].GetUint64();
+			const uint64_t maxTickUs = game["maxTickUs"].GetUint64();
+			std::printf("%-8u %6u %10llu %10llu %10.2fms\n",
+				id, game.HasMember("port") ? game["port"].GetUint() : 0,
+				static_cast<unsigned long long>(ticks),
+				static_cast<unsigned long long>(overruns),
+				maxTickUs / 1000.0);
+
+			totalTicks += ticks;
+			totalOverruns += overruns;
+			maxTick = std::max(maxTick, maxTickUs);
+		}
+
+		std::printf("tick overruns: %llu of %llu ticks (%.3f%%), worst tick %.2fms, budget %lldms\n",
+			static_cast<unsigned long long>(totalOverruns),
+			static_cast<unsigned long long>(totalTicks),
+			totalTicks ? 100.0 * totalOverruns / totalTicks : 0.0,
+			maxTick / 1000.0,
+			static_cast<long long>(RakNet::Server::TickInterval.count()));
+	}
+}
+
+// main
+int main(int argc, char* argv[]) {
+	Options options;
+	for (int i = 1; i < argc; ++i) {
+		const bool hasValue = i + 1 < argc;
+		if (std::strcmp(argv[i], "--host") == 0 && hasValue) {
+			options.host = argv[++i];
+		} else if (std::strcmp(argv[i], "--http-port") == 0 && hasValue) {
+			options.httpPort = static_cast<uint16_t>(std::stoul(argv[++i]));
+		} else if (std::strcmp(argv[i], "--games") == 0 && hasValue) {
+			options.games = std::stoul(argv[++i]);
+		} else if (std::strcmp(argv[i], "--ports") == 0 && hasValue) {
+			if (!ParsePorts(argv[++i], options.ports)) {
+				std::cerr << "Invalid port list " << argv[i] << std::endl;
+				return 1;
+			}
+		} else if (std::strcmp(argv[i], "--bots") == 0 && hasValue) {
+			options.bots = std::stoul(argv[++i]);
+		} else if (std::strcmp(argv[i], "--action-rate") == 0 && hasValue) {
+			options.actionRate = std::stod(argv[++i]);
+		} else if (std::strcmp(argv[i], "--duration") == 0 && hasValue) {
+			options.duration = std::stoul(argv[++i]);
+		} else if (std::strcmp(argv[i], "--threads") == 0 && hasValue) {
+			options.threads = std::max<uint32_t>(1, std::stoul(argv[++i]));
+		} else {
+			std::cerr << "usage: bots [--host 127.0.0.1] [--http-port 80] [--games 25 | --ports 3659-3668] [--bots 100] [--action-rate 10] [--duration 60] [--threads 4]" << std::endl;
+			return 1;
+		}
+	}
+
+	// Games
+	std::vector<uint32_t> gameIds;
+	for (uint32_t i = 0; i < options.games; ++i) {
+		rapidjson::Document document;
+		if (!CallApi(options, "api.panel.createGame", document)) {
+			std::cerr << "Could only create " << i << " of " << options.games << " games, raise GAME_SERVER_POOL_SIZE" << std::endl;
+			break;
+		}
+
+		gameIds.push_back(document["id"].GetUint());
+		options.ports.push_back(static_cast<uint16_t>(document["port"].GetUint()));
+	}
+
+	if (options.ports.empty()) {
+		std::cerr << "No games to connect to, use --games or --ports" << std::endl;
+		return 1;
+	}
+
+	if (options.bots > options.ports.size() * MaxBotsPerGame) {
+		std::cerr << "Warning: " << options.bots << " bots do not fit into " << options.ports.size() << " games of " << MaxBotsPerGame << " players" << std::endl;
+	}
+
+	// Bots
+	std::vector<Bot> bots(options.bots);
+	for (size_t i = 0; i < bots.size(); ++i) {
+		bots[i].port = options.ports[i % options.ports.size()];
+	}
+
+	std::vector<std::vector<Bot*>> slices(std::min<size_t>(options.threads, bots.size()));
+	for (size_t i = 0; i < bots.size(); ++i) {
+		slices[i % slices.size()].push_back(&bots[i]);
+	}
+
+	std::atomic<bool> running = true;
+	std::vector<Stats> workerStats(slices.size());
+
+	std::vector<std::thread> workers;
+	for (size_t i = 0; i < slices.size(); ++i) {
+		workers.emplace_back(RunWorker, slices[i], std::cref(options), std::ref(workerStats[i]), std::cref(running));
+	}
+
+	std::cout << options.bots << " bots on " << options.ports.size() << " games for " << options.duration << "s" << std::endl;
+	std::this_thread::sleep_for(std::chrono::seconds(options.duration));
+
+	running = false;
+	for (auto& worker : workers) {
+		worker.join();
+	}
+
+	// Report
+	Stats stats;
+	for (const auto& workerStat : workerStats) {
+		stats.merge(workerStat);
+	}
+
+	std::printf("bots: %u, connected %llu, in game %llu, failed %llu, disconnected %llu\n",
+		options.bots,
+		static_cast<unsigned long long>(stats.connected),
+		static_cast<unsigned long long>(stats.playing),
+		static_cast<unsigned long long>(stats.failed),
+		static_cast<unsigned long long>(stats.disconnected));
+
+	std::printf("actions sent: %llu (%.1f/s), debug pings answered: %llu, bytes received: %llu\n",
+		static_cast<unsigned long long>(stats.actions),
+		static_cast<double>(stats.actions) / options.duration,
+		static_cast<unsigned long long>(stats.debugPings),
+		static_cast<unsigned long long>(stats.bytesReceived));
+
+	PrintDistribution("connect", stats.connectTimes);
+	PrintDistribution("status rtt", stats.statusTimes);
+	PrintDistribution("raknet ping", stats.pings);
+
+	PrintTickStats(options, gameIds);
+
+	for (uint32_t id : gameIds) {
+		rapidjson::Document document;
+		CallApi(options, "api.panel.removeGame&game=" + std::to_string(id), document);
+	}
+	return 0;
+}
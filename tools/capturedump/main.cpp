@@ -0,0 +1,154 @@
+
+// Include
+#include "raknet/capture.h"
+#include "raknet/packetid.h"
+
+#include <MessageIdentifiers.h>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/*
+	Pretty-prints a packet capture written by RakNet::PacketCapture.
+
+	capturedump <file.rcap> [--messages] [--datagrams]
+*/
+
+namespace {
+	const char* GetMessageName(uint8_t id) {
+		switch (id) {
+			case ID_INTERNAL_PING:                    return "ID_INTERNAL_PING";
+			case ID_PING:                             return "ID_PING";
+			case ID_CONNECTED_PONG:                   return "ID_CONNECTED_PONG";
+			case ID_CONNECTION_REQUEST:               return "ID_CONNECTION_REQUEST";
+			case ID_CONNECTION_REQUEST_ACCEPTED:      return "ID_CONNECTION_REQUEST_ACCEPTED";
+			case ID_NEW_INCOMING_CONNECTION:          return "ID_NEW_INCOMING_CONNECTION";
+			case ID_DISCONNECTION_NOTIFICATION:       return "ID_DISCONNECTION_NOTIFICATION";
+			case ID_CONNECTION_LOST:                  return "ID_CONNECTION_LOST";
+			case ID_TIMESTAMP:                        return "ID_TIMESTAMP";
+			case ID_USER_PACKET_ENUM:                 return "ID_USER_PACKET_ENUM";
+			default:                                  break;
+		}
+
+		const char* name = RakNet::GetPacketName(id);
+		return name ? name : "?";
+	}
+
+	std::string FormatAddress(uint32_t address, uint16_t port) {
+		const auto* bytes = reinterpret_cast<const uint8_t*>(&address);
+
+		char buffer[32];
+		std::snprintf(buffer, sizeof(buffer), "%u.%u.%u.%u:%u", bytes[0], bytes[1], bytes[2], bytes[3], port);
+		return buffer;
+	}
+
+	void PrintHex(const std::vector<uint8_t>& data) {
+		char line[80];
+		for (size_t offset = 0; offset < data.size(); offset += 16) {
+			int length = std::snprintf(line, sizeof(line), "    %04zX ", offset);
+			for (size_t i = offset; i < offset + 16; ++i) {
+				if (i < data.size()) {
+					length += std::snprintf(line + length, sizeof(line) - length, " %02X", data[i]);
+				} else {
+					length += std::snprintf(line + length, sizeof(line) - length, "   ");
+				}
+			}
+			std::cout << line << std::endl;
+		}
+	}
+}
+
+// main
+int main(int argc, char* argv[]) {
+	if (argc < 2) {
+		std::cerr << "usage: capturedump <file.rcap> [--messages] [--datagrams]" << std::endl;
+		return 1;
+	}
+
+	bool showMessages = true;
+	bool showDatagrams = true;
+	for (int i = 2; i < argc; ++i) {
+		if (std::strcmp(argv[i], "--messages") == 0) {
+			showDatagrams = false;
+		} else if (std::strcmp(argv[i], "--datagrams") == 0) {
+			showMessages = false;
+		}
+	}
+
+	std::ifstream file(argv[1], std::ios::binary);
+	if (!file.is_open()) {
+		std::cerr << "Could not open " << argv[1] << std::endl;
+		return 1;
+	}
+
+	RakNet::Capture::FileHeader fileHeader;
+	file.read(reinterpret_cast<char*>(&fileHeader), sizeof(fileHeader));
+	if (!file || fileHeader.magic != RakNet::Capture::Magic) {
+		std::cerr << argv[1] << " is not a packet capture" << std::endl;
+		return 1;
+	}
+
+	if (fileHeader.version != RakNet::Capture::Version) {
+		std::cerr << "Unsupported capture version " << fileHeader.version << std::endl;
+		return 1;
+	}
+
+	std::cout << "game " << fileHeader.gameId << ", " << fileHeader.count << " records" << std::endl;
+
+	uint64_t firstTimestamp = 0;
+	uint64_t bytesIn = 0;
+	uint64_t bytesOut = 0;
+
+	std::vector<uint8_t> data;
+	for (uint32_t i = 0; i < fileHeader.count; ++i) {
+		RakNet::Capture::RecordHeader header;
+		file.read(reinterpret_cast<char*>(&header), sizeof(header));
+
+		data.resize(header.capturedLength);
+		file.read(reinterpret_cast<char*>(data.data()), data.size());
+		if (!file) {
+			std::cerr << "Capture is truncated after " << i << " records" << std::endl;
+			return 1;
+		}
+
+		if (i == 0) {
+			firstTimestamp = header.timestamp;
+		}
+
+		bool inbound = header.direction == RakNet::Capture::Direction::Inbound;
+		bool message = header.kind == RakNet::Capture::Kind::Message;
+		if (header.kind == RakNet::Capture::Kind::Datagram) {
+			(inbound ? bytesIn : bytesOut) += header.length;
+		}
+
+		if ((message && !showMessages) || (!message && !showDatagrams)) {
+			continue;
+		}
+
+		char line[160];
+		std::snprintf(line, sizeof(line), "%12.3fms %s %-21s %-8s %5u bytes",
+			(header.timestamp - firstTimestamp) / 1000.0,
+			inbound ? "<-" : "->",
+			FormatAddress(header.address, header.port).c_str(),
+			message ? "message" : "datagram",
+			header.length);
+
+		std::cout << line;
+		if (message && !data.empty()) {
+			std::cout << "  0x" << std::hex << static_cast<int>(data[0]) << std::dec << " " << GetMessageName(data[0]);
+		}
+		if (header.capturedLength < header.length) {
+			std::cout << "  (truncated)";
+		}
+		std::cout << std::endl;
+
+		PrintHex(data);
+	}
+
+	std::cout << "datagram bytes in: " << bytesIn << ", out: " << bytesOut << std::endl;
+	return 0;
+}
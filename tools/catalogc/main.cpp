@@ -0,0 +1,40 @@
+
+// Include
+#include "repository/catalog.h"
+
+#include <iostream>
+#include <string>
+
+/*
+	Compiles parts.json and templates.json into the binary catalog the server maps at startup.
+	The server falls back to the json files whenever the catalog is missing or older than them.
+
+	catalogc <parts.json> <templates.json> <catalog.bin>
+*/
+
+// main
+int main(int argc, char* argv[]) {
+	if (argc < 4) {
+		std::cout << "usage: catalogc <parts.json> <templates.json> <catalog.bin>" << std::endl;
+		return 1;
+	}
+
+	const std::string outputPath = argv[3];
+	if (!Repository::Catalog::Compile(argv[1], argv[2], outputPath)) {
+		return 1;
+	}
+
+	Repository::Catalog catalog;
+	if (!catalog.Open(outputPath, argv[1])) {
+		std::cout << "catalogc: could not read back " << outputPath << std::endl;
+		return 1;
+	}
+
+	std::vector<Game::Part> parts;
+	std::vector<Game::CreatureTemplate> templates;
+	catalog.ReadParts(parts);
+	catalog.ReadTemplates(templates);
+
+	std::cout << outputPath << ": " << parts.size() << " parts, " << templates.size() << " templates" << std::endl;
+	return 0;
+}
@@ -0,0 +1,677 @@
+
+// Include
+#include "databuffer.h"
+#include "blaze/tdf.h"
+#include "blaze/types.h"
+#include "utils/logger.h"
+
+#include <boost/asio/connect.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/read.hpp>
+#include <boost/asio/ssl.hpp>
+#include <boost/asio/write.hpp>
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+
+#include <pugixml.hpp>
+#include <rapidjson/document.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*
+	Headless client for load testing the Blaze and HTTP login flow.
+
+	loginsim [--host 127.0.0.1] [--redirector-port 42127] [--blaze-port 10041] [--http-port 80]
+	         [--stages 1,5,10,25] [--stage-seconds 30] [--heartbeats 3] [--timeout-ms 5000]
+	         [--prefix loginsim] [--no-register] [--no-game]
+
+	Every stage runs that many virtual users at once, each one goes through the client's sequence
+	over and over until the stage is over:
+
+		redirector: TLS connect, ServerInstanceInfo
+		blaze:      TLS connect, PreAuth, Login, LoginPersona, PostAuth, GetAuthToken,
+		            UserSessions heartbeats, CreateGame, FinalizeGameCreation, Logout
+		http:       api.account.auth, api.inventory.getPartList, api.deck.updateDecks
+
+	Virtual user n logs in as <prefix>n@recap.local, the accounts are registered through
+	api.game.registration before the first stage unless --no-register is given. --no-game skips
+	game creation so no RakNet servers are started.
+
+	Per step latency percentiles and error rates are printed after every stage.
+*/
+
+namespace {
+	using Clock = std::chrono::steady_clock;
+	using tcp = boost::asio::ip::tcp;
+	namespace http = boost::beast::http;
+
+	// Blaze commands used by the flow, see the components for the server side.
+	constexpr uint16_t RedirectorServerInstanceInfo = 0x01;
+	constexpr uint16_t UtilPreAuth = 0x07;
+	constexpr uint16_t UtilPostAuth = 0x08;
+	constexpr uint16_t AuthGetAuthToken = 0x24;
+	constexpr uint16_t AuthLogin = 0x28;
+	constexpr uint16_t AuthLogout = 0x46;
+	constexpr uint16_t AuthLoginPersona = 0x6E;
+	constexpr uint16_t UserSessionsUpdateClientData = 0x19;
+	constexpr uint16_t GameManagerFinalizeGameCreation = 0x0F;
+	constexpr uint16_t GameManagerResetDedicatedServer = 0x19;
+
+	struct Options {
+		std::string host = "127.0.0.1";
+		uint16_t redirectorPort = 42127;
+		uint16_t blazePort = 10041;
+		uint16_t httpPort = 80;
+		std::vector<uint32_t> stages { 1, 5, 10, 25 };
+		uint32_t stageSeconds = 30;
+		uint32_t heartbeats = 3;
+		std::chrono::milliseconds timeout { 5000 };
+		std::string prefix = "loginsim";
+		bool registerUsers = true;
+		bool createGame = true;
+	};
+
+	struct StepStats {
+		uint64_t errors = 0;
+		std::vector<double> latencies;
+		std::map<std::string, uint64_t> errorMessages;
+	};
+
+	// Steps keep the order they were first seen in so the report follows the flow.
+	struct Stats {
+		std::vector<std::pair<std::string, StepStats>> steps;
+		uint64_t sessions = 0;
+		uint64_t failedSessions = 0;
+
+		StepStats& get(const std::string& name) {
+			for (auto& [stepName, step] : steps) {
+				if (stepName == name) {
+					return step;
+				}
+			}
+			return steps.emplace_back(name, StepStats {}).second;
+		}
+
+		void merge(const Stats& other) {
+			for (const auto& [name, otherStep] : other.steps) {
+				auto& step = get(name);
+				step.errors += otherStep.errors;
+				step.latencies.insert(step.latencies.end(), otherStep.latencies.begin(), otherStep.latencies.end());
+				for (const auto& [message, count] : otherStep.errorMessages) {
+					step.errorMessages[message] += count;
+				}
+			}
+			sessions += other.sessions;
+			failedSessions += other.failedSessions;
+		}
+	};
+
+	double Milliseconds(Clock::duration duration) {
+		return std::chrono::duration<double, std::milli>(duration).count();
+	}
+
+	double Percentile(std::vector<double>& values, double percentile) {
+		if (values.empty()) {
+			return 0;
+		}
+
+		size_t index = static_cast<size_t>(percentile * (values.size() - 1) + 0.5);
+		std::nth_element(values.begin(), values.begin() + index, values.end());
+		return values[index];
+	}
+
+	bool ParseStages(const std::string& text, std::vector<uint32_t>& stages) {
+		stages.clear();
+
+		size_t start = 0;
+		while (start < text.size()) {
+			size_t end = text.find(',', start);
+			if (end == std::string::npos) {
+				end = text.size();
+			}
+
+			try {
+				stages.push_back(std::stoul(text.substr(start, end - start)));
+			} catch (...) {
+				return false;
+			}
+			start = end + 1;
+		}
+		return !stages.empty();
+	}
+
+	// Runs one asynchronous operation on io with a deadline, the socket is closed if it passes.
+	template<typename Socket, typename Start>
+	bool Wait(boost::asio::io_context& io, Socket& socket, std::chrono::milliseconds timeout, std::string& error, Start&& start) {
+		boost::system::error_code result = boost::asio::error::would_block;
+		start([&result](const boost::system::error_code& ec, auto&&...) { result = ec; });
+
+		io.restart();
+		io.run_for(timeout);
+		if (result == boost::asio::error::would_block) {
+			boost::system::error_code ignored;
+			socket.close(ignored);
+
+			// Let the aborted handler run before result goes out of scope.
+			io.restart();
+			io.run();
+
+			error = "timeout";
+			return false;
+		}
+
+		if (result) {
+			error = result.message();
+			return false;
+		}
+		return true;
+	}
+
+	// BlazeConnection, the client side of Blaze::Client.
+	class BlazeConnection {
+		public:
+			BlazeConnection(boost::asio::io_context& io, boost::asio::ssl::context& context, std::chrono::milliseconds timeout) :
+				mIo(io), mSocket(io, context), mTimeout(timeout) {}
+
+			bool connect(const std::string& host, uint16_t port, std::string& error) {
+				tcp::resolver resolver(mIo);
+
+				boost::system::error_code ec;
+				const auto endpoints = resolver.resolve(host, std::to_string(port), ec);
+				if (ec) {
+					error = ec.message();
+					return false;
+				}
+
+				return Wait(mIo, mSocket.lowest_layer(), mTimeout, error, [&](auto handler) {
+					boost::asio::async_connect(mSocket.lowest_layer(), endpoints, handler);
+				}) && Wait(mIo, mSocket.lowest_layer(), mTimeout, error, [&](auto handler) {
+					mSocket.async_handshake(boost::asio::ssl::stream_base::client, handler);
+				});
+			}
+
+			void close() {
+				boost::system::error_code ignored;
+				mSocket.lowest_layer().close(ignored);
+			}
+
+			bool send(Blaze::Component component, uint16_t command, Blaze::TDF::Packet* packet, uint32_t messageId, std::string& error) {
+				DataBuffer payload;
+				if (packet) {
+					packet->Write(payload);
+				}
+
+				DataBuffer buffer;
+				buffer.write_u16_be(static_cast<uint16_t>(payload.size()));
+				buffer.write_u16_be(static_cast<uint16_t>(component));
+				buffer.write_u16_be(command);
+				buffer.write_u16_be(0);
+				buffer.write_u32_be((static_cast<uint32_t>(Blaze::MessageType::Message) << 28) | (messageId & 0xFFFFF));
+				if (payload.size() > 0) {
+					buffer.insert(payload);
+				}
+
+				return Wait(mIo, mSocket.lowest_layer(), mTimeout, error, [&](auto handler) {
+					boost::asio::async_write(mSocket, boost::asio::buffer(buffer.data(), buffer.size()), handler);
+				});
+			}
+
+			// Sends a request and waits for its reply, notifications that arrive in between are skipped.
+			bool request(Blaze::Component component, uint16_t command, Blaze::TDF::Packet* packet, rapidjson::Document& reply, std::string& error) {
+				const uint32_t messageId = ++mMessageId;
+				if (!send(component, command, packet, messageId, error)) {
+					return false;
+				}
+
+				while (true) {
+					std::array<uint8_t, 12> headerData;
+					if (!Wait(mIo, mSocket.lowest_layer(), mTimeout, error, [&](auto handler) {
+						boost::asio::async_read(mSocket, boost::asio::buffer(headerData), handler);
+					})) {
+						return false;
+					}
+
+					const uint16_t length = (headerData[0] << 8) | headerData[1];
+					const uint16_t errorCode = (headerData[6] << 8) | headerData[7];
+					const uint32_t message = (headerData[8] << 24) | (headerData[9] << 16) | (headerData[10] << 8) | headerData[11];
+
+					DataBuffer payload;
+					if (length > 0) {
+						payload.resize(length);
+						if (!Wait(mIo, mSocket.lowest_layer(), mTimeout, error, [&](auto handler) {
+							boost::asio::async_read(mSocket, boost::asio::buffer(payload.data(), length), handler);
+						})) {
+							return false;
+						}
+					}
+
+					const auto type = static_cast<Blaze::MessageType>(message >> 28);
+					if (type == Blaze::MessageType::Notification || (message & 0xFFFFF) != messageId) {
+						continue;
+					}
+
+					if (type == Blaze::MessageType::ErrorReply || errorCode != 0) {
+						error = "blaze error " + std::to_string(errorCode);
+						return false;
+					}
+
+					reply = {};
+					reply.SetObject();
+					payload.set_position(0);
+					Blaze::TDF::Parse(payload, reply);
+					return true;
+				}
+			}
+
+		private:
+			boost::asio::io_context& mIo;
+			boost::asio::ssl::stream<tcp::socket> mSocket;
+			std::chrono::milliseconds mTimeout;
+			uint32_t mMessageId = 0;
+	};
+
+	// HttpConnection, one keep-alive connection to the web server of the game.
+	class HttpConnection {
+		public:
+			HttpConnection(boost::asio::io_context& io, std::chrono::milliseconds timeout) : mIo(io), mSocket(io), mTimeout(timeout) {}
+
+			bool get(const Options& options, const std::string& target, std::string& body, std::string& error) {
+				if (!mSocket.is_open()) {
+					tcp::resolver resolver(mIo);
+
+					boost::system::error_code ec;
+					const auto endpoints = resolver.resolve(options.host, std::to_string(options.httpPort), ec);
+					if (ec) {
+						error = ec.message();
+						return false;
+					}
+
+					if (!Wait(mIo, mSocket, mTimeout, error, [&](auto handler) { boost::asio::async_connect(mSocket, endpoints, handler); })) {
+						return false;
+					}
+				}
+
+				http::request<http::empty_body> request(http::verb::get, target, 11);
+				request.set(http::field::host, options.host);
+				request.keep_alive(true);
+
+				http::response<http::string_body> response;
+				if (!Wait(mIo, mSocket, mTimeout, error, [&](auto handler) { http::async_write(mSocket, request, handler); }) ||
+					!Wait(mIo, mSocket, mTimeout, error, [&](auto handler) { http::async_read(mSocket, mBuffer, response, handler); })) {
+					close();
+					return false;
+				}
+
+				if (!response.keep_alive()) {
+					close();
+				}
+
+				if (response.result() != http::status::ok) {
+					error = "http " + std::to_string(response.result_int());
+					return false;
+				}
+
+				body = std::move(response.body());
+				return true;
+			}
+
+			void close() {
+				boost::system::error_code ignored;
+				mSocket.close(ignored);
+				mBuffer.clear();
+			}
+
+		private:
+			boost::asio::io_context& mIo;
+			tcp::socket mSocket;
+			boost::beast::flat_buffer mBuffer;
+			std::chrono::milliseconds mTimeout;
+	};
+
+	// Session, one pass through the whole flow for one virtual user.
+	class Session {
+		public:
+			Session(const Options& options, boost::asio::ssl::context& context, Stats& stats, uint32_t index) :
+				mOptions(options), mContext(context), mStats(stats), mIndex(index) {}
+
+			bool run() {
+				boost::asio::io_context io;
+
+				// Redirector
+				{
+					BlazeConnection redirector(io, mContext, mOptions.timeout);
+					if (!step("redirector.connect", [&](std::string& error) { return redirector.connect(mOptions.host, mOptions.redirectorPort, error); })) {
+						return false;
+					}
+
+					rapidjson::Document reply;
+					if (!step("redirector.ServerInstanceInfo", [&](std::string& error) {
+						Blaze::TDF::Packet packet;
+						packet.PutString(nullptr, "BSDK", "3.15.7.0");
+						packet.PutString(nullptr, "CLNT", "Darkspore");
+						packet.PutString(nullptr, "NAME", "darkspore-pc");
+						packet.PutString(nullptr, "PLAT", "PC");
+						return redirector.request(Blaze::Component::Redirector, RedirectorServerInstanceInfo, &packet, reply, error);
+					})) {
+						return false;
+					}
+					redirector.close();
+				}
+
+				// Blaze
+				BlazeConnection blaze(io, mContext, mOptions.timeout);
+				if (!step("blaze.connect", [&](std::string& error) { return blaze.connect(mOptions.host, mOptions.blazePort, error); })) {
+					return false;
+				}
+
+				rapidjson::Document reply;
+				const auto blazeStep = [&](const char* name, Blaze::Component component, uint16_t command, const std::function<void(Blaze::TDF::Packet&)>& build) {
+					return step(name, [&](std::string& error) {
+						Blaze::TDF::Packet packet;
+						if (build) {
+							build(packet);
+						}
+						return blaze.request(component, command, &packet, reply, error);
+					});
+				};
+
+				const std::string email = mOptions.prefix + std::to_string(mIndex) + "@recap.local";
+				const bool loggedIn =
+					blazeStep("util.PreAuth", Blaze::Component::Util, UtilPreAuth, [](Blaze::TDF::Packet& packet) {
+						auto& cdatStruct = packet.CreateStruct(nullptr, "CDAT");
+						packet.PutInteger(&cdatStruct, "LANG", 0x656E);
+						packet.PutString(&cdatStruct, "SVCN", "darkspore");
+						packet.PutInteger(&cdatStruct, "TYPE", Blaze::ClientType::GameplayUser);
+
+						auto& cinfStruct = packet.CreateStruct(nullptr, "CINF");
+						packet.PutString(&cinfStruct, "BSDK", "3.15.7.0");
+						packet.PutInteger(&cinfStruct, "LOC", 0x656E5553);
+						packet.PutString(&cinfStruct, "PLAT", "PC");
+					}) &&
+					blazeStep("auth.Login", Blaze::Component::Authentication, AuthLogin, [&](Blaze::TDF::Packet& packet) {
+						packet.PutString(nullptr, "MAIL", email);
+						packet.PutString(nullptr, "PASS", mOptions.prefix);
+					}) &&
+					blazeStep("auth.LoginPersona", Blaze::Component::Authentication, AuthLoginPersona, [&](Blaze::TDF::Packet& packet) {
+						packet.PutString(nullptr, "PNAM", mOptions.prefix + std::to_string(mIndex));
+					}) &&
+					blazeStep("util.PostAuth", Blaze::Component::Util, UtilPostAuth, nullptr) &&
+					blazeStep("auth.GetAuthToken", Blaze::Component::Authentication, AuthGetAuthToken, nullptr);
+
+				if (!loggedIn) {
+					return false;
+				}
+
+				const std::string token = reply.HasMember("AUTH") && reply["AUTH"].IsString() ? reply["AUTH"].GetString() : "";
+				for (uint32_t i = 0; i < mOptions.heartbeats; ++i) {
+					if (!blazeStep("usersessions.heartbeat", Blaze::Component::UserSessions, UserSessionsUpdateClientData, nullptr)) {
+						return false;
+					}
+				}
+
+				// HTTP
+				HttpConnection web(io, mOptions.timeout);
+
+				std::string body;
+				const std::string query = "/game/api?version=1&build=5.3.0.127&token=" + token;
+				if (!step("http.account.auth", [&](std::string& error) {
+					return web.get(mOptions, "/game/api?version=1&build=5.3.0.127&method=api.account.auth&key=" + token + "::0"
+						"&include_creatures=true&include_decks=true&include_feed=true&include_server_tuning=true&include_settings=true", body, error) &&
+						CheckXml(body, error);
+				})) {
+					return false;
+				}
+
+				// The decks are sent back with the first owned creatures, like picking them in the deck editor.
+				std::string creatures;
+				{
+					pugi::xml_document document;
+					document.load_string(body.c_str());
+
+					uint32_t count = 0;
+					for (const auto& creature : document.child("response").child("creatures").children("creature")) {
+						if (count++ == 9) {
+							break;
+						}
+						creatures += (creatures.empty() ? "" : ",") + std::string(creature.child_value("id"));
+					}
+					for (; count < 9; ++count) {
+						creatures += (creatures.empty() ? "0" : ",0");
+					}
+				}
+
+				if (!step("http.inventory.getPartList", [&](std::string& error) {
+					return web.get(mOptions, query + "&method=api.inventory.getPartList", body, error) && CheckXml(body, error);
+				}) || !step("http.deck.updateDecks", [&](std::string& error) {
+					return web.get(mOptions, query + "&method=api.deck.updateDecks&pve_creatures=" + creatures, body, error) && CheckXml(body, error);
+				})) {
+					return false;
+				}
+				web.close();
+
+				// Game
+				if (mOptions.createGame) {
+					const bool created =
+						blazeStep("gamemanager.CreateGame", Blaze::Component::GameManager, GameManagerResetDedicatedServer, [](Blaze::TDF::Packet& packet) {
+							using Blaze::TDF::Type;
+
+							auto& attrMap = packet.CreateMap(nullptr, "ATTR", Type::String, Type::String);
+							packet.PutString(&attrMap, "Difficulty", "1");
+							packet.PutString(&attrMap, "Planet", "loginsim");
+
+							packet.PutString(nullptr, "GNAM", "loginsim");
+							packet.PutInteger(nullptr, "GSET", 0x1F);
+							packet.PutString(nullptr, "GTYP", "gameType0");
+							{
+								auto& hnetList = packet.CreateList(nullptr, "HNET", Type::Struct);
+								for (int i = 0; i < 2; ++i) {
+									auto& addressStruct = packet.CreateStruct(&hnetList, "");
+									packet.PutInteger(&addressStruct, "IP", 0x7F000001);
+									packet.PutInteger(&addressStruct, "PORT", 3659);
+								}
+							}
+							packet.PutInteger(nullptr, "NRES", 1);
+							packet.PutInteger(nullptr, "NTOP", 0);
+							{
+								auto& pcapList = packet.CreateList(nullptr, "PCAP", Type::Integer);
+								packet.PutInteger(&pcapList, "", 4);
+								packet.PutInteger(&pcapList, "", 0);
+							}
+							packet.PutInteger(nullptr, "PMAX", 4);
+							packet.PutInteger(nullptr, "PRES", 1);
+							packet.PutInteger(nullptr, "QCAP", 0);
+							packet.PutInteger(nullptr, "VOIP", 0);
+						}) &&
+						blazeStep("gamemanager.FinalizeGameCreation", Blaze::Component::GameManager, GameManagerFinalizeGameCreation, nullptr);
+
+					if (!created) {
+						return false;
+					}
+				}
+
+				// Logout has no reply, the connection is closed right after like the client does.
+				std::string error;
+				blaze.send(Blaze::Component::Authentication, AuthLogout, nullptr, 0, error);
+				blaze.close();
+				return true;
+			}
+
+		private:
+			static bool CheckXml(const std::string& body, std::string& error) {
+				pugi::xml_document document;
+				if (!document.load_string(body.c_str()) || !document.child("response")) {
+					error = "invalid xml";
+					return false;
+				}
+				return true;
+			}
+
+			bool step(const std::string& name, const std::function<bool(std::string&)>& fn) {
+				auto& stats = mStats.get(name);
+
+				std::string error;
+				const auto start = Clock::now();
+				if (fn(error)) {
+					stats.latencies.push_back(Milliseconds(Clock::now() - start));
+					return true;
+				}
+
+				stats.errors++;
+				stats.errorMessages[error]++;
+				return false;
+			}
+
+		private:
+			const Options& mOptions;
+			boost::asio::ssl::context& mContext;
+			Stats& mStats;
+			uint32_t mIndex;
+	};
+
+	// Same settings as the server, the game only talks SSLv3 with RC4.
+	void SetupContext(boost::asio::ssl::context& context) {
+		auto nativeHandle = context.native_handle();
+		SSL_CTX_set_security_level(nativeHandle, 0);
+		SSL_CTX_set_cipher_list(nativeHandle, "RC4-MD5:RC4-SHA");
+		context.set_verify_mode(boost::asio::ssl::verify_none);
+	}
+
+	void RegisterUsers(const Options& options, uint32_t count) {
+		boost::asio::io_context io;
+		HttpConnection web(io, options.timeout);
+
+		uint32_t registered = 0;
+		for (uint32_t i = 0; i < count; ++i) {
+			const std::string name = options.prefix + std::to_string(i);
+
+			std::string body;
+			std::string error;
+			if (web.get(options, "/recap/api?method=api.game.registration&name=" + name + "&mail=" + name + "%40recap.local&pass=" + options.prefix + "&avatar=1", body, error)) {
+				rapidjson::Document document;
+				document.Parse(body.c_str());
+				if (document.IsObject() && document.HasMember("stat") && document["stat"] == "ok") {
+					registered++;
+				}
+			} else {
+				std::cerr << "Could not register " << name << ": " << error << std::endl;
+			}
+		}
+		std::printf("registered %u new accounts, %u already existed or failed\n", registered, count - registered);
+	}
+
+	void PrintStage(uint32_t concurrency, double seconds, Stats& stats) {
+		std::printf("\n%u users, %.1fs, %llu sessions (%.2f/s), %llu failed\n",
+			concurrency, seconds,
+			static_cast<unsigned long long>(stats.sessions), stats.sessions / seconds,
+			static_cast<unsigned long long>(stats.failedSessions));
+
+		std::printf("%-34s %8s %8s %7s %10s %10s %10s %10s\n", "step", "ok", "errors", "err%", "p50", "p90", "p99", "max");
+		for (auto& [name, step] : stats.steps) {
+			const auto total = step.latencies.size() + step.errors;
+			const double max = step.latencies.empty() ? 0.0 : *std::max_element(step.latencies.begin(), step.latencies.end());
+			std::printf("%-34s %8zu %8llu %6.2f%% %8.2fms %8.2fms %8.2fms %8.2fms\n",
+				name.c_str(), step.latencies.size(), static_cast<unsigned long long>(step.errors),
+				total ? 100.0 * step.errors / total : 0.0,
+				Percentile(step.latencies, 0.50), Percentile(step.latencies, 0.90), Percentile(step.latencies, 0.99), max);
+
+			for (const auto& [message, count] : step.errorMessages) {
+				std::printf("    %llu x %s\n", static_cast<unsigned long long>(count), message.c_str());
+			}
+		}
+	}
+}
+
+// main
+int main(int argc, char* argv[]) {
+	Options options;
+	for (int i = 1; i < argc; ++i) {
+		if (std::strcmp(argv[i], "--host") == 0 && i + 1 < argc) {
+			options.host = argv[++i];
+		} else if (std::strcmp(argv[i], "--redirector-port") == 0 && i + 1 < argc) {
+			options.redirectorPort = static_cast<uint16_t>(std::stoul(argv[++i]));
+		} else if (std::strcmp(argv[i], "--blaze-port") == 0 && i + 1 < argc) {
+			options.blazePort = static_cast<uint16_t>(std::stoul(argv[++i]));
+		} else if (std::strcmp(argv[i], "--http-port") == 0 && i + 1 < argc) {
+			options.httpPort = static_cast<uint16_t>(std::stoul(argv[++i]));
+		} else if (std::strcmp(argv[i], "--stages") == 0 && i + 1 < argc) {
+			if (!ParseStages(argv[++i], options.stages)) {
+				std::cerr << "Invalid stages: " << argv[i] << std::endl;
+				return 1;
+			}
+		} else if (std::strcmp(argv[i], "--stage-seconds") == 0 && i + 1 < argc) {
+			options.stageSeconds = std::stoul(argv[++i]);
+		} else if (std::strcmp(argv[i], "--heartbeats") == 0 && i + 1 < argc) {
+			options.heartbeats = std::stoul(argv[++i]);
+		} else if (std::strcmp(argv[i], "--timeout-ms") == 0 && i + 1 < argc) {
+			options.timeout = std::chrono::milliseconds(std::stoul(argv[++i]));
+		} else if (std::strcmp(argv[i], "--prefix") == 0 && i + 1 < argc) {
+			options.prefix = argv[++i];
+		} else if (std::strcmp(argv[i], "--no-register") == 0) {
+			options.registerUsers = false;
+		} else if (std::strcmp(argv[i], "--no-game") == 0) {
+			options.createGame = false;
+		} else {
+			std::cerr << "usage: loginsim [--host 127.0.0.1] [--redirector-port 42127] [--blaze-port 10041] [--http-port 80]" << std::endl;
+			std::cerr << "                [--stages 1,5,10,25] [--stage-seconds 30] [--heartbeats 3] [--timeout-ms 5000]" << std::endl;
+			std::cerr << "                [--prefix loginsim] [--no-register] [--no-game]" << std::endl;
+			return 1;
+		}
+	}
+
+	// TDF parse errors are counted per step, the log would only repeat them.
+	logger::set_level(logger::level::none);
+
+	boost::asio::ssl::context context(boost::asio::ssl::context::sslv3_client);
+	SetupContext(context);
+
+	const uint32_t users = *std::max_element(options.stages.begin(), options.stages.end());
+	if (options.registerUsers) {
+		RegisterUsers(options, users);
+	}
+
+	// Every virtual user has its own account, two sessions of one account would serialize on the user lock.
+	for (uint32_t concurrency : options.stages) {
+		std::vector<Stats> workerStats(concurrency);
+		std::vector<std::thread> workers;
+		workers.reserve(concurrency);
+
+		const auto start = Clock::now();
+		const auto deadline = start + std::chrono::seconds(options.stageSeconds);
+		for (uint32_t i = 0; i < concurrency; ++i) {
+			workers.emplace_back([&, i] {
+				auto& stats = workerStats[i];
+				while (Clock::now() < deadline) {
+					Session session(options, context, stats, i);
+					if (session.run()) {
+						stats.sessions++;
+					} else {
+						stats.failedSessions++;
+					}
+				}
+			});
+		}
+
+		for (auto& worker : workers) {
+			worker.join();
+		}
+
+		Stats stats;
+		for (const auto& workerStat : workerStats) {
+			stats.merge(workerStat);
+		}
+		PrintStage(concurrency, std::chrono::duration<double>(Clock::now() - start).count(), stats);
+	}
+	return 0;
+}
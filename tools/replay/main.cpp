@@ -0,0 +1,311 @@
+
+// Include
+#include "raknet/server.h"
+#include "raknet/recorder.h"
+
+#include <MessageIdentifiers.h>
+#include <RakNetworkFactory.h>
+#include <RakPeerInterface.h>
+#include <RakSleep.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+/*
+	Replays a session recorded by RakNet::SessionRecorder into a local RakNet::Server.
+
+	replay <file.rrec> [--port 3659] [--fast] [--quiet-ms 100] [--drain-ms 1000]
+
+	Every recorded peer gets its own loopback client. By default messages are sent with their
+	recorded timing, --fast sends the next message as soon as the previous one was answered
+	(or nothing came back for --quiet-ms).
+*/
+
+namespace {
+	using Clock = std::chrono::steady_clock;
+
+	struct Record {
+		uint64_t time;
+		uint64_t peer;
+		std::vector<uint8_t> data;
+	};
+
+	struct Peer {
+		RakPeerInterface* self = nullptr;
+		SystemAddress server;
+
+		// Index into the sent list of the message responses are currently attributed to.
+		size_t current = std::numeric_limits<size_t>::max();
+	};
+
+	struct Sent {
+		uint8_t id;
+		Clock::time_point time;
+		bool answered = false;
+	};
+
+	struct Report {
+		uint64_t count = 0;
+		uint64_t answered = 0;
+		uint64_t bytes = 0;
+		std::vector<double> latencies;
+	};
+
+	uint8_t GetMessageId(const std::vector<uint8_t>& data) {
+		if (data.empty()) {
+			return 0xFF;
+		}
+
+		// Skip the RakNet timestamp prefix if the client sent one.
+		constexpr size_t timestampSize = sizeof(MessageID) + sizeof(RakNetTime);
+		if (data[0] == ID_TIMESTAMP && data.size() > timestampSize) {
+			return data[timestampSize];
+		}
+		return data[0];
+	}
+
+	double Percentile(std::vector<double>& values, double percentile) {
+		if (values.empty()) {
+			return 0;
+		}
+
+		size_t index = static_cast<size_t>(percentile * (values.size() - 1) + 0.5);
+		std::nth_element(values.begin(), values.begin() + index, values.end());
+		return values[index];
+	}
+
+	bool ReadRecording(const std::string& path, uint32_t& gameId, std::vector<Record>& records) {
+		std::ifstream file(path, std::ios::binary);
+		if (!file.is_open()) {
+			std::cerr << "Could not open " << path << std::endl;
+			return false;
+		}
+
+		RakNet::Recording::FileHeader fileHeader;
+		file.read(reinterpret_cast<char*>(&fileHeader), sizeof(fileHeader));
+		if (!file || fileHeader.magic != RakNet::Recording::Magic || fileHeader.version != RakNet::Recording::Version) {
+			std::cerr << path << " is not a session recording" << std::endl;
+			return false;
+		}
+
+		gameId = fileHeader.gameId;
+
+		RakNet::Recording::RecordHeader header;
+		while (file.read(reinterpret_cast<char*>(&header), sizeof(header))) {
+			Record record;
+			record.time = header.time;
+			record.peer = (static_cast<uint64_t>(header.address) << 16) | header.port;
+			record.data.resize(header.length);
+			if (!file.read(reinterpret_cast<char*>(record.data.data()), record.data.size())) {
+				std::cerr << "Recording is truncated after " << records.size() << " records" << std::endl;
+				break;
+			}
+			records.push_back(std::move(record));
+		}
+		return true;
+	}
+
+	bool ConnectPeer(Peer& peer, uint16_t port) {
+		peer.self = RakNetworkFactory::GetRakPeerInterface();
+
+		SocketDescriptor descriptor(0, nullptr);
+		if (!peer.self->Startup(1, 0, &descriptor, 1)) {
+			return false;
+		}
+
+		if (!peer.self->Connect("127.0.0.1", port, nullptr, 0)) {
+			return false;
+		}
+
+		const auto deadline = Clock::now() + std::chrono::seconds(5);
+		while (Clock::now() < deadline) {
+			for (Packet* packet = peer.self->Receive(); packet; peer.self->DeallocatePacket(packet), packet = peer.self->Receive()) {
+				switch (packet->data[0]) {
+					case ID_CONNECTION_REQUEST_ACCEPTED:
+						peer.server = packet->systemAddress;
+						peer.self->DeallocatePacket(packet);
+						return true;
+
+					case ID_CONNECTION_ATTEMPT_FAILED:
+					case ID_NO_FREE_INCOMING_CONNECTIONS:
+						peer.self->DeallocatePacket(packet);
+						return false;
+
+					default:
+						break;
+				}
+			}
+			RakSleep(1);
+		}
+		return false;
+	}
+
+	// Returns true if any game message arrived.
+	bool Poll(std::vector<Peer>& peers, std::vector<Sent>& sent, std::map<uint8_t, Report>& reports) {
+		bool received = false;
+		for (auto& peer : peers) {
+			for (Packet* packet = peer.self->Receive(); packet; peer.self->DeallocatePacket(packet), packet = peer.self->Receive()) {
+				if (packet->data[0] < ID_USER_PACKET_ENUM || peer.current >= sent.size()) {
+					continue;
+				}
+
+				auto& message = sent[peer.current];
+				auto& report = reports[message.id];
+				report.bytes += packet->length;
+
+				if (!message.answered) {
+					message.answered = true;
+					report.answered++;
+					report.latencies.push_back(std::chrono::duration<double, std::milli>(Clock::now() - message.time).count());
+				}
+				received = true;
+			}
+		}
+		return received;
+	}
+}
+
+// main
+int main(int argc, char* argv[]) {
+	if (argc < 2) {
+		std::cerr << "usage: replay <file.rrec> [--port 3659] [--fast] [--quiet-ms 100] [--drain-ms 1000]" << std::endl;
+		return 1;
+	}
+
+	uint16_t port = 3659;
+	bool fast = false;
+	uint32_t quietMs = 100;
+	uint32_t drainMs = 1000;
+	for (int i = 2; i < argc; ++i) {
+		if (std::strcmp(argv[i], "--fast") == 0) {
+			fast = true;
+		} else if (std::strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
+			port = static_cast<uint16_t>(std::stoul(argv[++i]));
+		} else if (std::strcmp(argv[i], "--quiet-ms") == 0 && i + 1 < argc) {
+			quietMs = std::stoul(argv[++i]);
+		} else if (std::strcmp(argv[i], "--drain-ms") == 0 && i + 1 < argc) {
+			drainMs = std::stoul(argv[++i]);
+		}
+	}
+
+	uint32_t gameId;
+	std::vector<Record> records;
+	if (!ReadRecording(argv[1], gameId, records)) {
+		return 1;
+	}
+
+	if (records.empty()) {
+		std::cerr << "Recording is empty" << std::endl;
+		return 1;
+	}
+
+	auto server = std::make_unique<RakNet::Server>(port, gameId);
+
+	// One loopback client per recorded peer
+	std::map<uint64_t, size_t> peerIndices;
+	for (const auto& record : records) {
+		peerIndices.emplace(record.peer, peerIndices.size());
+	}
+
+	std::vector<Peer> peers(peerIndices.size());
+	for (auto& peer : peers) {
+		if (!ConnectPeer(peer, port)) {
+			std::cerr << "Could not connect to the game server on port " << port << std::endl;
+			return 1;
+		}
+	}
+
+	std::vector<Sent> sent;
+	sent.reserve(records.size());
+
+	std::map<uint8_t, Report> reports;
+
+	// Connection handshake traffic is not part of the replay.
+	Poll(peers, sent, reports);
+
+	const auto start = Clock::now();
+	for (const auto& record : records) {
+		auto& peer = peers[peerIndices[record.peer]];
+		if (fast) {
+			if (!sent.empty()) {
+				const auto quietDeadline = Clock::now() + std::chrono::milliseconds(quietMs);
+				while (!sent.back().answered && Clock::now() < quietDeadline) {
+					if (!Poll(peers, sent, reports)) {
+						RakSleep(0);
+					}
+				}
+			}
+		} else {
+			const auto due = start + std::chrono::microseconds(record.time);
+			while (Clock::now() < due) {
+				if (!Poll(peers, sent, reports)) {
+					RakSleep(1);
+				}
+			}
+		}
+
+		Sent message;
+		message.id = GetMessageId(record.data);
+		message.time = Clock::now();
+
+		peer.current = sent.size();
+		sent.push_back(message);
+		reports[message.id].count++;
+
+		peer.self->Send(reinterpret_cast<const char*>(record.data.data()), static_cast<int>(record.data.size()), HIGH_PRIORITY, RELIABLE_ORDERED, 0, peer.server, false);
+	}
+
+	const auto drainDeadline = Clock::now() + std::chrono::milliseconds(drainMs);
+	while (Clock::now() < drainDeadline) {
+		if (!Poll(peers, sent, reports)) {
+			RakSleep(1);
+		}
+	}
+
+	const double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+
+	for (auto& peer : peers) {
+		peer.self->Shutdown(100);
+		RakNetworkFactory::DestroyRakPeerInterface(peer.self);
+	}
+
+	server->stop();
+
+	// Report
+	const auto& stats = server->get_message_stats();
+
+	std::printf("%zu messages from %zu peers in %.3fs (%s)\n", records.size(), peers.size(), elapsed, fast ? "fast" : "real time");
+	std::printf("%-6s %8s %8s %12s %12s %10s %10s %10s %12s\n", "id", "sent", "answered", "handle avg", "handle max", "rtt p50", "rtt p99", "rtt max", "bytes back");
+
+	uint64_t totalBytes = 0;
+	for (auto& [id, report] : reports) {
+		const auto& stat = stats[id];
+		const double handleAvg = stat.count ? stat.totalNanoseconds / 1000.0 / stat.count : 0.0;
+		const double handleMax = stat.maxNanoseconds / 1000.0;
+
+		const double p50 = Percentile(report.latencies, 0.50);
+		const double p99 = Percentile(report.latencies, 0.99);
+		const double max = report.latencies.empty() ? 0.0 : *std::max_element(report.latencies.begin(), report.latencies.end());
+
+		std::printf("0x%02X   %8llu %8llu %10.1fus %10.1fus %8.2fms %8.2fms %8.2fms %12llu\n",
+			id,
+			static_cast<unsigned long long>(report.count),
+			static_cast<unsigned long long>(report.answered),
+			handleAvg, handleMax, p50, p99, max,
+			static_cast<unsigned long long>(report.bytes));
+
+		totalBytes += report.bytes;
+	}
+
+	std::printf("bytes sent by server: %llu\n", static_cast<unsigned long long>(totalBytes));
+	return 0;
+}